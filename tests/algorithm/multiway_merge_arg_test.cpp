@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * tests/algorithm/multiway_merge_arg_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/algorithm/multiway_merge_arg.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+//! large record, which is merged only by reference
+struct Record {
+    unsigned key;
+    size_t id;
+    char payload[184];
+};
+
+using Iterator = std::vector<Record>::iterator;
+
+struct RecordKey {
+    unsigned operator () (const Record& r) const { return r.key; }
+};
+
+template <bool Parallel, bool Permutation>
+static void test_records(size_t num_seqs, unsigned max_key,
+                         size_t num_threads = 4,
+                         tlx::MultiwayMergeSplittingAlgorithm mwmsa =
+                             tlx::MWMSA_DEFAULT) {
+    std::mt19937 rng(123456 + num_seqs);
+
+    std::vector<std::vector<Record> > vecs(num_seqs);
+    std::vector<Record> all;
+    size_t id = 0;
+    for (size_t s = 0; s < num_seqs; ++s) {
+        vecs[s].resize(rng() % 500);
+        for (Record& r : vecs[s])
+            r.key = rng() % max_key;
+        std::stable_sort(vecs[s].begin(), vecs[s].end(),
+                         [](const Record& a, const Record& b) {
+                             return a.key < b.key;
+                         });
+        for (Record& r : vecs[s])
+            r.id = id++;
+        all.insert(all.end(), vecs[s].begin(), vecs[s].end());
+    }
+
+    // concatenation order equals id order, stable merge keeps it for ties
+    std::vector<Record> correct = all;
+    std::stable_sort(correct.begin(), correct.end(),
+                     [](const Record& a, const Record& b) {
+                         return a.key < b.key;
+                     });
+
+    std::vector<std::pair<Iterator, Iterator> > seqs;
+    for (size_t s = 0; s < num_seqs; ++s)
+        seqs.emplace_back(vecs[s].begin(), vecs[s].end());
+
+    // gather the records using the output positions
+    std::vector<Record> output;
+    if (Permutation) {
+        std::vector<size_t> perm(all.size());
+        if (Parallel) {
+            tlx::parallel_multiway_merge_permutation(
+                seqs.begin(), seqs.end(), perm.begin(), all.size(),
+                RecordKey(), std::less<unsigned>(), mwmsa, num_threads);
+        }
+        else {
+            tlx::multiway_merge_permutation(
+                seqs.begin(), seqs.end(), perm.begin(), all.size(),
+                RecordKey());
+        }
+        for (size_t i : perm)
+            output.push_back(all[i]);
+    }
+    else {
+        std::vector<std::pair<size_t, size_t> > args(all.size());
+        if (Parallel) {
+            tlx::parallel_multiway_merge_arg(
+                seqs.begin(), seqs.end(), args.begin(), all.size(),
+                RecordKey(), std::less<unsigned>(), mwmsa, num_threads);
+        }
+        else {
+            tlx::multiway_merge_arg(
+                seqs.begin(), seqs.end(), args.begin(), all.size(),
+                RecordKey());
+        }
+        for (const std::pair<size_t, size_t>& a : args)
+            output.push_back(vecs[a.first][a.second]);
+    }
+
+    die_unequal(correct.size(), output.size());
+    for (size_t i = 0; i < output.size(); ++i)
+        die_unequal(correct[i].id, output[i].id);
+
+    for (size_t s = 0; s < num_seqs; ++s)
+        die_unless(seqs[s].first == seqs[s].second);
+}
+
+//! merge strings by their length, with a custom comparator on the key
+static void test_partial() {
+    std::vector<std::string> a = { "ab", "abcd" }, b = { "a", "abc", "xyz" };
+    using StrIterator = std::vector<std::string>::iterator;
+    std::vector<std::pair<StrIterator, StrIterator> > seqs = {
+        { a.begin(), a.end() }, { b.begin(), b.end() }
+    };
+
+    std::vector<std::pair<size_t, size_t> > args(3);
+    auto end = tlx::multiway_merge_arg(
+        seqs.begin(), seqs.end(), args.begin(), 3,
+        [](const std::string& s) { return s.size(); });
+    die_unless(end == args.end());
+
+    die_unless(args[0] == std::make_pair(size_t(1), size_t(0)));
+    die_unless(args[1] == std::make_pair(size_t(0), size_t(0)));
+    die_unless(args[2] == std::make_pair(size_t(1), size_t(1)));
+
+    // the sequences were advanced past the merged items
+    die_unless(seqs[0].first == a.begin() + 1);
+    die_unless(seqs[1].first == b.begin() + 2);
+
+    // indexes are relative to the current sequence begins
+    auto end2 = tlx::multiway_merge_arg(
+        seqs.begin(), seqs.end(), args.begin(), 3,
+        [](const std::string& s) { return s.size(); });
+    die_unless(end2 == args.begin() + 2);
+    die_unless(args[0] == std::make_pair(size_t(1), size_t(0)));
+    die_unless(args[1] == std::make_pair(size_t(0), size_t(0)));
+}
+
+int main() {
+    test_partial();
+
+    for (size_t k : { 0, 1, 2, 5, 33 }) {
+        test_records<false, false>(k, 100);
+        test_records<false, true>(k, 1000000);
+    }
+
+    tlx::parallel_multiway_merge_force_parallel = true;
+    for (size_t k : { 1, 2, 5, 33 }) {
+        for (size_t p : { 1, 3, 8 }) {
+            test_records<true, false>(k, 10, p);
+            test_records<true, true>(k, 1000000, p);
+            test_records<true, true>(k, 1000, p, tlx::MWMSA_SAMPLING);
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
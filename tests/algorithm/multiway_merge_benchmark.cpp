@@ -67,6 +67,7 @@ struct DataStruct {
 
 enum benchmark_type {
     SEQ_MWM_LT,
+    SEQ_MWM_LT_COPY,
     SEQ_MWM_LT_STABLE,
     SEQ_MWM_LT_COMBINED,
     SEQ_MWM_BB,
@@ -208,6 +209,17 @@ void test_multiway_merge(size_t seq_count, const size_t seq_size) {
                     tlx::MWMA_LOSER_TREE);
                 break;
 
+            case SEQ_MWM_LT_COPY:
+                // LoserTree selects LoserTreeIntegral for integral keys, this
+                // runs the generic LoserTreeCopy for comparison.
+                method_name = "seq_mwm_lt_copy";
+
+                tlx::multiway_merge_detail::multiway_merge_loser_tree<
+                    tlx::LoserTreeCopy<false, ValueType, std::less<ValueType> > >(
+                    iterpairs.begin(), iterpairs.end(),
+                    out.begin(), total_size, cmp);
+                break;
+
             case SEQ_MWM_LT_COMBINED:
                 method_name = "seq_mwm_lt_combined";
 
@@ -373,6 +385,7 @@ void test_seqnum(const size_t seq_size = 2* 1024* 1024) {
 template <typename ValueType>
 void test_seqnum_sequential() {
     test_seqnum<ValueType, SEQ_MWM_LT>();
+    test_seqnum<ValueType, SEQ_MWM_LT_COPY>();
     test_seqnum<ValueType, SEQ_MWM_LT_STABLE>();
     test_seqnum<ValueType, SEQ_MWM_LT_COMBINED>();
     test_seqnum<ValueType, SEQ_MWM_BB>();
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * tests/algorithm/multiway_merge_combine_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/algorithm/multiway_merge_combine.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using Pair = std::pair<unsigned, unsigned>;
+using Iterator = std::vector<Pair>::iterator;
+
+struct KeyLess {
+    bool operator () (const Pair& a, const Pair& b) const {
+        return a.first < b.first;
+    }
+};
+
+//! order-dependent combine, which checks that groups are folded in the order
+//! of the sequences.
+struct HashCombine {
+    Pair operator () (const Pair& a, const Pair& b) const {
+        return Pair(a.first, a.second * 31 + b.second);
+    }
+};
+
+static void test_simple() {
+    std::vector<int> a = { 1, 1, 2 }, b = { 1, 3 }, c = { };
+    std::vector<std::pair<std::vector<int>::iterator,
+                          std::vector<int>::iterator> > seqs = {
+        { a.begin(), a.end() }, { b.begin(), b.end() }, { c.begin(), c.end() }
+    };
+
+    std::vector<int> out;
+    tlx::multiway_merge_combine(
+        seqs.begin(), seqs.end(), std::back_inserter(out));
+
+    die_unless(out == std::vector<int>({ 3, 2, 3 }));
+    die_unless(seqs[0].first == seqs[0].second);
+    die_unless(seqs[1].first == seqs[1].second);
+}
+
+template <bool Parallel>
+static void test_random(size_t num_seqs, unsigned max_key, size_t num_threads) {
+    std::mt19937 rng(123456 + num_seqs);
+
+    std::vector<std::vector<Pair> > vecs(num_seqs);
+    std::vector<Pair> all;
+    for (size_t s = 0; s < num_seqs; ++s) {
+        vecs[s].resize(rng() % 1000);
+        for (Pair& p : vecs[s])
+            p = Pair(rng() % max_key, rng() % 1000);
+        std::stable_sort(vecs[s].begin(), vecs[s].end(), KeyLess());
+        all.insert(all.end(), vecs[s].begin(), vecs[s].end());
+    }
+
+    // fold groups in the order of the sequences
+    std::stable_sort(all.begin(), all.end(), KeyLess());
+    std::vector<Pair> correct;
+    for (const Pair& p : all) {
+        if (!correct.empty() && correct.back().first == p.first)
+            correct.back() = HashCombine()(correct.back(), p);
+        else
+            correct.push_back(p);
+    }
+
+    std::vector<std::pair<Iterator, Iterator> > seqs;
+    for (size_t s = 0; s < num_seqs; ++s)
+        seqs.emplace_back(vecs[s].begin(), vecs[s].end());
+
+    std::vector<Pair> out(all.size());
+    Iterator end;
+    if (Parallel) {
+        end = tlx::parallel_multiway_merge_combine(
+            seqs.begin(), seqs.end(), out.begin(),
+            KeyLess(), HashCombine(), num_threads);
+    }
+    else {
+        end = tlx::multiway_merge_combine(
+            seqs.begin(), seqs.end(), out.begin(),
+            KeyLess(), HashCombine());
+    }
+    out.resize(end - out.begin());
+
+    die_unequal(correct.size(), out.size());
+    die_unless(out == correct);
+
+    for (size_t s = 0; s < num_seqs; ++s)
+        die_unless(seqs[s].first == seqs[s].second);
+}
+
+int main() {
+    test_simple();
+
+    for (size_t k : { 0, 1, 2, 5, 17 }) {
+        test_random<false>(k, 10, 0);
+        test_random<false>(k, 1000, 0);
+    }
+
+    tlx::parallel_multiway_merge_force_parallel = true;
+    for (size_t k : { 1, 2, 5, 17 }) {
+        for (size_t p : { 1, 3, 8 }) {
+            // few keys with large groups straddling the initial split points
+            test_random<true>(k, 3, p);
+            test_random<true>(k, 50, p);
+            test_random<true>(k, 100000, p);
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * tests/algorithm/multiway_merge_stream_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/algorithm/multiway_merge_stream.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+//! a sorted sequence generated on the fly, like a run read from disk
+class GeneratorSource
+{
+public:
+    GeneratorSource(size_t id, size_t size) : id_(id), size_(size) { }
+
+    size_t operator () (size_t* buffer, size_t n) {
+        // return smaller blocks than requested, sometimes
+        if (n > 3 && pos_ % 3 == 0) n = 3;
+        size_t i = 0;
+        for ( ; i < n && pos_ < size_; ++i, ++pos_)
+            buffer[i] = pos_ * 7 + id_;
+        ++calls_;
+        return i;
+    }
+
+    size_t calls() const { return calls_; }
+
+private:
+    size_t id_, size_, pos_ = 0, calls_ = 0;
+};
+
+static void test_generators(size_t k, size_t block_size) {
+    tlx::MultiwayMergeStream<size_t> mms(block_size);
+
+    std::vector<GeneratorSource> gens;
+    gens.reserve(k);
+    size_t total = 0;
+    for (size_t i = 0; i < k; ++i) {
+        gens.emplace_back(i % 7, i * 13 % 50);
+        total += i * 13 % 50;
+    }
+    for (size_t i = 0; i < k; ++i) {
+        GeneratorSource* g = &gens[i];
+        mms.add_source(
+            [g](size_t* buffer, size_t n) { return (*g)(buffer, n); });
+    }
+    die_unequal(k, mms.num_sources());
+
+    std::vector<size_t> out;
+    size_t max_block = 0;
+    size_t n = mms.merge_blocks(
+        [&](const size_t* data, size_t size) {
+            max_block = std::max(max_block, size);
+            out.insert(out.end(), data, data + size);
+        });
+
+    die_unequal(total, n);
+    die_unequal(total, out.size());
+    die_unless(max_block <= block_size);
+    die_unless(std::is_sorted(out.begin(), out.end()));
+    die_unless(mms.empty());
+}
+
+static void test_iterators() {
+    std::default_random_engine rng(1234);
+    std::vector<std::vector<std::string> > runs(20);
+    std::vector<std::string> all;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        for (size_t j = 0; j < 100 + i; ++j)
+            runs[i].push_back(std::to_string(rng() % 1000));
+        std::sort(runs[i].begin(), runs[i].end());
+        all.insert(all.end(), runs[i].begin(), runs[i].end());
+    }
+    std::sort(all.begin(), all.end());
+
+    // pull interface with odd read sizes
+    tlx::MultiwayMergeStream<std::string> mms(16);
+    for (size_t i = 0; i < runs.size(); ++i)
+        mms.add_source(runs[i].begin(), runs[i].end());
+
+    std::vector<std::string> out;
+    std::vector<std::string> buf(37);
+    while (size_t n = mms.read(buf.begin(), buf.size()))
+        out.insert(out.end(), buf.begin(), buf.begin() + n);
+    die_unless(out == all);
+    die_unequal(0u, mms.read(buf.begin(), buf.size()));
+
+    // merge into an output iterator
+    tlx::MultiwayMergeStream<std::string, std::greater<std::string> > rev(5);
+    for (size_t i = 0; i < runs.size(); ++i)
+        rev.add_source(runs[i].rbegin(), runs[i].rend());
+    out.clear();
+    rev.merge(std::back_inserter(out));
+    std::reverse(all.begin(), all.end());
+    die_unless(out == all);
+
+    // no sources
+    tlx::MultiwayMergeStream<std::string> none;
+    die_unless(none.empty());
+    die_unequal(0u, none.merge_blocks([](const std::string*, size_t) { }));
+}
+
+static void test_stable() {
+    using Item = std::pair<unsigned, unsigned>;
+    struct Compare {
+        bool operator () (const Item& a, const Item& b) const {
+            return a.first < b.first;
+        }
+    };
+
+    std::vector<std::vector<Item> > runs(9);
+    std::vector<Item> all;
+    for (unsigned i = 0; i < runs.size(); ++i) {
+        for (unsigned j = 0; j < 50; ++j)
+            runs[i].emplace_back(j / 5, i);
+        all.insert(all.end(), runs[i].begin(), runs[i].end());
+    }
+    std::stable_sort(all.begin(), all.end(), Compare());
+
+    tlx::MultiwayMergeStream<Item, Compare, /* Stable */ true> mms(4);
+    for (size_t i = 0; i < runs.size(); ++i)
+        mms.add_source(runs[i].begin(), runs[i].end());
+    std::vector<Item> out;
+    mms.merge(std::back_inserter(out));
+    die_unless(out == all);
+}
+
+int main() {
+    test_generators(1, 4);
+    test_generators(5, 1);
+    test_generators(17, 8);
+    test_generators(100, 1000);
+    test_iterators();
+    test_stable();
+
+    return 0;
+}
+
+/******************************************************************************/
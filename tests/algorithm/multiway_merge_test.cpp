@@ -16,6 +16,7 @@
 
 #include <tlx/algorithm/multiway_merge.hpp>
 #include <tlx/algorithm/parallel_multiway_merge.hpp>
+#include <tlx/thread_pool.hpp>
 
 struct Something {
     unsigned int a, b;
@@ -193,7 +194,63 @@ void test_all(const tlx::MultiwayMergeAlgorithm& mwma) {
     }
 }
 
+//! run many parallel merges on one shared ThreadPool
+template <bool Stable>
+void test_pool(tlx::ThreadPool& pool,
+               const tlx::MultiwayMergeSplittingAlgorithm& mwmsa) {
+    tlx::parallel_multiway_merge_force_parallel = true;
+
+    std::mt19937 randgen(654321);
+
+    for (unsigned int round = 0; round < 100; ++round)
+    {
+        unsigned int vecnum = round % 17;
+        std::vector<std::vector<Something> > vec(vecnum);
+        std::vector<Something> correct;
+
+        for (size_t i = 0; i < vecnum; ++i)
+        {
+            vec[i].resize(randgen() % 200);
+            for (Something& s : vec[i])
+                s = Something(randgen() % (round + 1));
+            std::sort(vec[i].begin(), vec[i].end());
+            correct.insert(correct.end(), vec[i].begin(), vec[i].end());
+        }
+        std::stable_sort(correct.begin(), correct.end());
+
+        using input_iterator = std::vector<Something>::iterator;
+        std::vector<std::pair<input_iterator, input_iterator> > sequences;
+        for (size_t i = 0; i < vecnum; ++i)
+            sequences.emplace_back(vec[i].begin(), vec[i].end());
+
+        std::vector<Something> output(correct.size());
+        if (!Stable)
+            tlx::parallel_multiway_merge(
+                sequences.begin(), sequences.end(),
+                output.begin(), correct.size(),
+                std::less<Something>(), pool, tlx::MWMA_LOSER_TREE, mwmsa);
+        else
+            tlx::stable_parallel_multiway_merge(
+                sequences.begin(), sequences.end(),
+                output.begin(), correct.size(),
+                std::less<Something>(), pool, tlx::MWMA_LOSER_TREE, mwmsa);
+
+        // Something::operator == also compares b, which orders equal keys
+        if (Stable)
+            die_unless(output == correct);
+        else
+            die_unless(std::is_sorted(output.begin(), output.end()));
+    }
+}
+
 int main() {
+    {
+        tlx::ThreadPool pool(4);
+        test_pool</* Stable */ false>(pool, tlx::MWMSA_EXACT);
+        test_pool</* Stable */ true>(pool, tlx::MWMSA_EXACT);
+        test_pool</* Stable */ false>(pool, tlx::MWMSA_SAMPLING);
+    }
+
     test_all(tlx::MWMA_BUBBLE);
     test_all(tlx::MWMA_LOSER_TREE);
     test_all(tlx::MWMA_LOSER_TREE_COMBINED);
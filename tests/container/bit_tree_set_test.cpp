@@ -0,0 +1,135 @@
+/*******************************************************************************
+ * tests/container/bit_tree_set_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <iterator>
+#include <random>
+#include <set>
+
+#include <tlx/container/bit_tree_set.hpp>
+#include <tlx/die.hpp>
+
+using tlx::BitTreeSet;
+
+// compare all queries of BitTreeSet against std::set
+static void check_queries(const BitTreeSet& bs, const std::set<size_t>& ref,
+                          size_t x) {
+    die_unequal(ref.count(x) != 0, bs.contains(x));
+
+    auto it = ref.upper_bound(x);
+    die_unequal(it == ref.end() ? BitTreeSet::npos : *it, bs.successor(x));
+
+    it = ref.lower_bound(x);
+    die_unequal(it == ref.end() ? BitTreeSet::npos : *it, bs.find_next(x));
+    die_unequal(static_cast<size_t>(std::distance(ref.begin(), it)),
+                bs.rank(x));
+
+    die_unequal(it == ref.begin() ? BitTreeSet::npos : *std::prev(it),
+                bs.predecessor(x));
+
+    it = ref.upper_bound(x);
+    die_unequal(it == ref.begin() ? BitTreeSet::npos : *std::prev(it),
+                bs.find_prev(x));
+}
+
+static void test_random(size_t universe, size_t operations) {
+    std::mt19937 rng(universe);
+    std::uniform_int_distribution<size_t> dist(0, universe - 1);
+
+    BitTreeSet bs(universe);
+    std::set<size_t> ref;
+
+    die_unless(bs.empty());
+    die_unequal(BitTreeSet::npos, bs.min());
+    die_unequal(BitTreeSet::npos, bs.max());
+
+    for (size_t i = 0; i < operations; ++i) {
+        size_t x = dist(rng);
+        // bias towards insertions in the first half
+        if (rng() % 3 != 0 || (i < operations / 2 && rng() % 2 == 0))
+            die_unequal(ref.insert(x).second, bs.insert(x));
+        else
+            die_unequal(ref.erase(x) != 0, bs.erase(x));
+
+        die_unequal(ref.size(), bs.size());
+        die_unequal(ref.empty() ? BitTreeSet::npos : *ref.begin(), bs.min());
+        die_unequal(ref.empty() ? BitTreeSet::npos : *ref.rbegin(), bs.max());
+
+        check_queries(bs, ref, dist(rng));
+    }
+
+    // iterate forward and backward
+    size_t x = bs.min();
+    for (auto it = ref.begin(); it != ref.end(); ++it) {
+        die_unequal(*it, x);
+        x = bs.successor(x);
+    }
+    die_unequal(BitTreeSet::npos, x);
+
+    x = bs.max();
+    for (auto it = ref.rbegin(); it != ref.rend(); ++it) {
+        die_unequal(*it, x);
+        x = bs.predecessor(x);
+    }
+    die_unequal(BitTreeSet::npos, x);
+
+    // erase everything
+    for (const size_t& y : ref)
+        die_unless(bs.erase(y));
+    die_unless(bs.empty());
+    die_unequal(BitTreeSet::npos, bs.min());
+    die_unequal(BitTreeSet::npos, bs.find_prev(universe - 1));
+
+    // refill and clear
+    for (size_t i = 0; i < universe; i += 1 + i / 3)
+        bs.insert(i);
+    bs.clear();
+    die_unless(bs.empty());
+    die_unequal(BitTreeSet::npos, bs.find_next(0));
+}
+
+static void test_boundaries() {
+    // universe sizes around the level boundaries
+    for (size_t universe : { 1, 2, 63, 64, 65, 4095, 4096, 4097, 262145 }) {
+        BitTreeSet bs(universe);
+        die_unequal(universe, bs.universe());
+
+        bs.insert(universe - 1);
+        die_unequal(universe - 1, bs.min());
+        die_unequal(universe - 1, bs.max());
+        die_unequal(universe - 1, bs.find_next(0));
+        die_unequal(BitTreeSet::npos, bs.successor(universe - 1));
+        die_unequal(BitTreeSet::npos, bs.successor(universe));
+        die_unequal(BitTreeSet::npos, bs.successor(BitTreeSet::npos));
+
+        bs.insert(0);
+        die_unequal(0u, bs.min());
+        die_unequal(BitTreeSet::npos, bs.predecessor(0));
+        die_unequal(universe - 1, bs.predecessor(BitTreeSet::npos));
+        if (universe > 1) {
+            die_unequal(0u, bs.predecessor(universe - 1));
+            die_unequal(universe - 1, bs.successor(0));
+        }
+    }
+}
+
+int main() {
+    test_boundaries();
+
+    test_random(1, 100);
+    test_random(64, 1000);
+    test_random(100, 1000);
+    test_random(5000, 10000);
+    test_random(300000, 20000);
+    test_random(5000000, 2000);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * tests/container/cache_policy_speedtest.cpp
+ *
+ * Trace replay of LRU, CLOCK, S3-FIFO, and ARC caches on synthetic Zipf and
+ * scan-mixed traces, reporting hit ratio and throughput.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tlx/container/arc_cache.hpp>
+#include <tlx/container/clock_cache.hpp>
+#include <tlx/container/flat_lru_cache.hpp>
+#include <tlx/container/lru_cache.hpp>
+#include <tlx/container/s3fifo_cache.hpp>
+#include <tlx/die.hpp>
+#include <tlx/timestamp.hpp>
+
+// *** Settings
+
+//! number of distinct keys in the Zipf distribution
+const size_t key_universe = 1000000;
+
+//! number of accesses per trace
+const size_t trace_length = 10000000;
+
+//! Zipf exponent
+const double zipf_alpha = 0.99;
+
+//! scan-mixed trace: every scan_period accesses, a scan of scan_length new keys
+const size_t scan_period = 100000;
+const size_t scan_length = 20000;
+
+// -----------------------------------------------------------------------------
+
+//! Generate a Zipf distributed trace by inverse transform sampling of the
+//! cumulative distribution. Ranks are shuffled over the key space.
+std::vector<size_t> make_zipf_trace(size_t n, unsigned seed) {
+    std::vector<double> cdf(key_universe);
+    double sum = 0;
+    for (size_t i = 0; i < key_universe; ++i) {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), zipf_alpha);
+        cdf[i] = sum;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::vector<size_t> perm(key_universe);
+    for (size_t i = 0; i < key_universe; ++i) perm[i] = i;
+    std::shuffle(perm.begin(), perm.end(), rng);
+
+    std::uniform_real_distribution<double> dist(0.0, sum);
+    std::vector<size_t> trace(n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t r = std::lower_bound(cdf.begin(), cdf.end(), dist(rng))
+                   - cdf.begin();
+        trace[i] = perm[std::min(r, key_universe - 1)];
+    }
+    return trace;
+}
+
+//! Interleave a Zipf trace with scans of keys that are never repeated.
+std::vector<size_t> make_scan_trace(size_t n, unsigned seed) {
+    std::vector<size_t> zipf = make_zipf_trace(n, seed);
+    std::vector<size_t> trace;
+    trace.reserve(n);
+    size_t next_scan_key = key_universe;
+    for (size_t i = 0; trace.size() < n; ++i) {
+        if (i % scan_period == 0 && i != 0) {
+            for (size_t j = 0; j < scan_length && trace.size() < n; ++j)
+                trace.push_back(next_scan_key++);
+        }
+        if (trace.size() < n)
+            trace.push_back(zipf[i]);
+    }
+    return trace;
+}
+
+template <typename Cache>
+void replay(const std::string& name, const std::string& trace_name,
+            size_t capacity, const std::vector<size_t>& trace) {
+    Cache cache(capacity);
+
+    double ts1 = tlx::timestamp();
+    size_t hits = 0, sum = 0;
+    for (const size_t& k : trace) {
+        if (const size_t* v = cache.find_touch(k)) {
+            sum += *v;
+            ++hits;
+        }
+        else {
+            cache.put(k, k);
+        }
+    }
+    double ts2 = tlx::timestamp();
+    die_unless(sum != 1);
+
+    std::cout << "RESULT"
+              << " cache=" << name
+              << " trace=" << trace_name
+              << " capacity=" << capacity
+              << " ops=" << trace.size()
+              << " hit_ratio=" << std::fixed << std::setprecision(4)
+              << static_cast<double>(hits) / static_cast<double>(trace.size())
+              << " time=" << std::setprecision(6) << (ts2 - ts1)
+              << " mops="
+              << static_cast<double>(trace.size()) / (ts2 - ts1) / 1e6
+              << std::endl;
+}
+
+void replay_all(const std::string& trace_name,
+                const std::vector<size_t>& trace) {
+    for (size_t capacity = key_universe / 1000; capacity <= key_universe / 10;
+         capacity *= 10) {
+        replay<tlx::LruCacheMap<size_t, size_t> >(
+            "LruCacheMap", trace_name, capacity, trace);
+        replay<tlx::FlatLruCacheMap<size_t, size_t> >(
+            "FlatLruCacheMap", trace_name, capacity, trace);
+        replay<tlx::ClockCacheMap<size_t, size_t> >(
+            "ClockCacheMap", trace_name, capacity, trace);
+        replay<tlx::S3FifoCacheMap<size_t, size_t> >(
+            "S3FifoCacheMap", trace_name, capacity, trace);
+        replay<tlx::ArcCacheMap<size_t, size_t> >(
+            "ArcCacheMap", trace_name, capacity, trace);
+    }
+}
+
+int main() {
+    replay_all("zipf", make_zipf_trace(trace_length, 1));
+    replay_all("scan", make_scan_trace(trace_length, 2));
+    return 0;
+}
+
+/******************************************************************************/
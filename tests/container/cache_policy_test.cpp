@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * tests/container/cache_policy_test.cpp
+ *
+ * Tests of the CLOCK, S3-FIFO, and ARC caches, which share the interface of
+ * LruCacheMap.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include <tlx/container/arc_cache.hpp>
+#include <tlx/container/clock_cache.hpp>
+#include <tlx/container/lru_cache.hpp>
+#include <tlx/container/s3fifo_cache.hpp>
+#include <tlx/die.hpp>
+
+namespace tlx {
+
+// instantiations
+template class tlx::ClockCacheMap<size_t, size_t>;
+template class tlx::S3FifoCacheMap<size_t, size_t>;
+template class tlx::ArcCacheMap<size_t, size_t>;
+
+} // namespace tlx
+
+/******************************************************************************/
+// Tests common to all policies
+
+template <typename Cache>
+static void test_simple_put() {
+    Cache cache(4);
+    cache.put(7, 777);
+    die_unless(cache.exists(7));
+    die_unequal(777u, cache.get(7));
+    die_unequal(1u, cache.size());
+    die_unequal(4u, cache.capacity());
+
+    cache.put(7, 778);
+    die_unequal(778u, cache.get_touch(7));
+    die_unequal(1u, cache.size());
+
+    die_unless(cache.find_touch(8) == nullptr);
+    die_unless_throws(cache.get(8), std::range_error);
+    die_unless_throws(cache.get_touch(8), std::range_error);
+    die_unless_throws(cache.touch(8), std::range_error);
+    die_unless_throws(cache.erase(8), std::range_error);
+    die_unless(!cache.touch_if_exists(8));
+    die_unless(!cache.erase_if_exists(8));
+
+    cache.erase(7);
+    die_unless(!cache.exists(7));
+    die_unequal(0u, cache.size());
+
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.clear();
+    die_unequal(0u, cache.size());
+    die_unless(!cache.exists(1));
+}
+
+template <typename Cache>
+static void test_capacity() {
+    Cache cache(16);
+    for (size_t i = 0; i < 100; ++i) {
+        cache.put(i, 2 * i);
+        die_unless(cache.size() <= 16);
+        die_unless(cache.exists(i));
+    }
+    die_unequal(16u, cache.size());
+
+    size_t found = 0;
+    for (size_t i = 0; i < 100; ++i) {
+        if (cache.exists(i)) {
+            die_unequal(2 * i, cache.get(i));
+            ++found;
+        }
+    }
+    die_unequal(16u, found);
+
+    // pop() empties the cache
+    for (size_t i = 0; i < 16; ++i) {
+        std::pair<size_t, size_t> p = cache.pop();
+        die_unequal(2 * p.first, p.second);
+        die_unless(!cache.exists(p.first));
+    }
+    die_unequal(0u, cache.size());
+}
+
+//! random operations against a map of the last put values
+template <typename Cache>
+static void test_random(size_t capacity) {
+    Cache cache(capacity);
+    std::map<size_t, size_t> values;
+    std::mt19937 rng(capacity);
+
+    for (size_t i = 0; i < 20000; ++i) {
+        size_t key = rng() % (4 * capacity);
+        size_t op = rng() % 8;
+        if (op < 3) {
+            cache.put(key, i);
+            values[key] = i;
+            die_unless(cache.exists(key));
+        }
+        else if (op < 7) {
+            const size_t* v = cache.find_touch(key);
+            die_unequal(cache.exists(key), v != nullptr);
+            if (v) die_unequal(values[key], *v);
+        }
+        else {
+            die_unequal(cache.exists(key), cache.erase_if_exists(key));
+            die_unless(!cache.exists(key));
+        }
+        die_unless(cache.size() <= capacity);
+    }
+
+    size_t found = 0;
+    for (size_t key = 0; key < 4 * capacity; ++key) {
+        if (!cache.exists(key)) continue;
+        die_unequal(values[key], cache.get(key));
+        ++found;
+    }
+    die_unequal(cache.size(), found);
+}
+
+//! a hot set which is hit repeatedly must survive a scan of new keys
+template <typename Cache>
+static void test_scan_resistance() {
+    Cache cache(100);
+    for (size_t r = 0; r < 4; ++r) {
+        for (size_t k = 0; k < 50; ++k) {
+            if (!cache.touch_if_exists(k))
+                cache.put(k, k);
+        }
+    }
+    for (size_t k = 1000; k < 1500; ++k)
+        cache.put(k, k);
+
+    size_t hot = 0;
+    for (size_t k = 0; k < 50; ++k)
+        hot += cache.exists(k);
+    die_unless(hot >= 45);
+}
+
+template <typename Cache>
+static void test_policy(bool scan_resistant = true) {
+    test_simple_put<Cache>();
+    test_capacity<Cache>();
+    test_random<Cache>(1);
+    test_random<Cache>(10);
+    test_random<Cache>(100);
+    if (scan_resistant)
+        test_scan_resistance<Cache>();
+}
+
+/******************************************************************************/
+// Policy specific tests
+
+static void test_lru_is_not_scan_resistant() {
+    tlx::LruCacheMap<size_t, size_t> cache(100);
+    for (size_t k = 0; k < 50; ++k)
+        cache.put(k, k);
+    for (size_t k = 1000; k < 1100; ++k)
+        cache.put(k, k);
+    for (size_t k = 0; k < 50; ++k)
+        die_unless(!cache.exists(k));
+}
+
+static void test_clock_second_chance() {
+    tlx::ClockCacheMap<size_t, size_t> cache(3);
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.put(3, 3);
+    cache.touch(1);
+
+    // 1 has a second chance, 2 is evicted
+    cache.put(4, 4);
+    die_unless(cache.exists(1));
+    die_unless(!cache.exists(2));
+
+    // the hand passed 1 and cleared its bit, 3 is evicted next
+    cache.put(5, 5);
+    die_unless(!cache.exists(3));
+    die_unequal(1u, cache.pop().first);
+}
+
+static void test_s3fifo_ghost() {
+    tlx::S3FifoCacheMap<size_t, std::string> cache(10);
+    for (size_t k = 0; k < 10; ++k)
+        cache.put(k, std::to_string(k));
+
+    // 0 is not hit and evicted from the small queue into the ghost queue
+    cache.put(10, "10");
+    die_unless(!cache.exists(0));
+
+    // on the next miss, 0 is inserted into the main queue and survives a scan
+    cache.put(0, "0");
+    for (size_t k = 100; k < 200; ++k)
+        cache.put(k, std::to_string(k));
+    die_unequal("0", cache.get(0));
+}
+
+static void test_arc_adaptation() {
+    tlx::ArcCacheMap<size_t, size_t> cache(10);
+    for (size_t k = 0; k < 10; ++k)
+        cache.put(k, k);
+    // hits move 5..9 from T1 to T2
+    for (size_t k = 5; k < 10; ++k)
+        cache.touch(k);
+    die_unequal(0u, cache.target_recent());
+
+    // evicts 0 from T1 into the ghost list B1
+    cache.put(10, 10);
+    die_unless(!cache.exists(0));
+
+    // a miss on a key in B1 grows the target size of T1
+    cache.put(0, 0);
+    die_unequal(1u, cache.target_recent());
+    die_unless(cache.exists(0));
+    die_unless(!cache.exists(1));
+    die_unequal(10u, cache.size());
+
+    // the pairs in T2 were not evicted
+    for (size_t k = 5; k < 10; ++k)
+        die_unless(cache.exists(k));
+}
+
+int main() {
+    test_policy<tlx::LruCacheMap<size_t, size_t> >(false);
+    test_policy<tlx::ClockCacheMap<size_t, size_t> >(false);
+    test_policy<tlx::S3FifoCacheMap<size_t, size_t> >();
+    test_policy<tlx::ArcCacheMap<size_t, size_t> >();
+
+    test_lru_is_not_scan_resistant();
+    test_clock_second_chance();
+    test_s3fifo_ghost();
+    test_arc_adaptation();
+
+    return 0;
+}
+
+/******************************************************************************/
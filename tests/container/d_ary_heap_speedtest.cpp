@@ -16,7 +16,9 @@
 
 #include <queue>
 #include <tlx/container/d_ary_addressable_int_heap.hpp>
+#include <tlx/container/d_ary_aligned_heap.hpp>
 #include <tlx/container/d_ary_heap.hpp>
+#include <tlx/container/sequence_heap.hpp>
 
 #include <tlx/die.hpp>
 #include <tlx/timestamp.hpp>
@@ -123,6 +125,23 @@ struct TestFactory_Heap {
     using DAryAIntHeap =
         TestClass<tlx::DAryAddressableIntHeap<uint32_t, Arity> >;
 
+    //! Test the d-ary heap with 64-bit keys
+    template <int Arity>
+    using DAryHeap64 = TestClass<tlx::DAryHeap<uint64_t, Arity> >;
+
+    //! Test the cache-aligned d-ary heap with a specific arity
+    template <int Arity>
+    using DAryAlignedHeap = TestClass<tlx::DAryAlignedHeap<uint32_t, Arity> >;
+
+    //! Test the cache-aligned d-ary heap with 64-bit keys
+    template <int Arity>
+    using DAryAlignedHeap64 =
+        TestClass<tlx::DAryAlignedHeap<uint64_t, Arity> >;
+
+    //! Test the sequence heap with a specific merge arity
+    template <int Arity>
+    using SequenceHeap = TestClass<tlx::SequenceHeap<uint32_t, Arity> >;
+
     //! Run tests on all heap types
     void call_testrunner(size_t items);
 };
@@ -191,6 +210,24 @@ void TestFactory_Heap<TestClass>::call_testrunner(size_t items) {
     testrunner_loop<DAryHeap<16> >(items, "tlx::DAryHeap<16> slots=16");
     testrunner_loop<DAryHeap<32> >(items, "tlx::DAryHeap<32> slots=32");
 
+    testrunner_loop<DAryAlignedHeap<4> >(
+        items, "tlx::DAryAlignedHeap<4> slots=4");
+    testrunner_loop<DAryAlignedHeap<8> >(
+        items, "tlx::DAryAlignedHeap<8> slots=8");
+    testrunner_loop<DAryAlignedHeap<16> >(
+        items, "tlx::DAryAlignedHeap<16> slots=16");
+
+    testrunner_loop<DAryHeap64<4> >(items, "tlx::DAryHeap64<4> slots=4");
+    testrunner_loop<DAryHeap64<8> >(items, "tlx::DAryHeap64<8> slots=8");
+    testrunner_loop<DAryHeap64<16> >(items, "tlx::DAryHeap64<16> slots=16");
+
+    testrunner_loop<DAryAlignedHeap64<4> >(
+        items, "tlx::DAryAlignedHeap64<4> slots=4");
+    testrunner_loop<DAryAlignedHeap64<8> >(
+        items, "tlx::DAryAlignedHeap64<8> slots=8");
+    testrunner_loop<DAryAlignedHeap64<16> >(
+        items, "tlx::DAryAlignedHeap64<16> slots=16");
+
     testrunner_loop<DAryAIntHeap<2> >(items, "tlx::DAryAIntHeap<2> slots=2");
     testrunner_loop<DAryAIntHeap<3> >(items, "tlx::DAryAIntHeap<3> slots=3");
     testrunner_loop<DAryAIntHeap<4> >(items, "tlx::DAryAIntHeap<4> slots=4");
@@ -198,6 +235,9 @@ void TestFactory_Heap<TestClass>::call_testrunner(size_t items) {
     testrunner_loop<DAryAIntHeap<8> >(items, "tlx::DAryAIntHeap<8> slots=8");
     testrunner_loop<DAryAIntHeap<16> >(items, "tlx::DAryAIntHeap<16> slots=16");
     testrunner_loop<DAryAIntHeap<32> >(items, "tlx::DAryAIntHeap<32> slots=32");
+
+    testrunner_loop<SequenceHeap<16> >(items, "tlx::SequenceHeap<16> slots=16");
+    testrunner_loop<SequenceHeap<64> >(items, "tlx::SequenceHeap<64> slots=64");
 }
 
 //! Speed test them!
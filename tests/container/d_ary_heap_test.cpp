@@ -11,9 +11,12 @@
 #include <algorithm>
 #include <random>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
+#include <tlx/container/d_ary_addressable_hash_heap.hpp>
 #include <tlx/container/d_ary_addressable_int_heap.hpp>
+#include <tlx/container/d_ary_aligned_heap.hpp>
 #include <tlx/container/d_ary_heap.hpp>
 #include <tlx/die.hpp>
 
@@ -30,6 +33,16 @@ template class DAryAddressableIntHeap<uint16_t>;
 template class DAryAddressableIntHeap<uint32_t>;
 template class DAryAddressableIntHeap<uint64_t>;
 
+template class DAryAddressableHashHeap<uint8_t>;
+template class DAryAddressableHashHeap<uint16_t>;
+template class DAryAddressableHashHeap<uint32_t>;
+template class DAryAddressableHashHeap<uint64_t>;
+
+template class DAryAlignedHeap<uint8_t>;
+template class DAryAlignedHeap<uint16_t>;
+template class DAryAlignedHeap<uint32_t>;
+template class DAryAlignedHeap<uint64_t>;
+
 } // namespace tlx
 
 /******************************************************************************/
@@ -115,11 +128,13 @@ void fill_heap_and_set(DAryHeap& heap, Set& set, KeysVector& keys) {
     }
 }
 
-//! Basic APIs: push(), top(), and pop().
-template <typename KeyType, unsigned Arity = 2,
-          class Compare = std::less<KeyType> >
-void d_ary_heap_test(size_t size, uint32_t r_seed = 42) {
-    tlx::DAryHeap<KeyType, Arity, Compare> x;
+//! Basic APIs: push(), top(), and pop() of a heap class.
+template <typename Heap>
+void heap_test(size_t size, uint32_t r_seed) {
+    using KeyType = typename Heap::key_type;
+    using Compare = typename Heap::compare_type;
+
+    Heap x;
     die_unequal(x.size(), 0u);
     die_if(!x.empty());
 
@@ -145,7 +160,7 @@ void d_ary_heap_test(size_t size, uint32_t r_seed = 42) {
     x.build_heap(s.begin(), s.end());
     check_heap(x, s);
 
-    tlx::DAryHeap<KeyType, Arity, Compare> y, z;
+    Heap y, z;
     y.build_heap(keys);
     check_heap(y, s);
 
@@ -153,6 +168,44 @@ void d_ary_heap_test(size_t size, uint32_t r_seed = 42) {
     check_heap(z, s);
 }
 
+//! Basic APIs: push(), top(), and pop().
+template <typename KeyType, unsigned Arity = 2,
+          class Compare = std::less<KeyType> >
+void d_ary_heap_test(size_t size, uint32_t r_seed = 42) {
+    heap_test<tlx::DAryHeap<KeyType, Arity, Compare> >(size, r_seed);
+}
+
+//! Basic APIs of the cache-aligned heap.
+template <typename KeyType, unsigned Arity = 2,
+          class Compare = std::less<KeyType> >
+void d_ary_aligned_heap_test(size_t size, uint32_t r_seed = 42) {
+    heap_test<tlx::DAryAlignedHeap<KeyType, Arity, Compare> >(size, r_seed);
+}
+
+//! Random keys covering the full range of KeyType, checked against a sorted
+//! vector. This exercises signed and unsigned comparisons in SIMD selection.
+template <typename KeyType, unsigned Arity,
+          class Compare = std::less<KeyType> >
+void d_ary_aligned_heap_random_test(size_t size, uint32_t r_seed = 42) {
+    tlx::DAryAlignedHeap<KeyType, Arity, Compare> x;
+    std::vector<KeyType> keys(size);
+
+    std::mt19937_64 gen(r_seed);
+    for (size_t i = 0; i < size; ++i) {
+        // produce some duplicates
+        keys[i] = static_cast<KeyType>(i % 7 == 0 ? keys[i / 2] : gen());
+        x.push(keys[i]);
+    }
+    die_unless(x.sanity_check());
+
+    std::sort(keys.begin(), keys.end(), Compare());
+    for (size_t i = 0; i < size; ++i) {
+        die_unequal(keys[i], x.top());
+        x.pop();
+    }
+    die_unless(x.empty());
+}
+
 //! Basic APIs: push(), top(), pop(), and remove().
 template <typename KeyType, unsigned Arity = 2,
           class Compare = std::less<KeyType> >
@@ -258,6 +311,108 @@ void d_ary_heap_test_update(size_t size, std::vector<double>& prio,
     prio = backup;
 }
 
+//! Compares sparse keys by priorities stored in a hash map.
+struct SparseComparator {
+    SparseComparator(const std::unordered_map<uint64_t, double>& p)
+        : prio(p) { }
+    bool operator () (const uint64_t& x, const uint64_t& y) const {
+        double px = prio.at(x), py = prio.at(y);
+        return px < py || (px == py && x < y);
+    }
+
+private:
+    const std::unordered_map<uint64_t, double>& prio;
+};
+
+//! Tests the addressable heap with sparse 64-bit keys: push(), pop(),
+//! remove(), update(), and update_many().
+template <unsigned Arity>
+void d_ary_addressable_hash_heap_test(size_t size, uint32_t r_seed = 42) {
+    std::unordered_map<uint64_t, double> prio;
+    SparseComparator cmp(prio);
+    tlx::DAryAddressableHashHeap<uint64_t, Arity, SparseComparator> x(cmp);
+    std::set<uint64_t, SparseComparator> s(cmp);
+
+    std::mt19937_64 gen(r_seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    std::vector<uint64_t> keys(size);
+    for (size_t i = 0; i < size; ++i) {
+        do {
+            keys[i] = gen();
+        } while (prio.count(keys[i]));
+        prio[keys[i]] = dis(gen);
+    }
+
+    // Test push() and pop().
+    fill_heap_and_set(x, s, keys);
+    check_handles(x, s);
+    die_unless(x.table_size() < 4 * size);
+    while (!x.empty()) {
+        x.pop();
+        s.erase(s.begin());
+        check_heap(x, s);
+        check_handles(x, s);
+    }
+
+    // Test remove() in random order.
+    fill_heap_and_set(x, s, keys);
+    std::shuffle(keys.begin(), keys.end(), gen);
+    for (size_t i = 0; i < size / 2; ++i) {
+        x.remove(keys[i]);
+        s.erase(keys[i]);
+        die_if(x.contains(keys[i]));
+        check_heap(x, s);
+    }
+    check_handles(x, s);
+
+    // Test update() of single items, also inserting removed keys.
+    for (size_t i = 0; i < size; ++i) {
+        s.erase(keys[i]);
+        prio[keys[i]] = dis(gen);
+        s.insert(keys[i]);
+        x.update(keys[i]);
+        check_heap(x, s);
+    }
+    check_handles(x, s);
+
+    // Test update_many() with few and with many changed keys.
+    for (size_t batch : { size_t(1), size_t(3), size / 10, size }) {
+        std::shuffle(keys.begin(), keys.end(), gen);
+        std::vector<uint64_t> changed(keys.begin(), keys.begin() + batch);
+        for (const uint64_t& k : changed) {
+            s.erase(k);
+            prio[k] = dis(gen);
+        }
+        for (const uint64_t& k : changed)
+            s.insert(k);
+        x.update_many(changed);
+        check_heap(x, s);
+        check_handles(x, s);
+    }
+
+    // Test update_many() inserting new keys, and build_heap().
+    std::vector<uint64_t> more;
+    for (size_t i = 0; i < size / 4; ++i) {
+        uint64_t k;
+        do {
+            k = gen();
+        } while (prio.count(k));
+        prio[k] = dis(gen);
+        more.push_back(k);
+        s.insert(k);
+    }
+    x.update_many(more);
+    check_heap(x, s);
+    check_handles(x, s);
+
+    x.clear();
+    die_unless(x.empty());
+    x.build_heap(s.begin(), s.end());
+    check_heap(x, s);
+    check_handles(x, s);
+}
+
 int main() {
     // Size of the tested heaps and random seed.
     size_t size = 100;
@@ -291,6 +446,46 @@ int main() {
     d_ary_heap_test<TestData, 2, TestCompare>(size, r_seed);
     d_ary_heap_test<TestData, 3, TestCompare>(size, r_seed);
 
+    // Cache-aligned heap, possibly using SIMD selection of children.
+#if TLX_D_ARY_HEAP_TEST_SIMD
+    // built with -msse4.2 by tests/CMakeLists.txt: SIMD selection must be used
+    static_assert(
+        tlx::DAryAlignedHeap<uint32_t, 8>::simd_select &&
+        tlx::DAryAlignedHeap<int64_t, 8,
+                             std::greater<int64_t> >::simd_select,
+        "SIMD child selection was not compiled");
+#endif
+    d_ary_aligned_heap_test<uint8_t, 1>(size, r_seed);
+    d_ary_aligned_heap_test<uint8_t, 3>(size, r_seed);
+    d_ary_aligned_heap_test<uint16_t, 8>(size, r_seed);
+    d_ary_aligned_heap_test<uint32_t, 4>(size, r_seed);
+    d_ary_aligned_heap_test<uint32_t, 8>(size, r_seed);
+    d_ary_aligned_heap_test<uint32_t, 16>(size, r_seed);
+    d_ary_aligned_heap_test<uint64_t, 2>(size, r_seed);
+    d_ary_aligned_heap_test<uint64_t, 4>(size, r_seed);
+    d_ary_aligned_heap_test<uint64_t, 8>(size, r_seed);
+    d_ary_aligned_heap_test<uint64_t, 16>(size, r_seed);
+    d_ary_aligned_heap_test<int32_t, 8>(size, r_seed);
+    d_ary_aligned_heap_test<int64_t, 8>(size, r_seed);
+
+    d_ary_aligned_heap_test<uint32_t, 8, std::greater<uint32_t> >(size, r_seed);
+    d_ary_aligned_heap_test<uint64_t, 8, std::greater<uint64_t> >(size, r_seed);
+    d_ary_aligned_heap_test<int32_t, 4, std::greater<int32_t> >(size, r_seed);
+    d_ary_aligned_heap_test<int64_t, 4, std::greater<int64_t> >(size, r_seed);
+    d_ary_aligned_heap_test<TestData, 4, TestCompare>(size, r_seed);
+
+    d_ary_aligned_heap_random_test<uint32_t, 4>(10000, r_seed);
+    d_ary_aligned_heap_random_test<uint32_t, 16>(10000, r_seed);
+    d_ary_aligned_heap_random_test<int32_t, 8>(10000, r_seed);
+    d_ary_aligned_heap_random_test<uint64_t, 8>(10000, r_seed);
+    d_ary_aligned_heap_random_test<int64_t, 16>(10000, r_seed);
+    d_ary_aligned_heap_random_test<
+        uint64_t, 4, std::greater<uint64_t> >(10000, r_seed);
+    d_ary_aligned_heap_random_test<
+        int64_t, 2, std::greater<int64_t> >(10000, r_seed);
+    d_ary_aligned_heap_random_test<
+        int32_t, 8, std::greater<int32_t> >(10000, r_seed);
+
     // Basic heap APIs with default compare functions.
     d_ary_addressable_int_heap_test<uint8_t, 1>(size, r_seed);
     d_ary_addressable_int_heap_test<uint8_t, 2>(size, r_seed);
@@ -315,6 +510,13 @@ int main() {
     d_ary_addressable_int_heap_test<uint32_t, 2, std::greater<uint32_t> >(size, r_seed);
     d_ary_addressable_int_heap_test<uint64_t, 2, std::greater<uint64_t> >(size, r_seed);
 
+    // Addressable heap with sparse keys.
+    d_ary_addressable_hash_heap_test<1>(size, r_seed);
+    d_ary_addressable_hash_heap_test<2>(size, r_seed);
+    d_ary_addressable_hash_heap_test<4>(size, r_seed);
+    d_ary_addressable_hash_heap_test<4>(10 * size, r_seed);
+    d_ary_addressable_hash_heap_test<7>(size, r_seed);
+
     // Custom compare function.
     std::vector<double> prio(size);
     std::mt19937 gen(r_seed);
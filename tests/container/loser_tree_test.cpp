@@ -10,8 +10,12 @@
 
 #include <algorithm>
 #include <chrono>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <tlx/cmdline_parser.hpp>
@@ -102,6 +106,9 @@ template class LoserTreePointerUnguarded<false, MyIntPair, MyIntPairCompare>;
 template class LoserTreePointerUnguarded<true, MyIntPair, MyIntPairCompare>;
 template class LoserTreePointerUnguardedBase<MyIntPair, MyIntPairCompare>;
 
+template class LoserTreeIntegral<false, uint64_t, std::less<uint64_t> >;
+template class LoserTreeIntegral<true, int, std::greater<int> >;
+
 } // namespace tlx
 
 /******************************************************************************/
@@ -231,6 +238,78 @@ static void test_losertree() {
     die_unequal(ctor_dtor_counter, 0);
 }
 
+/******************************************************************************/
+// test_losertree_integral
+
+template <typename Key, typename Comparator>
+static void test_losertree_integral(size_t num_vectors, Key extreme) {
+
+    using Item = std::pair<Key, size_t>;
+    std::vector<std::vector<Key> > vecs(num_vectors);
+    std::vector<Item> correct;
+
+    std::default_random_engine rng(1234 + num_vectors);
+    Comparator cmp;
+
+    for (size_t i = 0; i < num_vectors; ++i) {
+        // few distinct values to produce ties, plus the sentinel value itself
+        for (size_t j = 0; j < (i * 37) % 100; ++j)
+            vecs[i].push_back(static_cast<Key>(rng() % 20));
+        if (i % 3 == 0) vecs[i].push_back(extreme);
+        std::sort(vecs[i].begin(), vecs[i].end(), cmp);
+        for (const Key& k : vecs[i])
+            correct.emplace_back(k, i);
+    }
+
+    // the loser tree breaks ties by source
+    std::stable_sort(correct.begin(), correct.end(),
+                     [&cmp](const Item& a, const Item& b) {
+                         return cmp(a.first, b.first);
+                     });
+
+    tlx::LoserTree<false, Key, Comparator> lt(num_vectors);
+    std::vector<size_t> pos(num_vectors, 0);
+
+    for (size_t i = 0; i < num_vectors; ++i) {
+        if (vecs[i].empty())
+            lt.insert_start(nullptr, i, true);
+        else
+            lt.insert_start(&vecs[i][0], i, false);
+    }
+    lt.init();
+
+    std::vector<Item> result;
+    while (result.size() != correct.size()) {
+        unsigned top = lt.min_source();
+        die_unless(top < num_vectors);
+        result.emplace_back(vecs[top][pos[top]++], top);
+
+        if (pos[top] != vecs[top].size())
+            lt.delete_min_insert(&vecs[top][pos[top]], false);
+        else
+            lt.delete_min_insert(nullptr, true);
+    }
+
+    die_unless(result == correct);
+}
+
+static void test_losertree_integral() {
+    static_assert(
+        std::is_same<tlx::LoserTree<false, uint64_t, std::less<uint64_t> >,
+                     tlx::LoserTreeIntegral<false, uint64_t,
+                                            std::less<uint64_t> > >::value,
+        "LoserTree selects LoserTreeIntegral");
+
+    for (size_t k = 1; k <= 12; ++k) {
+        test_losertree_integral<uint64_t, std::less<uint64_t> >(
+            k, std::numeric_limits<uint64_t>::max());
+        test_losertree_integral<int, std::greater<int> >(
+            k, std::numeric_limits<int>::lowest());
+    }
+    test_losertree_integral<uint32_t, std::less<uint32_t> >(
+        100, std::numeric_limits<uint32_t>::max());
+}
+
 /******************************************************************************/
 // benchmark_losertree
 
@@ -348,6 +427,7 @@ int main(int argc, char* argv[]) {
 
     if (benchmark.empty()) {
         test_losertree();
+        test_losertree_integral();
         return 0;
     }
 
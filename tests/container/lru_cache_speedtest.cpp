@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * tests/container/lru_cache_speedtest.cpp
+ *
+ * Multi-threaded throughput of a mutex-protected LruCacheMap versus the sharded
+ * ConcurrentLruCacheMap.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tlx/container/concurrent_lru_cache.hpp>
+#include <tlx/container/lru_cache.hpp>
+#include <tlx/die.hpp>
+#include <tlx/timestamp.hpp>
+
+// *** Settings
+
+//! number of items in the cache
+const size_t cache_capacity = 100000;
+
+//! number of distinct keys accessed
+const size_t key_universe = 400000;
+
+//! number of operations per thread
+const size_t num_operations = 2000000;
+
+// -----------------------------------------------------------------------------
+
+//! LruCacheMap behind a single mutex, with explicit eviction.
+class LockedLruCache
+{
+public:
+    explicit LockedLruCache(size_t cap) : capacity_(cap) { }
+
+    size_t get_or_insert(size_t key) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cache_.touch_if_exists(key))
+            return cache_.get(key);
+        cache_.put(key, key);
+        while (cache_.size() > capacity_)
+            cache_.pop();
+        return key;
+    }
+
+private:
+    std::mutex mutex_;
+    tlx::LruCacheMap<size_t, size_t> cache_;
+    size_t capacity_;
+};
+
+//! ConcurrentLruCacheMap with or without buffered promotions.
+template <bool BufferPromotions>
+class ShardedLruCache
+{
+public:
+    explicit ShardedLruCache(size_t cap)
+        : cache_(cap, 0, BufferPromotions) { }
+
+    size_t get_or_insert(size_t key) {
+        return cache_.get_or_insert(key, [](size_t k) { return k; });
+    }
+
+private:
+    tlx::ConcurrentLruCacheMap<size_t, size_t> cache_;
+};
+
+//! Generate a skewed key sequence: Zipf-like with exponent ~1 by inverse
+//! transform of a log-uniform variable.
+std::vector<size_t> make_keys(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<size_t> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        double x = std::pow(static_cast<double>(key_universe), dist(rng));
+        keys[i] = static_cast<size_t>(x) - 1;
+    }
+    return keys;
+}
+
+template <typename Cache>
+void run(const std::string& name, size_t num_threads,
+         const std::vector<std::vector<size_t> >& keys) {
+    Cache cache(cache_capacity);
+
+    double ts1 = tlx::timestamp();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&cache, &keys, t]() {
+                size_t sum = 0;
+                for (const size_t& k : keys[t])
+                    sum += cache.get_or_insert(k);
+                die_unless(sum != 1);
+            });
+    }
+    for (std::thread& t : threads)
+        t.join();
+    double ts2 = tlx::timestamp();
+
+    double ops = static_cast<double>(num_threads * num_operations);
+    std::cout << "RESULT"
+              << " cache=" << name
+              << " threads=" << num_threads
+              << " ops=" << num_threads * num_operations
+              << " time=" << std::fixed << std::setprecision(6) << (ts2 - ts1)
+              << " mops=" << ops / (ts2 - ts1) / 1e6
+              << std::endl;
+}
+
+int main() {
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::vector<size_t> > keys;
+    for (size_t t = 0; t < 2 * max_threads; ++t)
+        keys.emplace_back(make_keys(num_operations, static_cast<unsigned>(t)));
+
+    for (size_t p = 1; p <= 2 * max_threads; p *= 2) {
+        run<LockedLruCache>("LruCacheMap+mutex", p, keys);
+        run<ShardedLruCache<false> >("ConcurrentLruCacheMap", p, keys);
+        run<ShardedLruCache<true> >("ConcurrentLruCacheMap+buffered", p, keys);
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -11,7 +11,16 @@
  * All rights reserved. Published under the Boost Software License, Version 1.0
  ******************************************************************************/
 
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tlx/container/concurrent_lru_cache.hpp>
+#include <tlx/container/flat_lru_cache.hpp>
 #include <tlx/container/lru_cache.hpp>
+#include <tlx/container/timer_wheel.hpp>
 #include <tlx/die.hpp>
 
 namespace tlx {
@@ -19,6 +28,9 @@ namespace tlx {
 // instantiations
 template class tlx::LruCacheSet<size_t>;
 template class tlx::LruCacheMap<size_t, size_t>;
+template class tlx::FlatLruCacheSet<size_t>;
+template class tlx::FlatLruCacheMap<size_t, size_t>;
+template class tlx::ConcurrentLruCacheMap<size_t, size_t>;
 
 } // namespace tlx
 
@@ -196,6 +208,313 @@ static void test_map_keep_all_values_within_capacity() {
     die_unequal(0u, cache.size());
 }
 
+static void test_map_put_existing() {
+    tlx::LruCacheMap<size_t, size_t> cache;
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.put(1, 11);
+    die_unequal(2u, cache.size());
+    die_unequal(11u, cache.get(1));
+
+    // 1 was touched by put(), hence 2 is the least recently used
+    die_unequal(2u, cache.pop().first);
+    die_unequal(1u, cache.pop().first);
+}
+
+static void test_map_capacity_eviction() {
+    // unit costs: keeps the three most recently used pairs
+    std::vector<size_t> evicted;
+    tlx::LruCacheMap<size_t, size_t> cache(
+        3, tlx::LruCacheMap<size_t, size_t>::CostFunction(),
+        [&](const size_t& k, size_t& v) {
+            die_unequal(k * 10, v);
+            evicted.push_back(k);
+        });
+
+    for (size_t i = 0; i < 5; ++i)
+        cache.put(i, i * 10);
+    die_unequal(3u, cache.size());
+    die_unequal(3u, cache.total_cost());
+    die_unequal(2u, evicted.size());
+    die_unequal(0u, evicted[0]);
+    die_unequal(1u, evicted[1]);
+
+    cache.touch(2);
+    cache.put(5, 50);
+    die_unequal(3u, evicted[2]);
+    die_unless(cache.exists(2));
+
+    // shrinking evicts, erase() and pop() do not call the callback
+    cache.set_capacity(2);
+    die_unequal(4u, evicted.back());
+    cache.erase(2);
+    die_unequal(5u, cache.pop().first);
+    die_unequal(4u, evicted.size());
+    die_unequal(0u, cache.total_cost());
+}
+
+static void test_map_cost_eviction() {
+    // strings costing their length, capacity of 10 bytes
+    std::vector<std::string> evicted;
+    tlx::LruCacheMap<size_t, std::string> cache(
+        10,
+        [](const size_t&, const std::string& v) { return v.size(); },
+        [&](const size_t&, std::string& v) { evicted.push_back(v); });
+
+    cache.put(1, "aaaa");
+    cache.put(2, "bbbb");
+    die_unequal(8u, cache.total_cost());
+    cache.put(3, "cc");
+    die_unequal(10u, cache.total_cost());
+    die_unequal(0u, evicted.size());
+
+    // growing a value evicts the least recently used pair
+    cache.put(3, "ccc");
+    die_unequal(1u, evicted.size());
+    die_unequal("aaaa", evicted[0]);
+    die_unequal(7u, cache.total_cost());
+
+    // a pair larger than the capacity is evicted right away
+    cache.put(4, "dddddddddddd");
+    die_unequal(4u, evicted.size());
+    die_unequal("dddddddddddd", evicted.back());
+    die_unequal(0u, cache.size());
+    die_unequal(0u, cache.total_cost());
+
+    cache.put(5, "e");
+    die_unequal(1u, cache.total_cost());
+    cache.erase(5);
+    die_unequal(0u, cache.total_cost());
+}
+
+static void test_map_ttl() {
+    // caches without TTLs do not embed the timer wheel
+    static_assert(sizeof(tlx::LruCacheMap<size_t, size_t>) <
+                  sizeof(tlx::TimerWheel<size_t>),
+                  "LruCacheMap must allocate the timer wheel on demand");
+
+    // manual clock in ticks
+    uint64_t now = 1000;
+    std::vector<size_t> expired;
+    tlx::LruCacheMap<size_t, size_t> cache(
+        0, tlx::LruCacheMap<size_t, size_t>::CostFunction(),
+        [&](const size_t& k, size_t&) { expired.push_back(k); });
+    cache.set_ttl(100, [&]() { return now; });
+    die_unequal(100u, cache.ttl());
+
+    cache.put(1, 10);
+    cache.put(2, 20, 50);
+    cache.put(3, 30, 0);
+    die_unequal(3u, cache.size());
+
+    // lazy expiry on lookup
+    now = 1050;
+    die_unless(!cache.exists(2));
+    die_unless(cache.find_touch(2) == nullptr);
+    die_unequal(1u, expired.size());
+    die_unequal(2u, expired[0]);
+    die_unequal(2u, cache.size());
+
+    // put() of an existing key restarts its TTL
+    now = 1090;
+    cache.put(1, 11);
+    now = 1150;
+    die_unequal(11u, cache.get_touch(1));
+
+    // batch reclaim of many expired pairs, 3 never expires
+    for (size_t i = 100; i < 1100; ++i)
+        cache.put(i, i, 1 + i % 10);
+    now = 1155;
+    die_unequal(500u, cache.expire());
+    now = 1200;
+    die_unequal(501u, cache.expire());
+    die_unequal(1u, cache.size());
+    die_unless(cache.exists(3));
+    die_unequal(1002u, expired.size());
+
+    // erase, pop, and clear cancel the timers
+    cache.put(4, 40);
+    cache.put(5, 50);
+    cache.erase(4);
+    die_unequal(3u, cache.pop().first);
+    cache.clear();
+    now = 2000;
+    die_unequal(0u, cache.expire());
+    die_unequal(1002u, expired.size());
+
+    // exceptions of the eviction callback propagate out of lookups
+    tlx::LruCacheMap<size_t, size_t> throwing(
+        0, tlx::LruCacheMap<size_t, size_t>::CostFunction(),
+        [](const size_t&, size_t&) { throw std::runtime_error("evict"); });
+    throwing.set_ttl(100, [&]() { return now; });
+    throwing.put(1, 10);
+    now = 2100;
+    die_unless_throws(throwing.touch_if_exists(1), std::runtime_error);
+}
+
+/******************************************************************************/
+// FlatLruCacheSet and FlatLruCacheMap
+
+static void test_flat_set() {
+    static constexpr size_t capacity = 50;
+    tlx::FlatLruCacheSet<size_t> cache(capacity);
+    die_unequal(capacity, cache.capacity());
+
+    // put more items into cache than capacity, put() evicts automatically
+    for (size_t i = 0; i < 100; ++i)
+        cache.put(i);
+
+    die_unless(cache.full());
+    for (size_t i = 0; i < 50; ++i)
+        die_if(cache.exists(i));
+    for (size_t i = 50; i < 100; ++i)
+        die_unless(cache.exists(i));
+
+    cache.touch(70);
+    cache.put(75);
+    die_unless(cache.touch_if_exists(80));
+    die_if(cache.touch_if_exists(20));
+    die_unless_throws(cache.touch(20), std::range_error);
+
+    cache.erase(90);
+    die_unless(cache.erase_if_exists(95));
+    die_if(cache.erase_if_exists(45));
+    die_unless_throws(cache.erase(45), std::range_error);
+    die_unequal(capacity - 2, cache.size());
+
+    for (size_t i = 50; i < 100; ++i) {
+        if (i == 70 || i == 75 || i == 80 || i == 90 || i == 95) ++i;
+        die_unequal(cache.pop(), i);
+    }
+    die_unequal(cache.pop(), 70u);
+    die_unequal(cache.pop(), 75u);
+    die_unequal(cache.pop(), 80u);
+    die_unequal(0u, cache.size());
+
+    // reuse after clear
+    cache.put(5);
+    cache.clear();
+    die_unequal(0u, cache.size());
+    die_if(cache.exists(5));
+}
+
+// compare FlatLruCacheMap against LruCacheMap with explicit eviction
+static void test_flat_map_random(size_t capacity, size_t operations) {
+    std::mt19937 rng(static_cast<unsigned>(capacity));
+    std::uniform_int_distribution<size_t> dist(0, 3 * capacity);
+
+    tlx::FlatLruCacheMap<size_t, std::string> flat(capacity);
+    tlx::LruCacheMap<size_t, std::string> ref;
+
+    for (size_t i = 0; i < operations; ++i) {
+        size_t key = dist(rng);
+        switch (rng() % 5) {
+        case 0:
+        case 1:
+            flat.put(key, std::to_string(i));
+            ref.put(key, std::to_string(i));
+            while (ref.size() > capacity)
+                ref.pop();
+            break;
+        case 2:
+            die_unequal(ref.touch_if_exists(key), flat.touch_if_exists(key));
+            break;
+        case 3:
+            die_unequal(ref.erase_if_exists(key), flat.erase_if_exists(key));
+            break;
+        case 4: {
+            const std::string* v = flat.find_touch(key);
+            die_unequal(ref.exists(key), v != nullptr);
+            if (v)
+                die_unequal(ref.get_touch(key), *v);
+            break;
+        }
+        }
+        die_unequal(ref.size(), flat.size());
+    }
+
+    while (ref.size()) {
+        auto a = ref.pop(), b = flat.pop();
+        die_unequal(a.first, b.first);
+        die_unequal(a.second, b.second);
+    }
+    die_unequal(0u, flat.size());
+}
+
+/******************************************************************************/
+// ConcurrentLruCacheMap
+
+static void test_concurrent(size_t num_shards, bool buffer_promotions) {
+    static constexpr size_t capacity = 1000;
+    static constexpr size_t num_threads = 4;
+    tlx::ConcurrentLruCacheMap<size_t, std::string> cache(
+        capacity, num_shards, buffer_promotions);
+    die_unequal(num_shards, cache.num_shards());
+    die_unequal(capacity, cache.capacity());
+
+    auto value_of = [](size_t key) { return std::to_string(key * 3); };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&, t]() {
+                std::mt19937 rng(static_cast<unsigned>(t));
+                for (size_t i = 0; i < 20000; ++i) {
+                    size_t key = rng() % (2 * capacity);
+                    std::string v;
+                    switch (rng() % 4) {
+                    case 0:
+                        die_unequal(value_of(key),
+                                    cache.get_or_insert(key, value_of));
+                        break;
+                    case 1:
+                        cache.put(key, value_of(key));
+                        break;
+                    case 2:
+                        if (cache.get(key, v))
+                            die_unequal(value_of(key), v);
+                        break;
+                    case 3:
+                        if (rng() % 8 == 0)
+                            cache.erase(key);
+                        break;
+                    }
+                }
+            });
+    }
+    for (std::thread& t : threads)
+        t.join();
+
+    die_unless(cache.size() <= cache.capacity());
+
+    // LRU order within a single shard
+    tlx::ConcurrentLruCacheMap<size_t, size_t> one(2, 1, buffer_promotions);
+    one.put(1, 1);
+    one.put(2, 2);
+    size_t v;
+    die_unless(one.get(1, v));
+    one.put(3, 3);
+    die_unless(one.exists(1));
+    die_if(one.exists(2));
+    die_unless(one.erase(3));
+    die_unequal(1u, one.size());
+    one.clear();
+    die_unequal(0u, one.size());
+
+    // the capacity is kept exactly, also with more shards than items
+    for (size_t cap : { 0, 1, 10, 100, 1001 }) {
+        for (size_t shards : { 0, 1, 3, 64 }) {
+            tlx::ConcurrentLruCacheMap<size_t, size_t> c(
+                cap, shards, buffer_promotions);
+            die_unequal(cap, c.capacity());
+            die_unless(c.num_shards() <= std::max<size_t>(cap, 1));
+            for (size_t i = 0; i < 4 * cap; ++i)
+                c.put(i, i);
+            die_unless(c.size() <= cap);
+        }
+    }
+}
+
 int main() {
 
     test_set_simple_put();
@@ -205,6 +524,19 @@ int main() {
     test_map_simple_put();
     test_map_missing_value();
     test_map_keep_all_values_within_capacity();
+    test_map_put_existing();
+    test_map_capacity_eviction();
+    test_map_cost_eviction();
+    test_map_ttl();
+
+    test_flat_set();
+    test_flat_map_random(1, 1000);
+    test_flat_map_random(50, 10000);
+    test_flat_map_random(1000, 100000);
+
+    test_concurrent(1, false);
+    test_concurrent(16, false);
+    test_concurrent(16, true);
 
     return 0;
 }
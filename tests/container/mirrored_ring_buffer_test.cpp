@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * tests/container/mirrored_ring_buffer_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/container/mirrored_ring_buffer.hpp>
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <tlx/die.hpp>
+
+static void test_mirrored_ring_buffer() {
+    tlx::MirroredRingBuffer rb(1000);
+    die_unless(rb.capacity() >= tlx::MirroredRingBuffer::page_size());
+    die_unequal(0u, rb.capacity() & (rb.capacity() - 1));
+    die_unless(rb.empty());
+
+    size_t cap = rb.capacity();
+
+    // fill up to just before the end of the buffer
+    tlx::MirroredRingBuffer::Span w = rb.write_span();
+    die_unequal(cap, w.size);
+    std::memset(w.data, 'x', cap - 3);
+    rb.commit(cap - 3);
+    die_unequal(3u, rb.space());
+    rb.consume(cap - 3);
+    die_unless(rb.empty());
+
+    // write a record crossing the wrap-around point
+    std::string rec = "hello mirrored world";
+    die_unequal(rec.size(), rb.write(rec.data(), rec.size()));
+    die_unequal(rec.size(), rb.size());
+
+    // the readable region is contiguous
+    tlx::MirroredRingBuffer::Span r = rb.read_span();
+    die_unequal(rec.size(), r.size);
+    die_unequal(rec, std::string(r.begin(), r.end()));
+    die_unequal('h', rb[0]);
+    die_unequal('d', rb[rec.size() - 1]);
+
+    // the wrapped part is visible at the start of the first mapping
+    die_unequal('l', w.data[0]);
+
+    // write span is contiguous too, fill up the buffer completely
+    w = rb.write_span();
+    die_unequal(cap - rec.size(), w.size);
+    for (size_t i = 0; i < w.size; ++i)
+        w.data[i] = static_cast<char>('a' + i % 26);
+    rb.commit(w.size);
+    die_unless(rb.full());
+    die_unequal(0u, rb.write("z", 1));
+
+    // read everything back in chunks
+    char buf[100];
+    die_unequal(rec.size(), rb.read(buf, rec.size()));
+    die_unequal(rec, std::string(buf, rec.size()));
+    size_t i = 0;
+    while (size_t n = rb.read(buf, sizeof(buf))) {
+        for (size_t j = 0; j < n; ++j, ++i)
+            die_unequal(static_cast<char>('a' + i % 26), buf[j]);
+    }
+    die_unequal(cap - rec.size(), i);
+    die_unless(rb.empty());
+
+    // move buffer
+    rb.write(rec.data(), rec.size());
+    tlx::MirroredRingBuffer rb2 = std::move(rb);
+    die_unequal(0u, rb.capacity());
+    die_unequal(rec.size(), rb2.size());
+    r = rb2.read_span();
+    die_unequal(rec, std::string(r.begin(), r.end()));
+
+    // allocate again replaces the buffer
+    rb2.allocate(4 * cap);
+    die_unequal(4 * cap, rb2.capacity());
+    die_unless(rb2.empty());
+    die_unequal(rec.size(), rb2.write(rec.data(), rec.size()));
+    rb2.deallocate();
+    die_unequal(0u, rb2.capacity());
+}
+
+//! stream parsing: read newline-terminated records of varying length
+static void test_stream_parse() {
+    tlx::MirroredRingBuffer rb(4096);
+
+    size_t produced = 0, consumed = 0;
+    for (size_t round = 0; round < 1000; ++round) {
+        // producer: append records while they fit
+        for ( ; ; ) {
+            std::string rec = std::to_string(produced) + ":" +
+                              std::string(produced % 97, 'r') + "\n";
+            if (rec.size() > rb.space()) break;
+            rb.write(rec.data(), rec.size());
+            ++produced;
+        }
+
+        // consumer: parse some complete records in place
+        for (size_t k = 0; k < 10; ++k) {
+            tlx::MirroredRingBuffer::Span r = rb.read_span();
+            char* nl = static_cast<char*>(std::memchr(r.data, '\n', r.size));
+            if (!nl) break;
+            std::string rec(r.data, nl);
+            die_unequal(std::to_string(consumed) + ":" +
+                        std::string(consumed % 97, 'r'), rec);
+            rb.consume(nl + 1 - r.data);
+            ++consumed;
+        }
+    }
+    die_unless(produced > 5000);
+}
+
+int main() {
+    test_mirrored_ring_buffer();
+    test_stream_parse();
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,213 @@
+/*******************************************************************************
+ * tests/container/mpmc_queue_speedtest.cpp
+ *
+ * Contention benchmark of MpmcQueue and BlockingMpmcQueue versus a
+ * mutex-protected RingBuffer.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tlx/container/mpmc_queue.hpp>
+#include <tlx/container/ring_buffer.hpp>
+#include <tlx/die.hpp>
+#include <tlx/timestamp.hpp>
+
+// *** Settings
+
+//! capacity of the queues
+const size_t queue_size = 1024;
+
+//! number of items per producer
+const size_t num_items = 1000000;
+
+//! batch size of push_n() and pop_n()
+const size_t batch_size = 32;
+
+// -----------------------------------------------------------------------------
+
+//! RingBuffer behind a single mutex, with condition variables for waiting.
+class LockedRingBuffer
+{
+public:
+    explicit LockedRingBuffer(size_t n) : ring_(n) { }
+
+    void push(size_t x) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (ring_.size() == ring_.max_size())
+            not_full_.wait(lock);
+        ring_.push_back(x);
+        not_empty_.notify_one();
+    }
+
+    bool pop(size_t& x) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (ring_.empty()) {
+            if (closed_) return false;
+            not_empty_.wait(lock);
+        }
+        x = ring_.front();
+        ring_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable not_empty_, not_full_;
+    tlx::RingBuffer<size_t> ring_;
+    bool closed_ = false;
+};
+
+//! MpmcQueue, retrying failed operations after yielding.
+class SpinningMpmcQueue
+{
+public:
+    explicit SpinningMpmcQueue(size_t n) : queue_(n) { }
+
+    void push(size_t x) {
+        while (!queue_.try_push(x))
+            std::this_thread::yield();
+    }
+
+    bool pop(size_t& x) {
+        for ( ; ; ) {
+            bool closed = closed_.load();
+            if (queue_.try_pop(x)) return true;
+            if (closed) return false;
+            std::this_thread::yield();
+        }
+    }
+
+    void close() { closed_ = true; }
+
+private:
+    tlx::MpmcQueue<size_t> queue_;
+    std::atomic<bool> closed_ { false };
+};
+
+//! BlockingMpmcQueue
+class BlockingQueue
+{
+public:
+    explicit BlockingQueue(size_t n) : queue_(n) { }
+
+    void push(size_t x) { queue_.push(x); }
+    bool pop(size_t& x) { return queue_.pop(x); }
+    void close() { queue_.close(); }
+
+    tlx::BlockingMpmcQueue<size_t>& queue() { return queue_; }
+
+private:
+    tlx::BlockingMpmcQueue<size_t> queue_;
+};
+
+//! BlockingMpmcQueue with push_n() and pop_n()
+class BatchedBlockingQueue : public BlockingQueue
+{
+public:
+    using BlockingQueue::BlockingQueue;
+};
+
+template <typename Queue>
+size_t produce(Queue& q, size_t p) {
+    for (size_t i = 0; i < num_items; ++i)
+        q.push(p * num_items + i);
+    return num_items;
+}
+
+size_t produce(BatchedBlockingQueue& q, size_t p) {
+    std::vector<size_t> items(batch_size);
+    for (size_t i = 0; i < num_items; i += batch_size) {
+        size_t n = std::min(batch_size, num_items - i);
+        for (size_t j = 0; j < n; ++j)
+            items[j] = p * num_items + i + j;
+        q.queue().push_n(items.begin(), n);
+    }
+    return num_items;
+}
+
+template <typename Queue>
+size_t consume(Queue& q) {
+    size_t x, sum = 0;
+    while (q.pop(x))
+        sum += x;
+    return sum;
+}
+
+size_t consume(BatchedBlockingQueue& q) {
+    std::vector<size_t> items(batch_size);
+    size_t n, sum = 0;
+    while ((n = q.queue().pop_n(items.begin(), batch_size)) != 0) {
+        for (size_t j = 0; j < n; ++j)
+            sum += items[j];
+    }
+    return sum;
+}
+
+template <typename Queue>
+void run(const std::string& name, size_t producers, size_t consumers) {
+    Queue q(queue_size);
+    std::atomic<size_t> sum { 0 };
+
+    double ts1 = tlx::timestamp();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+        threads.emplace_back([&q, p]() { produce(q, p); });
+    for (size_t c = 0; c < consumers; ++c)
+        threads.emplace_back([&q, &sum]() { sum += consume(q); });
+    for (size_t p = 0; p < producers; ++p)
+        threads[p].join();
+    q.close();
+    for (size_t c = 0; c < consumers; ++c)
+        threads[producers + c].join();
+    double ts2 = tlx::timestamp();
+
+    size_t total = producers * num_items;
+    die_unequal(total * (total - 1) / 2, sum.load());
+
+    std::cout << "RESULT"
+              << " queue=" << name
+              << " producers=" << producers
+              << " consumers=" << consumers
+              << " items=" << total
+              << " time=" << std::fixed << std::setprecision(6) << (ts2 - ts1)
+              << " mops=" << static_cast<double>(total) / (ts2 - ts1) / 1e6
+              << std::endl;
+}
+
+int main() {
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t p = 1; p <= max_threads; p *= 2) {
+        for (size_t c = 1; c <= max_threads; c *= 2) {
+            run<LockedRingBuffer>("RingBuffer+mutex", p, c);
+            run<SpinningMpmcQueue>("MpmcQueue", p, c);
+            run<BlockingQueue>("BlockingMpmcQueue", p, c);
+            run<BatchedBlockingQueue>("BlockingMpmcQueue+batch", p, c);
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
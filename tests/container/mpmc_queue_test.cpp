@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * tests/container/mpmc_queue_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/container/mpmc_queue.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+namespace tlx {
+
+// instantiations
+template class MpmcQueue<size_t>;
+template class BlockingMpmcQueue<size_t>;
+
+} // namespace tlx
+
+static void test_single_thread() {
+    tlx::MpmcQueue<std::string> q(6);
+    die_unequal(8u, q.capacity());
+    die_unless(q.empty());
+
+    std::string s;
+    die_unless(!q.try_pop(s));
+
+    size_t next_push = 0, next_pop = 0;
+    for (size_t round = 0; round < 10; ++round) {
+        while (q.try_push(std::to_string(next_push)))
+            ++next_push;
+        die_unequal(8u, q.size());
+        die_unless(!q.try_emplace("x"));
+
+        for (size_t i = 0; i < 5; ++i) {
+            die_unless(q.try_pop(s));
+            die_unequal(std::to_string(next_pop++), s);
+        }
+    }
+
+    std::vector<std::string> in = { "a", "b", "c", "d", "e", "f" };
+    die_unequal(5u, q.push_n(in.begin(), in.size()));
+    die_unequal(0u, q.push_n(in.begin(), in.size()));
+
+    std::vector<std::string> out(10);
+    die_unequal(2u, q.pop_n(out.begin(), 2));
+    die_unequal(std::to_string(next_pop + 1), out[1]);
+    die_unequal(6u, q.pop_n(out.begin(), 10));
+    die_unequal("a", out[1]);
+    die_unequal("e", out[5]);
+    die_unless(q.empty());
+    die_unequal(0u, q.pop_n(out.begin(), 10));
+
+    // destructor destroys remaining items
+    q.push_n(in.begin(), 3);
+}
+
+//! allocator which counts the bytes allocated through it
+template <typename Type>
+struct CountingAllocator : public std::allocator<Type> {
+    using value_type = Type;
+
+    template <typename Other>
+    struct rebind { using other = CountingAllocator<Other>; };
+
+    size_t* bytes;
+
+    explicit CountingAllocator(size_t* b) : bytes(b) { }
+
+    template <typename Other>
+    CountingAllocator(const CountingAllocator<Other>& other)
+        : bytes(other.bytes) { }
+
+    Type * allocate(size_t n) {
+        *bytes += n * sizeof(Type);
+        return std::allocator<Type>::allocate(n);
+    }
+
+    void deallocate(Type* p, size_t n) {
+        *bytes -= n * sizeof(Type);
+        std::allocator<Type>::deallocate(p, n);
+    }
+};
+
+//! the cells are allocated with the queue's allocator
+static void test_allocator() {
+    size_t bytes = 0;
+    {
+        tlx::MpmcQueue<std::string, CountingAllocator<std::string> > q(
+            100, CountingAllocator<std::string>(&bytes));
+        die_unless(bytes >= q.capacity() * sizeof(std::string));
+        die_unless(q.try_push("x"));
+    }
+    die_unequal(0u, bytes);
+}
+
+//! items encode producer and sequence number, consumers check that the items
+//! of each producer arrive in order and that all arrive.
+static const size_t producer_shift = 48;
+
+template <typename Queue, typename Push, typename Pop>
+static void run_threads(size_t num_producers, size_t num_consumers,
+                        size_t count, size_t batch, Queue& q,
+                        Push push, Pop pop) {
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < num_producers; ++p) {
+        threads.emplace_back(
+            [&, p]() {
+                std::vector<size_t> items(batch);
+                size_t i = 0;
+                while (i < count) {
+                    size_t n = std::min(batch, count - i);
+                    for (size_t j = 0; j < n; ++j)
+                        items[j] = (p << producer_shift) | (i + j);
+                    i += push(q, items, n);
+                }
+            });
+    }
+
+    std::vector<std::vector<size_t> > received(num_consumers);
+    for (size_t c = 0; c < num_consumers; ++c) {
+        threads.emplace_back(
+            [&, c]() {
+                std::vector<size_t> next(num_producers, 0);
+                std::vector<size_t> items(batch);
+                size_t n;
+                while ((n = pop(q, items)) != 0) {
+                    for (size_t j = 0; j < n; ++j) {
+                        size_t p = items[j] >> producer_shift;
+                        size_t i =
+                            items[j] & ((size_t(1) << producer_shift) - 1);
+                        die_unless(i >= next[p]);
+                        next[p] = i + 1;
+                        received[c].push_back(items[j]);
+                    }
+                }
+            });
+    }
+
+    for (size_t p = 0; p < num_producers; ++p)
+        threads[p].join();
+    // signal end of stream
+    q.close();
+    for (size_t c = 0; c < num_consumers; ++c)
+        threads[num_producers + c].join();
+
+    std::vector<size_t> all;
+    for (size_t c = 0; c < num_consumers; ++c)
+        all.insert(all.end(), received[c].begin(), received[c].end());
+    std::sort(all.begin(), all.end());
+    die_unequal(num_producers * count, all.size());
+    for (size_t p = 0; p < num_producers; ++p) {
+        for (size_t i = 0; i < count; ++i)
+            die_unequal((p << producer_shift) | i, all[p * count + i]);
+    }
+}
+
+//! lock-free queue with a close flag for the test
+class ClosableQueue : public tlx::MpmcQueue<size_t>
+{
+public:
+    explicit ClosableQueue(size_t n) : tlx::MpmcQueue<size_t>(n) { }
+    void close() { closed = true; }
+    std::atomic<bool> closed { false };
+};
+
+static void test_lock_free(size_t num_producers, size_t num_consumers,
+                           size_t batch) {
+    ClosableQueue q(64);
+    run_threads(
+        num_producers, num_consumers, 100000, batch, q,
+        [](ClosableQueue& cq, std::vector<size_t>& items, size_t n) {
+            size_t k = n == 1 ? cq.try_push(items[0])
+                       : cq.push_n(items.begin(), n);
+            if (k == 0) std::this_thread::yield();
+            return k;
+        },
+        [](ClosableQueue& cq, std::vector<size_t>& items) {
+            for ( ; ; ) {
+                bool closed = cq.closed;
+                size_t k = items.size() == 1
+                           ? cq.try_pop(items[0])
+                           : cq.pop_n(items.begin(), items.size());
+                if (k != 0 || closed) return k;
+                std::this_thread::yield();
+            }
+        });
+}
+
+static void test_blocking(size_t num_producers, size_t num_consumers,
+                          size_t batch) {
+    tlx::BlockingMpmcQueue<size_t> q(16);
+    run_threads(
+        num_producers, num_consumers, 100000, batch, q,
+        [](tlx::BlockingMpmcQueue<size_t>& bq,
+           std::vector<size_t>& items, size_t n) -> size_t {
+            if (n == 1) return bq.push(items[0]);
+            return bq.push_n(items.begin(), n);
+        },
+        [](tlx::BlockingMpmcQueue<size_t>& bq,
+           std::vector<size_t>& items) -> size_t {
+            if (items.size() == 1) return bq.pop(items[0]);
+            return bq.pop_n(items.begin(), items.size());
+        });
+
+    die_unless(q.closed());
+    die_unless(!q.push(0));
+}
+
+int main() {
+    test_single_thread();
+    test_allocator();
+    test_lock_free(1, 1, 1);
+    test_lock_free(4, 4, 1);
+    test_lock_free(3, 2, 7);
+    test_blocking(1, 1, 1);
+    test_blocking(4, 4, 1);
+    test_blocking(2, 3, 5);
+
+    return 0;
+}
+
+/******************************************************************************/
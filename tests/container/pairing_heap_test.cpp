@@ -0,0 +1,191 @@
+/*******************************************************************************
+ * tests/container/pairing_heap_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <functional>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tlx/container/pairing_heap.hpp>
+#include <tlx/die.hpp>
+
+using Heap = tlx::PairingHeap<size_t>;
+
+// a heap together with its reference multiset and the handles of all items
+struct Checked {
+    Heap heap;
+    std::multiset<size_t> ref;
+    std::vector<Heap::handle> handles;
+    std::unordered_map<Heap::handle, size_t> index;
+
+    void add(Heap::handle h) {
+        index[h] = handles.size();
+        handles.push_back(h);
+    }
+
+    void remove(Heap::handle h) {
+        size_t i = index[h];
+        handles[i] = handles.back();
+        index[handles[i]] = i;
+        handles.pop_back();
+        index.erase(h);
+    }
+
+    void check() {
+        die_unequal(ref.size(), heap.size());
+        die_unequal(ref.size(), handles.size());
+        if (!ref.empty())
+            die_unequal(*ref.begin(), heap.top());
+    }
+};
+
+static void test_random(size_t operations, size_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> dist(0, 1000000);
+
+    Checked h[2];
+
+    for (size_t i = 0; i < operations; ++i) {
+        Checked& c = h[rng() % 2];
+        unsigned op = rng() % 16;
+
+        if (op < 7 || c.ref.empty()) {
+            size_t x = dist(rng);
+            c.add(c.heap.push(x));
+            c.ref.insert(x);
+        }
+        else if (op < 10) {
+            c.remove(c.heap.top_handle());
+            die_unequal(*c.ref.begin(), c.heap.extract_top());
+            c.ref.erase(c.ref.begin());
+        }
+        else if (op < 13) {
+            // decrease a random item
+            Heap::handle p = c.handles[rng() % c.handles.size()];
+            size_t x = p->key(), y = x / 2;
+            c.heap.decrease_key(p, y);
+            c.ref.erase(c.ref.find(x));
+            c.ref.insert(y);
+        }
+        else if (op < 15) {
+            // erase a random item
+            Heap::handle p = c.handles[rng() % c.handles.size()];
+            c.ref.erase(c.ref.find(p->key()));
+            c.remove(p);
+            c.heap.erase(p);
+        }
+        else if (rng() % 16 == 0) {
+            // meld the other heap into this one
+            Checked& o = (&c == &h[0]) ? h[1] : h[0];
+            c.heap.meld(o.heap);
+            c.ref.insert(o.ref.begin(), o.ref.end());
+            for (Heap::handle x : o.handles)
+                c.add(x);
+            o.ref.clear();
+            o.handles.clear();
+            o.index.clear();
+            die_unless(o.heap.empty());
+        }
+
+        c.check();
+        if (i % 1000 == 0) {
+            die_unless(h[0].heap.sanity_check());
+            die_unless(h[1].heap.sanity_check());
+        }
+    }
+
+    for (Checked& c : h) {
+        die_unless(c.heap.sanity_check());
+        while (!c.ref.empty()) {
+            die_unequal(*c.ref.begin(), c.heap.extract_top());
+            c.ref.erase(c.ref.begin());
+        }
+        die_unless(c.heap.empty());
+    }
+}
+
+// non-trivial keys, move, clear, and node reuse
+static void test_strings() {
+    tlx::PairingHeap<std::string, std::greater<std::string> > a, b;
+    a.reserve(100);
+    for (size_t i = 0; i < 100; ++i) {
+        a.push(std::to_string(i));
+        b.push(std::to_string(i + 100));
+    }
+    a.meld(b);
+    die_unequal(200u, a.size());
+    die_unless(b.empty());
+
+    // b must still be usable after being melded
+    b.push("x");
+    die_unequal("x", b.top());
+
+    tlx::PairingHeap<std::string, std::greater<std::string> > c(std::move(a));
+    die_unless(a.empty());
+    die_unequal("99", c.extract_top());
+    die_unequal("98", c.extract_top());
+    c.clear();
+    die_unless(c.empty());
+    c.push("y");
+    die_unequal("y", c.top());
+
+    a = std::move(c);
+    die_unequal(1u, a.size());
+}
+
+// scheduler pattern: worker heaps are melded into a central heap, which is
+// drained. The node pool of the central heap must not grow with the total
+// number of items.
+static void test_meld_cycles(size_t cycles, size_t batch) {
+    tlx::PairingHeap<size_t> central, worker;
+    std::mt19937 rng(3);
+
+    size_t next = 0;
+    for (size_t c = 0; c < cycles; ++c) {
+        for (size_t i = 0; i < batch; ++i)
+            worker.push(next + rng() % batch);
+        for (size_t i = 0; i < batch / 4; ++i)
+            central.push(next + rng() % batch);
+        next += batch;
+
+        central.meld(worker);
+        die_unless(worker.empty());
+        die_unequal(0u, worker.capacity());
+
+        // keep a backlog of items in the central heap
+        size_t last = 0;
+        while (central.size() > batch / 2) {
+            die_unless(last <= central.top());
+            last = central.extract_top();
+        }
+        die_unless(central.sanity_check());
+        die_unless(central.capacity() <= 32 * batch);
+    }
+
+    // shrink() releases all slabs of an empty heap
+    central.clear();
+    central.shrink();
+    die_unequal(0u, central.capacity());
+    central.push(1);
+    die_unequal(1u, central.top());
+}
+
+int main() {
+    test_random(1000, 1);
+    test_random(100000, 2);
+    test_strings();
+    test_meld_cycles(1000, 1000);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -11,6 +11,9 @@
 #include <tlx/container/ring_buffer.hpp>
 #include <tlx/die.hpp>
 
+#include <string>
+#include <vector>
+
 static void test_fill_circular(size_t rb_size) {
 
     tlx::RingBuffer<size_t> ring(rb_size);
@@ -112,6 +115,81 @@ static void test_non_default_constructible() {
     die_unequal(1, ring[3].i1);
 }
 
+template <typename Type, typename Make>
+static void test_bulk(Make make) {
+
+    tlx::RingBuffer<Type> ring(20);
+    die_unequal(32u, ring.capacity());
+
+    // move begin close to the end of the array
+    for (size_t i = 0; i < 28; ++i) {
+        ring.push_back(make(0));
+        ring.pop_front();
+    }
+    die_unless(ring.peek_segments().first.size == 0);
+    die_unless(ring.peek_segments().second.size == 0);
+
+    // push a range which wraps around
+    std::vector<Type> in;
+    for (size_t i = 0; i < 10; ++i)
+        in.push_back(make(i));
+    ring.push_back_range(in.data(), 10);
+    die_unequal(10u, ring.size());
+    for (size_t i = 0; i < 10; ++i)
+        die_unequal(make(i), ring[i]);
+
+    // check segments
+    auto seg = ring.peek_segments();
+    die_unequal(4u, seg.first.size);
+    die_unequal(6u, seg.second.size);
+    die_unequal(make(0), *seg.first.begin());
+    die_unequal(make(4), *seg.second.begin());
+    die_unequal(make(9), seg.second.end()[-1]);
+
+    const tlx::RingBuffer<Type>& cring = ring;
+    die_unequal(make(3), cring.peek_segments().first.data[3]);
+
+    // copy out without removing
+    std::vector<Type> out(12, make(99));
+    die_unequal(10u, ring.copy_to(out.data(), out.size()));
+    die_unequal(make(9), out[9]);
+    die_unequal(make(99), out[10]);
+    die_unequal(3u, ring.copy_to(out.data(), 3));
+
+    std::vector<Type> vec(1, make(42));
+    ring.copy_to(&vec);
+    die_unequal(11u, vec.size());
+    die_unequal(make(42), vec[0]);
+    die_unequal(make(9), vec[10]);
+    die_unequal(10u, ring.size());
+
+    // pop items into an array
+    die_unequal(5u, ring.pop_front_into(out.data(), 5));
+    die_unequal(make(4), out[4]);
+    die_unequal(5u, ring.size());
+    die_unequal(make(5), ring.front());
+    die_unequal(5u, ring.pop_front_into(out.data(), 12));
+    die_unequal(make(9), out[4]);
+    die_unless(ring.empty());
+    die_unequal(0u, ring.pop_front_into(out.data(), 12));
+
+    // cycle with bulk operations of varying size
+    size_t next_push = 0, next_pop = 0;
+    for (size_t j = 0; j < 100; ++j) {
+        size_t n = (j * 7) % 13;
+        if (ring.size() + n > ring.max_size())
+            n = ring.max_size() - ring.size();
+        in.clear();
+        for (size_t i = 0; i < n; ++i)
+            in.push_back(make(next_push++));
+        ring.push_back_range(in.data(), n);
+
+        size_t m = ring.pop_front_into(out.data(), (j * 5) % 12);
+        for (size_t i = 0; i < m; ++i)
+            die_unequal(make(next_pop++), out[i]);
+    }
+}
+
 namespace tlx {
 
 template class RingBuffer<size_t>;
@@ -124,6 +202,8 @@ int main() {
     test_fill_circular(16);
     test_fill_circular(20);
     test_non_default_constructible();
+    test_bulk<size_t>([](size_t i) { return i; });
+    test_bulk<std::string>([](size_t i) { return std::to_string(i); });
 
     return 0;
 }
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * tests/container/sequence_heap_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tlx/container/sequence_heap.hpp>
+#include <tlx/die.hpp>
+
+// compare a SequenceHeap against std::priority_queue with random operations
+template <typename Heap>
+void test_random(size_t operations, size_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<unsigned> dist(0, 100000);
+
+    Heap heap;
+    std::priority_queue<unsigned, std::vector<unsigned>,
+                        std::greater<unsigned> > ref;
+
+    for (size_t i = 0; i < operations; ++i) {
+        // first fill, then alternate, then drain
+        unsigned r = rng() % 8;
+        bool do_push = i < operations / 3 ? r != 0
+                       : i < 2 * operations / 3 ? r < 4 : r == 0;
+
+        if (do_push || ref.empty()) {
+            unsigned x = dist(rng);
+            heap.push(x);
+            ref.push(x);
+        }
+        else {
+            die_unequal(ref.top(), heap.top());
+            heap.pop();
+            ref.pop();
+        }
+
+        die_unequal(ref.size(), heap.size());
+        if (i % (operations / 200 + 1) == 0)
+            die_unless(heap.sanity_check());
+    }
+    die_unless(heap.sanity_check());
+
+    // copy and drain both
+    Heap copy = heap;
+    while (!ref.empty()) {
+        die_unequal(ref.top(), heap.top());
+        die_unequal(ref.top(), copy.extract_top());
+        heap.pop();
+        ref.pop();
+    }
+    die_unless(heap.empty());
+    die_unless(copy.empty());
+}
+
+// keys that are inserted in order, reverse order, and with many duplicates
+template <typename Heap>
+void test_patterns(size_t n) {
+    Heap heap;
+
+    for (size_t i = 0; i < n; ++i)
+        heap.push(static_cast<unsigned>(i));
+    die_unless(heap.sanity_check());
+    for (size_t i = 0; i < n; ++i)
+        die_unequal(i, heap.extract_top());
+    die_unless(heap.empty());
+    die_unequal(0u, heap.num_groups());
+
+    for (size_t i = 0; i < n; ++i)
+        heap.push(static_cast<unsigned>(n - i));
+    for (size_t i = 1; i <= n; ++i)
+        die_unequal(i, heap.extract_top());
+
+    std::vector<unsigned> dups;
+    for (size_t i = 0; i < n; ++i) {
+        dups.push_back(static_cast<unsigned>(i % 7));
+        heap.push(dups.back());
+    }
+    std::sort(dups.begin(), dups.end());
+    for (size_t i = 0; i < n; ++i)
+        die_unequal(dups[i], heap.extract_top());
+    die_unless(heap.empty());
+
+    // build_heap and clear
+    std::vector<unsigned> keys;
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(static_cast<unsigned>((i * 7919) % n));
+    heap.build_heap(keys);
+    die_unequal(n, heap.size());
+    die_unless(heap.sanity_check());
+    heap.push(0);
+    die_unequal(0u, heap.extract_top());
+    for (size_t i = 0; i < n / 2; ++i)
+        die_unequal(i, heap.extract_top());
+    heap.clear();
+    die_unless(heap.empty());
+}
+
+// strings with a custom comparator
+void test_strings() {
+    tlx::SequenceHeap<std::string, 3, std::greater<std::string>, 5> heap;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < 500; ++i)
+        keys.push_back(std::to_string(i * 31 % 500));
+
+    for (const std::string& k : keys)
+        heap.push(k);
+    die_unless(heap.sanity_check());
+
+    std::sort(keys.begin(), keys.end(), std::greater<std::string>());
+    for (const std::string& k : keys)
+        die_unequal(k, heap.extract_top());
+}
+
+// update_all() after the order of the compare function was reversed
+struct FlipLess {
+    const bool* flip;
+    bool operator () (unsigned a, unsigned b) const {
+        return *flip ? b < a : a < b;
+    }
+};
+
+void test_update_all(size_t n) {
+    bool flip = false;
+    tlx::SequenceHeap<unsigned, 3, FlipLess, 8> heap(FlipLess { &flip });
+
+    std::vector<unsigned> keys;
+    for (size_t i = 0; i < n; ++i) {
+        keys.push_back(static_cast<unsigned>((i * 7919) % n));
+        heap.push(keys.back());
+    }
+    std::sort(keys.begin(), keys.end());
+
+    // remove and reinsert the smallest quarter, such that items are in the
+    // insertion heap, the buffers, and the sequences
+    for (size_t i = 0; i < n / 4; ++i)
+        die_unequal(keys[i], heap.extract_top());
+    for (size_t i = 0; i < n / 4; ++i)
+        heap.push(keys[i]);
+    die_unequal(n, heap.size());
+
+    flip = true;
+    heap.update_all();
+    die_unless(heap.sanity_check());
+    die_unequal(n, heap.size());
+    for (size_t i = n; i-- > 0; )
+        die_unequal(keys[i], heap.extract_top());
+    die_unless(heap.empty());
+
+    heap.update_all();
+    die_unless(heap.empty());
+}
+
+int main() {
+    // tiny buffers and arity to create many groups
+    test_patterns<tlx::SequenceHeap<unsigned, 2, std::less<unsigned>, 4> >(
+        1000);
+    test_patterns<tlx::SequenceHeap<unsigned, 4, std::less<unsigned>, 16> >(
+        10000);
+    test_patterns<tlx::SequenceHeap<unsigned> >(100000);
+
+    test_random<tlx::SequenceHeap<unsigned, 2, std::less<unsigned>, 4> >(
+        20000, 1);
+    test_random<tlx::SequenceHeap<unsigned, 3, std::less<unsigned>, 7> >(
+        50000, 2);
+    test_random<tlx::SequenceHeap<unsigned, 16, std::less<unsigned>, 32> >(
+        100000, 3);
+    test_random<tlx::SequenceHeap<unsigned> >(200000, 4);
+
+    test_strings();
+    test_update_all(10);
+    test_update_all(10000);
+
+    return 0;
+}
+
+/******************************************************************************/
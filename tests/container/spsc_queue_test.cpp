@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * tests/container/spsc_queue_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/container/spsc_queue.hpp>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+namespace tlx {
+
+// instantiations
+template class SpscQueue<size_t>;
+template class BlockingSpscQueue<size_t>;
+
+} // namespace tlx
+
+static void test_single_thread() {
+    tlx::SpscQueue<std::string> q(5);
+    die_unequal(8u, q.capacity());
+    die_unless(q.empty());
+    die_unless(q.front() == nullptr);
+
+    std::string s;
+    die_unless(!q.try_pop(s));
+
+    // wrap around several times
+    size_t next_push = 0, next_pop = 0;
+    for (size_t round = 0; round < 10; ++round) {
+        while (q.try_push(std::to_string(next_push)))
+            ++next_push;
+        die_unequal(8u, q.size());
+        die_unless(!q.try_emplace("x"));
+
+        for (size_t i = 0; i < 5; ++i) {
+            die_unless(q.try_pop(s));
+            die_unequal(std::to_string(next_pop++), s);
+        }
+        die_unequal(3u, q.size());
+    }
+
+    // batch operations
+    std::vector<std::string> in = { "a", "b", "c", "d", "e", "f" };
+    die_unequal(5u, q.push_n(in.begin(), in.size()));
+    die_unequal(std::to_string(next_pop), *q.front());
+
+    std::vector<std::string> out(10);
+    die_unequal(2u, q.pop_n(out.begin(), 2));
+    die_unequal(std::to_string(next_pop + 1), out[1]);
+    die_unequal(6u, q.pop_n(out.begin(), 10));
+    die_unequal(std::to_string(next_pop + 2), out[0]);
+    die_unequal("a", out[1]);
+    die_unequal("e", out[5]);
+    die_unless(q.empty());
+    die_unequal(0u, q.pop_n(out.begin(), 10));
+
+    // destructor destroys remaining items
+    q.push_n(in.begin(), 3);
+}
+
+static void test_threads(size_t count, size_t batch) {
+    tlx::SpscQueue<size_t> q(64);
+
+    std::thread producer(
+        [&]() {
+            std::vector<size_t> items(batch);
+            size_t i = 0;
+            while (i < count) {
+                size_t n = std::min(batch, count - i);
+                for (size_t j = 0; j < n; ++j)
+                    items[j] = i + j;
+                size_t k = q.push_n(items.begin(), n);
+                if (k == 0) std::this_thread::yield();
+                i += k;
+            }
+        });
+
+    std::vector<size_t> items(batch);
+    size_t expected = 0;
+    while (expected < count) {
+        size_t n = q.pop_n(items.begin(), batch);
+        if (n == 0) std::this_thread::yield();
+        for (size_t j = 0; j < n; ++j)
+            die_unequal(expected++, items[j]);
+    }
+    producer.join();
+    die_unless(q.empty());
+}
+
+static void test_blocking(size_t count) {
+    tlx::BlockingSpscQueue<size_t> q(16);
+
+    std::thread producer(
+        [&]() {
+            for (size_t i = 0; i < count / 2; ++i)
+                die_unless(q.push(i));
+            std::vector<size_t> items;
+            for (size_t i = count / 2; i < count; ++i)
+                items.push_back(i);
+            die_unequal(items.size(), q.push_n(items.begin(), items.size()));
+            q.close();
+            die_unless(!q.push(0));
+        });
+
+    size_t expected = 0, x;
+    while (expected < count / 3) {
+        die_unless(q.pop(x));
+        die_unequal(expected++, x);
+    }
+    std::vector<size_t> items(7);
+    while (size_t n = q.pop_n(items.begin(), items.size())) {
+        for (size_t j = 0; j < n; ++j)
+            die_unequal(expected++, items[j]);
+    }
+    die_unequal(count, expected);
+    die_unless(!q.pop(x));
+    producer.join();
+}
+
+int main() {
+    test_single_thread();
+    test_threads(1000000, 1);
+    test_threads(1000000, 13);
+    test_blocking(100000);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * tests/container/timer_wheel_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/container/timer_wheel.hpp>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+namespace tlx {
+
+// instantiation
+template class TimerWheel<size_t>;
+
+} // namespace tlx
+
+static void test_simple() {
+    tlx::TimerWheel<size_t> wheel(100);
+    die_unless(wheel.empty());
+    die_unequal(wheel.next_event(), uint64_t(-1));
+
+    wheel.schedule(110, 1);
+    wheel.schedule(105, 2);
+    tlx::TimerWheel<size_t>::handle h = wheel.schedule(107, 3);
+    wheel.schedule(50, 4);
+    die_unequal(4u, wheel.size());
+    die_unequal(107u, wheel.expiry(h));
+    die_unequal(3u, wheel.payload(h));
+
+    std::vector<size_t> fired;
+    auto collect = [&](size_t p) { fired.push_back(p); };
+
+    // the timer in the past fires on the next tick
+    die_unequal(1u, wheel.advance(101, collect));
+    die_unequal(4u, fired.back());
+
+    wheel.cancel(h);
+    die_unless(!wheel.is_scheduled(h));
+    die_unequal(0u, wheel.advance(104, collect));
+    die_unequal(104u, wheel.now());
+
+    die_unequal(2u, wheel.advance(200, collect));
+    die_unequal(3u, fired.size());
+    die_unequal(2u, fired[1]);
+    die_unequal(1u, fired[2]);
+    die_unless(wheel.empty());
+    die_unequal(200u, wheel.now());
+}
+
+static void test_reschedule_in_callback() {
+    tlx::TimerWheel<size_t> wheel;
+    wheel.schedule(10, 0);
+
+    // each firing schedules the next timer 10 ticks later
+    size_t count = 0;
+    wheel.advance(1000, [&](size_t p) {
+                      die_unequal(count, p);
+                      ++count;
+                      wheel.schedule(wheel.now() + 10, p + 1);
+                  });
+    die_unequal(100u, count);
+    die_unequal(1u, wheel.size());
+    die_unequal(1010u, wheel.next_event());
+}
+
+//! random timers over several levels and the overflow list
+static void test_random(uint64_t max_delay, uint64_t max_step) {
+    tlx::TimerWheel<size_t> wheel(12345);
+    using handle = tlx::TimerWheel<size_t>::handle;
+
+    // reference: expiry -> id, and handle of each id
+    std::multimap<uint64_t, size_t> ref;
+    std::vector<handle> handles;
+    std::vector<uint64_t> expiry;
+    std::mt19937_64 rng(max_delay);
+
+    for (size_t round = 0; round < 2000; ++round) {
+        // schedule some timers
+        for (size_t i = 0; i < 4; ++i) {
+            uint64_t e = wheel.now() + 1 + rng() % max_delay;
+            size_t id = handles.size();
+            handles.push_back(wheel.schedule(e, id));
+            expiry.push_back(e);
+            ref.emplace(e, id);
+        }
+
+        // cancel or reschedule a random pending timer
+        if (!ref.empty() && rng() % 2 == 0) {
+            std::multimap<uint64_t, size_t>::iterator it = ref.begin();
+            std::advance(it, rng() % ref.size());
+            size_t id = it->second;
+            ref.erase(it);
+            if (rng() % 2 == 0) {
+                wheel.cancel(handles[id]);
+            }
+            else {
+                uint64_t e = wheel.now() + 1 + rng() % max_delay;
+                wheel.reschedule(handles[id], e);
+                expiry[id] = e;
+                ref.emplace(e, id);
+            }
+        }
+
+        // advance, timers must fire in order of expiry
+        uint64_t now = wheel.now() + rng() % max_step;
+        uint64_t last = 0;
+        size_t n = wheel.advance(
+            now, [&](size_t id) {
+                die_unless(expiry[id] <= now);
+                die_unless(expiry[id] >= last);
+                last = expiry[id];
+                std::multimap<uint64_t, size_t>::iterator it =
+                    ref.find(expiry[id]);
+                while (it->second != id) ++it;
+                ref.erase(it);
+            });
+        die_unless(n <= 4 * round + 4);
+        die_unless(ref.empty() || ref.begin()->first > now);
+        die_unequal(ref.size(), wheel.size());
+    }
+
+    // drain
+    wheel.advance(uint64_t(-1) / 2, [&](size_t) { });
+    die_unless(wheel.empty());
+}
+
+int main() {
+    test_simple();
+    test_reschedule_in_callback();
+    test_random(100, 10);
+    test_random(10000, 1000);
+    test_random(1000000, 100000);
+    test_random(uint64_t(1) << 30, uint64_t(1) << 26);
+
+    return 0;
+}
+
+/******************************************************************************/
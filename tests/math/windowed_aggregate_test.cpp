@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * tests/math/windowed_aggregate_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/math/windowed_aggregate.hpp>
+
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+//! compare against an Aggregate rebuilt over the window
+template <typename Type>
+static void check_window(const tlx::WindowedAggregate<Type>& win,
+                         const std::vector<Type>& values, size_t begin) {
+    tlx::Aggregate<Type> agg;
+    for (size_t i = begin; i < values.size(); ++i)
+        agg.add(values[i]);
+
+    die_unequal(agg.count(), win.count());
+    die_unequal(agg.min(), win.min());
+    die_unequal(agg.max(), win.max());
+    die_unequal_eps6(agg.average(), win.average());
+    die_unequal_eps6(agg.standard_deviation(), win.standard_deviation());
+    die_unequal_eps6(agg.standard_deviation(0), win.standard_deviation(0));
+}
+
+static void test_count_window() {
+    tlx::WindowedAggregate<int> win(30);
+    die_unless(win.empty());
+    die_unequal(30u, win.window_size());
+
+    std::vector<int> values;
+    std::default_random_engine rng(1234);
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+
+    for (size_t i = 0; i < 2000; ++i) {
+        values.push_back(dist(rng));
+        win.add(values.back());
+        check_window(win, values, values.size() - win.count());
+    }
+    die_unequal(30u, win.count());
+
+    // sorted runs exercise the monotonic queues
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(i);
+        win.add(i);
+    }
+    check_window(win, values, values.size() - 30);
+    die_unequal(70, win.min());
+    die_unequal(99, win.max());
+    die_unequal(29, win.span());
+    die_unequal((70 + 99) * 30 / 2, win.sum());
+
+    tlx::Aggregate<int> agg = win.aggregate();
+    die_unequal(30u, agg.count());
+    die_unequal_eps6(84.5, agg.average());
+    die_unequal_eps6(win.standard_deviation(), agg.standard_deviation());
+
+    // evict explicitly
+    for (size_t i = 0; i < 29; ++i)
+        win.evict();
+    die_unequal(1u, win.count());
+    die_unequal(99, win.min());
+    die_unequal(99, win.max());
+    die_unequal_eps6(99.0, win.average());
+    die_unequal_eps6(0.0, win.variance());
+
+    win.clear();
+    die_unless(win.empty());
+    win.add(5);
+    die_unequal(5, win.min());
+    die_unequal_eps6(5.0, win.mean());
+}
+
+static void test_time_window() {
+    tlx::WindowedAggregate<double> win(100, 10.0);
+    die_unless(win.time_based());
+
+    std::vector<double> values;
+    std::vector<double> times;
+    std::default_random_engine rng(5678);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+    double now = 0.0;
+    for (size_t i = 0; i < 2000; ++i) {
+        now += dist(rng);
+        values.push_back(dist(rng) * 100.0);
+        times.push_back(now);
+        win.add(now, values.back());
+
+        // the window holds all values of the last 10 time units
+        size_t begin = values.size();
+        while (begin > 0 && times[begin - 1] + 10.0 > now)
+            --begin;
+        check_window(win, values, begin);
+    }
+
+    // advancing the time evicts old values
+    win.advance(now + 5.0);
+    die_unless(win.count() > 0);
+    win.advance(now + 10.0);
+    die_unless(win.empty());
+    die_unequal_eps6(0.0, win.average());
+
+    // the window is also limited by the number of values
+    tlx::WindowedAggregate<double> small(4, 100.0);
+    for (size_t i = 0; i < 10; ++i)
+        small.add(static_cast<double>(i), static_cast<double>(i));
+    die_unequal(4u, small.count());
+    die_unequal(6.0, small.min());
+    die_unequal(9.0, small.max());
+}
+
+int main() {
+    test_count_window();
+    test_time_window();
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,190 @@
+/*******************************************************************************
+ * tests/sort_external_sorter_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/sort/external_sorter.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+/******************************************************************************/
+// count allocated bytes to check the memory budget
+
+static std::atomic<size_t> s_heap_current { 0 };
+static std::atomic<size_t> s_heap_peak { 0 };
+
+void* operator new (size_t size) {
+    // prefix each allocation with its size
+    size_t* p = static_cast<size_t*>(std::malloc(size + sizeof(max_align_t)));
+    if (!p) throw std::bad_alloc();
+    *p = size;
+    size_t current = (s_heap_current += size);
+    size_t peak = s_heap_peak;
+    while (current > peak && !s_heap_peak.compare_exchange_weak(peak, current))
+    { }
+    return reinterpret_cast<char*>(p) + sizeof(max_align_t);
+}
+
+void* operator new[] (size_t size) {
+    return operator new (size);
+}
+
+void operator delete (void* ptr) noexcept {
+    if (!ptr) return;
+    size_t* p = reinterpret_cast<size_t*>(
+        static_cast<char*>(ptr) - sizeof(max_align_t));
+    s_heap_current -= *p;
+    std::free(p);
+}
+
+void operator delete[] (void* ptr) noexcept {
+    operator delete (ptr);
+}
+
+void operator delete (void* ptr, size_t) noexcept {
+    operator delete (ptr);
+}
+
+void operator delete[] (void* ptr, size_t) noexcept {
+    operator delete (ptr);
+}
+
+/******************************************************************************/
+
+struct Record {
+    uint32_t key;
+    uint32_t id;
+    char payload[24];
+
+    bool operator < (const Record& other) const {
+        return key < other.key;
+    }
+};
+
+//! sort n records with the given memory budget and check the output
+static void test_records(size_t n, size_t memory_bytes, size_t min_runs) {
+    tlx::ExternalSorter<Record> sorter(memory_bytes, std::less<Record>(), 4);
+
+    std::mt19937 rng(n);
+    std::vector<uint32_t> keys;
+    for (size_t i = 0; i < n; ++i) {
+        Record r;
+        r.key = rng() % 100000;
+        r.id = static_cast<uint32_t>(i);
+        std::fill(r.payload, r.payload + sizeof(r.payload),
+                  static_cast<char>(r.key));
+        keys.push_back(r.key);
+        sorter.push(r);
+    }
+    die_unequal(n, sorter.size());
+    die_unless(sorter.num_runs() >= min_runs);
+    std::sort(keys.begin(), keys.end());
+
+    size_t i = 0;
+    std::vector<bool> seen(n);
+    size_t total = sorter.sort(
+        [&](const Record* data, size_t size) {
+            die_unless(size <= memory_bytes / sizeof(Record) / 5);
+            for (size_t j = 0; j < size; ++j, ++i) {
+                die_unequal(keys[i], data[j].key);
+                die_unequal(static_cast<char>(data[j].key), data[j].payload[7]);
+                die_unless(!seen[data[j].id]);
+                seen[data[j].id] = true;
+            }
+        });
+    die_unequal(n, total);
+    die_unequal(n, i);
+    die_unequal(0u, sorter.size());
+}
+
+//! the merge must stay within the memory budget, and the sorter can be reused
+static void test_memory_budget(size_t n, size_t memory_bytes) {
+    tlx::ExternalSorter<uint64_t> sorter(
+        memory_bytes, std::less<uint64_t>(), 2);
+
+    for (size_t round = 0; round < 2; ++round) {
+        std::mt19937_64 rng(round);
+        for (size_t i = 0; i < n; ++i)
+            sorter.push(rng());
+        die_unless(sorter.num_runs() >= 4);
+
+        // the run buffers are allocated, sort() may replace them by merge
+        // blocks of the same total size.
+        size_t baseline = s_heap_current;
+        s_heap_peak = baseline;
+
+        uint64_t last = 0;
+        size_t total = sorter.sort(
+            [&](const uint64_t* data, size_t size) {
+                for (size_t j = 0; j < size; ++j) {
+                    die_unless(last <= data[j]);
+                    last = data[j];
+                }
+            });
+        die_unequal(n, total);
+        // allow for the scratch space of sorting the last run, which does not
+        // depend on the budget, but not for a second set of buffers.
+        die_unless(s_heap_peak <= baseline + memory_bytes / 8 + 64 * 1024);
+    }
+}
+
+//! sort integers into a file in a temporary directory
+static void test_file(size_t n) {
+    std::string dir = ".";
+    std::string path = dir + "/tlx_external_sorter_test.out";
+
+    tlx::ExternalSorter<uint64_t, std::greater<uint64_t> > sorter(
+        256 * 1024, std::greater<uint64_t>(), 2, dir);
+
+    std::vector<uint64_t> in(n);
+    std::mt19937_64 rng(42);
+    for (size_t i = 0; i < n; ++i)
+        in[i] = rng();
+    sorter.push(in.data(), in.size());
+    die_unless(sorter.num_runs() >= 8);
+
+    die_unequal(n, sorter.sort_to_file(path));
+
+    std::vector<uint64_t> out(n + 1);
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    die_unless(f);
+    die_unequal(n, std::fread(out.data(), sizeof(uint64_t), n + 1, f));
+    std::fclose(f);
+    std::remove(path.c_str());
+    out.resize(n);
+
+    std::sort(in.begin(), in.end(), std::greater<uint64_t>());
+    die_unless(in == out);
+}
+
+int main() {
+    // in memory only
+    test_records(0, 1024 * 1024, 0);
+    test_records(1000, 1024 * 1024, 0);
+    // a few runs, merged in a single pass
+    test_records(100000, 1024 * 1024, 5);
+    // many runs with a tiny budget, merged in multiple passes
+    test_records(50000, 64 * 1024, 40);
+    test_file(300000);
+    // single pass and multiple passes
+    test_memory_budget(400000, 1024 * 1024);
+    test_memory_budget(400000, 128 * 1024);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -13,12 +13,14 @@
 #include <functional>
 #include <iostream>
 #include <random>
+#include <utility>
 #include <vector>
 
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
 
 #include <tlx/sort/parallel_mergesort.hpp>
+#include <tlx/thread_pool.hpp>
 
 struct Something {
     int a, b;
@@ -61,7 +63,120 @@ void test_size(unsigned int size, tlx::MultiwayMergeSplittingAlgorithm mwmsa) {
     die_unless(std::is_sorted(v.cbegin(), v.cend(), cmp));
 }
 
+//! stable sort with exact splitting of few distinct keys: the splitters fall
+//! into runs of equal keys, which must be split in order of the sequences.
+void test_stable_exact(unsigned int size, size_t num_threads) {
+    std::vector<std::pair<unsigned, unsigned> > v(size);
+    std::mt19937 randgen(size);
+    for (unsigned int i = 0; i < size; ++i)
+        v[i] = std::make_pair(static_cast<unsigned>(randgen() % 5), i);
+
+    auto cmp = [](const std::pair<unsigned, unsigned>& a,
+                  const std::pair<unsigned, unsigned>& b) {
+                   return a.first < b.first;
+               };
+    tlx::stable_parallel_mergesort(
+        v.begin(), v.end(), cmp, num_threads, tlx::MWMSA_EXACT);
+
+    for (unsigned int i = 1; i < size; ++i) {
+        die_unless(v[i - 1].first <= v[i].first);
+        if (v[i - 1].first == v[i].first)
+            die_unless(v[i - 1].second < v[i].second);
+    }
+}
+
+//! sort many small sequences on one shared ThreadPool, and check stability
+template <bool Stable>
+void test_pool(tlx::ThreadPool& pool,
+               tlx::MultiwayMergeSplittingAlgorithm mwmsa) {
+    std::mt19937 randgen(654321);
+
+    for (unsigned int size = 0; size < 20000; size += 1 + size / 4)
+    {
+        std::vector<Something> v(size);
+        for (unsigned int i = 0; i < size; ++i) {
+            v[i].a = static_cast<int>(randgen() % (size / 8 + 1));
+            v[i].b = static_cast<int>(i);
+        }
+
+        if (Stable) {
+            tlx::stable_parallel_mergesort(
+                v.begin(), v.end(), std::less<Something>(), pool, mwmsa);
+        }
+        else {
+            tlx::parallel_mergesort(
+                v.begin(), v.end(), std::less<Something>(), pool, mwmsa);
+        }
+
+        die_unless(std::is_sorted(v.cbegin(), v.cend()));
+
+        if (!Stable) continue;
+        for (unsigned int i = 1; i < size; ++i) {
+            if (v[i - 1].a == v[i].a)
+                die_unless(v[i - 1].b < v[i].b);
+        }
+    }
+}
+
+//! sort with a small merge buffer, and check stability of the stable variant
+template <bool Stable>
+void test_bounded(unsigned int size, size_t num_threads, size_t buffer_size) {
+    std::mt19937 randgen(123456 + size);
+
+    std::vector<Something> v(size);
+    for (unsigned int i = 0; i < size; ++i) {
+        v[i].a = static_cast<int>(randgen() % (size / 4 + 1));
+        v[i].b = static_cast<int>(i);
+    }
+
+    if (Stable) {
+        tlx::stable_parallel_mergesort_bounded(
+            v.begin(), v.end(), std::less<Something>(),
+            num_threads, buffer_size);
+    }
+    else {
+        tlx::parallel_mergesort_bounded(
+            v.begin(), v.end(), std::less<Something>(),
+            num_threads, buffer_size);
+    }
+
+    die_unless(std::is_sorted(v.cbegin(), v.cend()));
+
+    // check that v is a permutation, and the order of equal items if stable
+    std::vector<bool> seen(size);
+    for (unsigned int i = 0; i < size; ++i) {
+        die_unless(!seen[v[i].b]);
+        seen[v[i].b] = true;
+        if (Stable && i != 0 && v[i - 1].a == v[i].a)
+            die_unless(v[i - 1].b < v[i].b);
+    }
+}
+
 int main() {
+    for (unsigned int size : { 0, 1, 2, 10, 100, 1000, 12345, 200000 }) {
+        for (size_t num_threads : { 1, 3, 8 }) {
+            for (size_t buffer_size : { 1, 7, 100, 0 }) {
+                test_bounded<false>(size, num_threads, buffer_size);
+                test_bounded<true>(size, num_threads, buffer_size);
+            }
+        }
+    }
+
+    for (unsigned int size : { 10, 1000, 100000 }) {
+        for (size_t num_threads : { 2, 3, 8 })
+            test_stable_exact(size, num_threads);
+    }
+
+    {
+        tlx::ThreadPool pool(4);
+        for (size_t round = 0; round < 4; ++round) {
+            test_pool<false>(pool, tlx::MWMSA_SAMPLING);
+            test_pool<true>(pool, tlx::MWMSA_SAMPLING);
+            test_pool<false>(pool, tlx::MWMSA_EXACT);
+            test_pool<true>(pool, tlx::MWMSA_EXACT);
+        }
+    }
+
     // run multiway mergesort tests for 0..256 sequences
     for (unsigned int i = 0; i < 256; ++i)
     {
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * tests/sort_parallel_samplesort_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/sort/parallel_samplesort.hpp>
+
+#include <tlx/die.hpp>
+#include <tlx/thread_pool.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+//! large record, sorted by key only
+struct Record {
+    uint32_t key;
+    char payload[60];
+
+    bool operator < (const Record& b) const { return key < b.key; }
+};
+
+enum class Input { Random, FewKeys, Skewed, Equal, Sorted, Reverse };
+
+template <typename Type, typename Comparator>
+void check(const std::vector<Type>& input, std::vector<Type>& v,
+           const Comparator& comp) {
+    std::vector<Type> correct = input;
+    std::sort(correct.begin(), correct.end(), comp);
+
+    die_unequal(correct.size(), v.size());
+    die_unless(std::is_sorted(v.begin(), v.end(), comp));
+    for (size_t i = 0; i < v.size(); ++i) {
+        // all items, including equal ones, must be present
+        die_unless(!comp(correct[i], v[i]) && !comp(v[i], correct[i]));
+    }
+}
+
+std::vector<uint64_t> generate(size_t size, Input input, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> v(size);
+    for (size_t i = 0; i < size; ++i) {
+        switch (input) {
+        case Input::Random:
+            v[i] = rng();
+            break;
+        case Input::FewKeys:
+            v[i] = rng() % 7;
+            break;
+        case Input::Skewed:
+            // many small and some large buckets
+            v[i] = (i % 10 != 0) ? rng() % 10 : rng();
+            break;
+        case Input::Equal:
+            v[i] = 42;
+            break;
+        case Input::Sorted:
+            v[i] = i;
+            break;
+        case Input::Reverse:
+            v[i] = size - i;
+            break;
+        }
+    }
+    return v;
+}
+
+void test_integers(size_t size, Input input, size_t num_threads) {
+    std::vector<uint64_t> input_v =
+        generate(size, input, static_cast<unsigned>(size));
+
+    std::vector<uint64_t> v = input_v;
+    tlx::parallel_samplesort(v.begin(), v.end(), std::less<uint64_t>(),
+                             num_threads);
+    check(input_v, v, std::less<uint64_t>());
+
+    v = input_v;
+    tlx::samplesort(v.begin(), v.end(), std::greater<uint64_t>());
+    check(input_v, v, std::greater<uint64_t>());
+}
+
+void test_strings(size_t size, size_t num_threads) {
+    std::mt19937 rng(123456);
+    std::vector<std::string> input(size);
+    for (size_t i = 0; i < size; ++i)
+        input[i] = std::to_string(rng() % (size / 2 + 1)) + "abcdefghijklmnop";
+
+    std::vector<std::string> v = input;
+    tlx::parallel_samplesort(v.begin(), v.end(), std::less<std::string>(),
+                             num_threads);
+    check(input, v, std::less<std::string>());
+}
+
+void test_records(size_t size, tlx::ThreadPool& pool) {
+    std::mt19937 rng(654321);
+    std::vector<Record> input(size);
+    for (size_t i = 0; i < size; ++i) {
+        input[i].key = rng() % 100000;
+        std::fill(input[i].payload, input[i].payload + 60,
+                  static_cast<char>(input[i].key));
+    }
+
+    std::vector<Record> v = input;
+    tlx::parallel_samplesort(v.begin(), v.end(), std::less<Record>(), pool);
+    check(input, v, std::less<Record>());
+
+    // the payload must have been moved together with the key
+    for (const Record& r : v)
+        die_unequal(static_cast<char>(r.key), r.payload[59]);
+}
+
+int main() {
+    for (size_t size : { 0, 1, 2, 100, 1000, 5000, 100000, 1000000 }) {
+        for (size_t num_threads : { 1, 2, 3, 8 }) {
+            test_integers(size, Input::Random, num_threads);
+            test_integers(size, Input::FewKeys, num_threads);
+            test_integers(size, Input::Skewed, num_threads);
+            test_integers(size, Input::Equal, num_threads);
+            test_integers(size, Input::Sorted, num_threads);
+            test_integers(size, Input::Reverse, num_threads);
+        }
+    }
+
+    test_strings(200000, 4);
+
+    {
+        // sort repeatedly on a shared pool
+        tlx::ThreadPool pool(4);
+        for (size_t size = 0; size < 300000; size = 3 * size + 1000)
+            test_records(size, pool);
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,153 @@
+/*******************************************************************************
+ * tests/sort_radix_sort_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/sort/radix_sort.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+//! generate keys with few distinct high or low bytes, and the extreme values
+template <typename Key>
+std::vector<Key> generate(size_t size, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<Key> v(size);
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t r = rng();
+        switch (i % 4) {
+        case 0:
+            v[i] = static_cast<Key>(r);
+            break;
+        case 1:
+            v[i] = static_cast<Key>(r % 1000);
+            break;
+        case 2:
+            v[i] = static_cast<Key>(0) - static_cast<Key>(r % 100);
+            break;
+        case 3:
+            v[i] = (r % 2) ? std::numeric_limits<Key>::max()
+                   : std::numeric_limits<Key>::lowest();
+            break;
+        }
+    }
+    return v;
+}
+
+template <typename Key>
+void test_keys(size_t size, size_t num_threads) {
+    std::vector<Key> input = generate<Key>(size, static_cast<unsigned>(size));
+    std::vector<Key> correct = input;
+    std::sort(correct.begin(), correct.end());
+
+    std::vector<Key> v = input;
+    tlx::radix_sort(v.begin(), v.end());
+    die_unless(v == correct);
+
+    v = input;
+    tlx::parallel_radix_sort(v.begin(), v.end(), num_threads);
+    die_unless(v == correct);
+
+    v = input;
+    tlx::parallel_radix_sort(v.begin(), v.end(), static_cast<int>(num_threads));
+    die_unless(v == correct);
+
+    v = input;
+    tlx::parallel_radix_sort(v.begin(), v.end());
+    die_unless(v == correct);
+}
+
+void test_floats(size_t size, size_t num_threads) {
+    std::mt19937 rng(123456);
+    std::normal_distribution<double> dist(0, 1000);
+
+    std::vector<double> input(size);
+    for (size_t i = 0; i < size; ++i)
+        input[i] = (i % 10 == 0) ? static_cast<double>(i % 7) : dist(rng);
+    input.push_back(std::numeric_limits<double>::infinity());
+    input.push_back(-std::numeric_limits<double>::infinity());
+
+    std::vector<double> correct = input;
+    std::sort(correct.begin(), correct.end());
+
+    std::vector<double> v = input;
+    tlx::parallel_radix_sort(v.begin(), v.end(), num_threads);
+    die_unless(v == correct);
+
+    std::vector<float> f(input.begin(), input.end());
+    std::vector<float> f_correct = f;
+    std::sort(f_correct.begin(), f_correct.end());
+    tlx::radix_sort(f.begin(), f.end());
+    die_unless(f == f_correct);
+}
+
+struct Record {
+    int32_t key;
+    std::string payload;
+};
+
+//! sort records with a key extractor lambda, and keys with values attached
+void test_payloads(size_t size, size_t num_threads) {
+    std::mt19937 rng(654321);
+    std::vector<Record> records(size);
+    std::vector<int32_t> keys(size);
+    std::vector<std::string> values(size);
+    for (size_t i = 0; i < size; ++i) {
+        keys[i] = records[i].key = static_cast<int32_t>(rng() % 20000) - 10000;
+        values[i] = records[i].payload = std::to_string(keys[i]);
+    }
+
+    tlx::parallel_radix_sort(records.begin(), records.end(),
+                             [](const Record& r) { return r.key; },
+                             num_threads);
+    for (size_t i = 0; i < size; ++i) {
+        die_unless(i == 0 || records[i - 1].key <= records[i].key);
+        die_unequal(std::to_string(records[i].key), records[i].payload);
+    }
+
+    std::vector<int32_t> keys2 = keys;
+    std::vector<std::string> values2 = values;
+
+    tlx::radix_sort_key_value(keys.begin(), keys.end(), values.begin());
+    tlx::parallel_radix_sort_key_value(
+        keys2.begin(), keys2.end(), values2.begin(), num_threads);
+
+    die_unless(std::is_sorted(keys.begin(), keys.end()));
+    die_unless(keys == keys2);
+    for (size_t i = 0; i < size; ++i) {
+        die_unequal(std::to_string(keys[i]), values[i]);
+        die_unequal(std::to_string(keys2[i]), values2[i]);
+    }
+}
+
+int main() {
+    for (size_t size : { 0, 1, 2, 100, 1000, 10000, 100000, 1000000 }) {
+        for (size_t num_threads : { 1, 3, 8 }) {
+            test_keys<uint8_t>(size, num_threads);
+            test_keys<int16_t>(size, num_threads);
+            test_keys<uint32_t>(size, num_threads);
+            test_keys<int64_t>(size, num_threads);
+            test_keys<uint64_t>(size, num_threads);
+            test_floats(size, num_threads);
+        }
+    }
+
+    for (size_t num_threads : { 1, 4 }) {
+        test_payloads(1000, num_threads);
+        test_payloads(300000, num_threads);
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * tests/sort_strings_lcp_loser_tree_test.cpp
+ *
+ * Test merging of sorted string runs with LcpStringLoserTree.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include "sort_strings_test.hpp"
+
+#include <tlx/sort/strings/lcp_loser_tree.hpp>
+
+#include <tlx/die.hpp>
+#include <tlx/sort/strings.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+//! generate random strings with many common prefixes and duplicates
+std::vector<std::string> generate_strings(size_t num_strings,
+                                          const std::string& letters) {
+    std::default_random_engine rng(seed);
+    std::vector<std::string> strings(num_strings);
+    for (size_t i = 0; i < num_strings; ++i) {
+        if (i != 0 && rng() % 4 == 0) {
+            strings[i] = strings[rng() % i];
+            continue;
+        }
+        size_t prefix = rng() % 4 == 0 ? 0 : 8;
+        std::string& s = strings[i];
+        s.assign(prefix, 'a');
+        s.resize(prefix + rng() % 12);
+        fill_random(rng, letters, s.begin() + prefix, s.end());
+    }
+    return strings;
+}
+
+//! split strings into k runs, sort the runs with LCPs, and merge them with
+//! write() calls of up to block_size strings.
+void test_std_strings(size_t num_strings, size_t k, size_t block_size,
+                      const std::string& letters = "abcd") {
+    typedef StringLcpPtr<StdStringSet, uint32_t> StringLcpPtr;
+
+    std::vector<std::string> strings = generate_strings(num_strings, letters);
+    std::vector<uint32_t> lcps(num_strings);
+
+    std::vector<std::string> check = strings;
+    std::sort(check.begin(), check.end());
+
+    std::vector<StringLcpPtr> runs;
+    for (size_t r = 0; r < k; ++r) {
+        size_t begin = num_strings * r / k, end = num_strings * (r + 1) / k;
+        std::string* first = strings.data() + begin;
+        tlx::sort_strings_lcp(first, end - begin, lcps.data() + begin);
+        runs.emplace_back(StdStringSet(first, first + (end - begin)),
+                          lcps.data() + begin);
+    }
+
+    LcpStringLoserTree<StdStringSet, uint32_t> lt(runs.begin(), runs.end());
+    die_unequal(k, lt.num_runs());
+    die_unequal(num_strings, lt.size());
+
+    std::vector<std::string> output(num_strings);
+    std::vector<uint32_t> output_lcp(num_strings);
+
+    size_t pos = 0;
+    while (!lt.empty()) {
+        size_t n = std::min(block_size, num_strings - pos);
+        die_unequal(n, lt.write(StringLcpPtr(
+                                    StdStringSet(output.data() + pos,
+                                                 output.data() + pos + n),
+                                    output_lcp.data() + pos)));
+        pos += n;
+    }
+    die_unequal(num_strings, pos);
+    die_unless(output == check);
+
+    if (num_strings == 0) return;
+    die_unequal(0u, output_lcp[0]);
+    die_unless(check_lcp(
+                   StdStringSet(output.data(), output.data() + num_strings),
+                   output_lcp.data()));
+}
+
+//! merge runs of C strings and check that equal strings are stable
+void test_uchar_strings(size_t num_strings, size_t k,
+                        const std::string& letters = "abcd") {
+    typedef StringLcpPtr<UCharStringSet, uint32_t> StringLcpPtr;
+
+    std::vector<std::string> strings = generate_strings(num_strings, letters);
+    std::vector<uint8_t*> cstrings(num_strings);
+    std::vector<uint32_t> lcps(num_strings);
+    for (size_t i = 0; i < num_strings; ++i) {
+        cstrings[i] = reinterpret_cast<uint8_t*>(&strings[i][0]);
+    }
+
+    std::vector<StringLcpPtr> runs;
+    for (size_t r = 0; r < k; ++r) {
+        size_t begin = num_strings * r / k, end = num_strings * (r + 1) / k;
+        uint8_t** first = cstrings.data() + begin;
+        tlx::sort_strings_lcp(first, end - begin, lcps.data() + begin);
+        runs.emplace_back(UCharStringSet(first, first + (end - begin)),
+                          lcps.data() + begin);
+    }
+
+    std::vector<uint8_t*> output(num_strings);
+    std::vector<uint32_t> output_lcp(num_strings);
+    UCharStringSet oss(output.data(), output.data() + num_strings);
+
+    die_unequal(num_strings,
+                lcp_multiway_merge(runs.begin(), runs.end(),
+                                   StringLcpPtr(oss, output_lcp.data())));
+
+    die_unless(oss.check_order());
+    die_unless(check_lcp(oss, output_lcp.data()));
+
+    // equal strings must be output in the order of their runs
+    std::map<uint8_t*, size_t> run_of;
+    for (size_t r = 0; r < k; ++r) {
+        for (uint8_t** s = runs[r].active().begin();
+             s != runs[r].active().end(); ++s)
+            run_of[*s] = r;
+    }
+    for (size_t i = 1; i < num_strings; ++i) {
+        if (strcmp(reinterpret_cast<char*>(output[i - 1]),
+                   reinterpret_cast<char*>(output[i])) == 0)
+            die_unless(run_of[output[i - 1]] <= run_of[output[i]]);
+    }
+}
+
+//! sort runs and merge them with the public merge_strings_lcp() frontends
+void test_frontend(size_t num_strings, size_t k) {
+    std::vector<std::string> strings = generate_strings(num_strings, "abcd");
+    std::vector<std::string> check = strings;
+    std::sort(check.begin(), check.end());
+
+    std::vector<size_t> bounds(k + 1);
+    for (size_t r = 0; r <= k; ++r)
+        bounds[r] = num_strings * r / k;
+
+    // C strings
+    std::vector<char*> cstrings(num_strings);
+    for (size_t i = 0; i < num_strings; ++i)
+        cstrings[i] = &strings[i][0];
+    std::vector<uint32_t> lcps(num_strings);
+    for (size_t r = 0; r < k; ++r) {
+        tlx::sort_strings_lcp(cstrings.data() + bounds[r],
+                              bounds[r + 1] - bounds[r],
+                              lcps.data() + bounds[r]);
+    }
+
+    std::vector<char*> merged(num_strings);
+    std::vector<uint32_t> merged_lcp(num_strings);
+    die_unequal(num_strings,
+                tlx::merge_strings_lcp(cstrings.data(), lcps.data(),
+                                       bounds.data(), k,
+                                       merged.data(), merged_lcp.data()));
+    for (size_t i = 0; i < num_strings; ++i)
+        die_unequal(check[i], std::string(merged[i]));
+    die_unless(check_lcp(
+                   CharStringSet(merged.data(), merged.data() + num_strings),
+                   merged_lcp.data()));
+
+    // std::strings, which are moved
+    for (size_t r = 0; r < k; ++r) {
+        tlx::sort_strings_lcp(strings.data() + bounds[r],
+                              bounds[r + 1] - bounds[r],
+                              lcps.data() + bounds[r]);
+    }
+
+    std::vector<std::string> out(num_strings);
+    std::vector<uint32_t> out_lcp(num_strings);
+    die_unequal(num_strings,
+                tlx::merge_strings_lcp(strings.data(), lcps.data(),
+                                       bounds.data(), k,
+                                       out.data(), out_lcp.data()));
+    die_unless(out == check);
+    die_unless(check_lcp(StdStringSet(out.data(), out.data() + num_strings),
+                         out_lcp.data()));
+}
+
+int main() {
+    test_std_strings(0, 0, 1);
+    test_std_strings(0, 3, 1);
+    test_std_strings(1000, 1, 100);
+    test_std_strings(1000, 2, 1000);
+    test_std_strings(10000, 5, 777);
+    test_std_strings(10000, 16, 1);
+    test_std_strings(10000, 33, 4096);
+    test_std_strings(10000, 9, 1000, letters_alnum);
+
+    test_uchar_strings(1000, 7);
+    test_uchar_strings(20000, 64);
+    test_uchar_strings(10000, 12, letters_alnum);
+
+    test_frontend(0, 1);
+    test_frontend(1000, 3);
+    test_frontend(10000, 16);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,545 @@
+/*******************************************************************************
+ * tlx/algorithm/multiway_merge_arg.hpp
+ *
+ * Index-only multiway merge, which outputs the positions of the merged items
+ * instead of the items themselves.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_ALGORITHM_MULTIWAY_MERGE_ARG_HEADER
+#define TLX_ALGORITHM_MULTIWAY_MERGE_ARG_HEADER
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include <tlx/algorithm/multiway_merge_splitting.hpp>
+#include <tlx/algorithm/parallel_multiway_merge.hpp>
+#include <tlx/container/loser_tree.hpp>
+#include <tlx/simple_vector.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_algorithm
+//! \{
+
+namespace multiway_merge_detail {
+
+//! key type returned by KeyExtractor for items of the sequences
+template <typename RandomAccessIteratorIterator, typename KeyExtractor>
+using merge_arg_key_type = typename std::decay<
+    decltype(std::declval<KeyExtractor&>()(
+                 std::declval<const typename std::iterator_traits<
+                                  typename std::iterator_traits<
+                                      RandomAccessIteratorIterator>
+                                  ::value_type::first_type>::value_type&>()))
+    >::type;
+
+//! comparator of items through their keys, used for splitting
+template <typename ValueType, typename KeyExtractor, typename Comparator>
+class MergeArgItemCompare
+{
+public:
+    MergeArgItemCompare(const KeyExtractor& key, const Comparator& comp)
+        : key_(key), comp_(comp) { }
+
+    bool operator () (const ValueType& a, const ValueType& b) const {
+        return comp_(key_(a), key_(b));
+    }
+
+private:
+    const KeyExtractor& key_;
+    const Comparator& comp_;
+};
+
+/*!
+ * Stable multi-way merge of the keys of the sequences with a loser tree,
+ * writing transform(sequence id, index) of each merged item to target. The
+ * index is relative to origins[s], the sequence id is seq_ids[s].
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename OutputIterator,
+    typename KeyExtractor,
+    typename Comparator,
+    typename Transform>
+OutputIterator multiway_merge_arg_loser_tree(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    OutputIterator target,
+    typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    const KeyExtractor& key, const Comparator& comp,
+    const size_t* seq_ids,
+    const typename std::iterator_traits<
+        RandomAccessIteratorIterator>::value_type::first_type* origins,
+    const Transform& transform) {
+
+    using RandomAccessIteratorPair =
+        typename std::iterator_traits<RandomAccessIteratorIterator>
+        ::value_type;
+    using DiffType = typename std::iterator_traits<
+        typename RandomAccessIteratorPair::first_type>::difference_type;
+    using KeyType =
+        merge_arg_key_type<RandomAccessIteratorIterator, KeyExtractor>;
+    using LoserTreeType = LoserTree</* Stable */ true, KeyType, Comparator>;
+    using Source = typename LoserTreeType::Source;
+
+    const Source k = static_cast<Source>(seqs_end - seqs_begin);
+    if (k == 0)
+        return target;
+
+    const DiffType total_size = std::min<DiffType>(
+        size,
+        std::accumulate(seqs_begin, seqs_end, DiffType(0),
+                        [](DiffType sum, const RandomAccessIteratorPair& x) {
+                            return sum + iterpair_size(x);
+                        }));
+
+    // only the keys of the head items are kept, the loser tree may point
+    // into this array.
+    std::vector<KeyType> heads(k);
+    LoserTreeType lt(k, comp);
+
+    for (Source t = 0; t < k; ++t)
+    {
+        if (TLX_UNLIKELY(seqs_begin[t].first == seqs_begin[t].second)) {
+            lt.insert_start(nullptr, t, true);
+        }
+        else {
+            heads[t] = key(*seqs_begin[t].first);
+            lt.insert_start(&heads[t], t, false);
+        }
+    }
+
+    lt.init();
+
+    for (DiffType i = 0; i < total_size; ++i)
+    {
+        Source source = lt.min_source();
+
+        *target = transform(
+            seq_ids[source],
+            static_cast<size_t>(seqs_begin[source].first - origins[source]));
+        ++target;
+        ++seqs_begin[source].first;
+
+        // feed, replace from same source
+        if (seqs_begin[source].first == seqs_begin[source].second) {
+            lt.delete_min_insert(nullptr, true);
+        }
+        else {
+            heads[source] = key(*seqs_begin[source].first);
+            lt.delete_min_insert(&heads[source], false);
+        }
+    }
+
+    return target;
+}
+
+//! sequential index-only multi-way merge with a transform of the positions
+template <
+    typename RandomAccessIteratorIterator,
+    typename OutputIterator,
+    typename KeyExtractor,
+    typename Comparator,
+    typename Transform>
+OutputIterator multiway_merge_arg_base(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    OutputIterator target,
+    typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    const KeyExtractor& key, const Comparator& comp,
+    const Transform& transform) {
+
+    using RandomAccessIterator =
+        typename std::iterator_traits<RandomAccessIteratorIterator>
+        ::value_type::first_type;
+
+    const size_t k = static_cast<size_t>(seqs_end - seqs_begin);
+
+    simple_vector<size_t> seq_ids(k);
+    simple_vector<RandomAccessIterator> origins(k);
+    for (size_t s = 0; s < k; ++s) {
+        seq_ids[s] = s;
+        origins[s] = seqs_begin[s].first;
+    }
+
+    return multiway_merge_arg_loser_tree(
+        seqs_begin, seqs_end, target, size, key, comp,
+        seq_ids.data(), origins.data(), transform);
+}
+
+//! parallel index-only multi-way merge with a transform of the positions
+template <
+    typename RandomAccessIteratorIterator,
+    typename RandomAccessIterator3,
+    typename KeyExtractor,
+    typename Comparator,
+    typename Transform>
+RandomAccessIterator3 parallel_multiway_merge_arg_base(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    RandomAccessIterator3 target,
+    const typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    const KeyExtractor& key, const Comparator& comp,
+    const Transform& transform,
+    MultiwayMergeSplittingAlgorithm mwmsa, size_t num_threads) {
+
+    using RandomAccessIteratorPair =
+        typename std::iterator_traits<RandomAccessIteratorIterator>
+        ::value_type;
+    using RandomAccessIterator =
+        typename RandomAccessIteratorPair::first_type;
+    using value_type = typename std::iterator_traits<RandomAccessIterator>
+                       ::value_type;
+    using DiffType = typename std::iterator_traits<RandomAccessIterator>
+                     ::difference_type;
+
+    // leave only non-empty sequences, but remember their ids and origins
+    std::vector<RandomAccessIteratorPair> seqs_ne;
+    std::vector<size_t> seq_ids;
+    std::vector<RandomAccessIterator> origins;
+    DiffType total_size = 0;
+
+    for (RandomAccessIteratorIterator ii = seqs_begin; ii != seqs_end; ++ii)
+    {
+        if (ii->first != ii->second) {
+            total_size += ii->second - ii->first;
+            seqs_ne.push_back(*ii);
+            seq_ids.push_back(static_cast<size_t>(ii - seqs_begin));
+            origins.push_back(ii->first);
+        }
+    }
+
+    size_t num_seqs = seqs_ne.size();
+
+    if (total_size == 0 || num_seqs == 0)
+        return target;
+
+    if (static_cast<DiffType>(num_threads) > total_size)
+        num_threads = total_size;
+
+    // thread t will have to merge chunks[iam][0..k - 1]
+
+    simple_vector<std::vector<RandomAccessIteratorPair> > chunks(num_threads);
+
+    for (size_t s = 0; s < num_threads; ++s)
+        chunks[s].resize(num_seqs);
+
+    MergeArgItemCompare<value_type, KeyExtractor, Comparator> item_comp(
+        key, comp);
+
+    if (mwmsa == MWMSA_SAMPLING)
+    {
+        multiway_merge_sampling_splitting</* Stable */ true>(
+            seqs_ne.begin(), seqs_ne.end(),
+            static_cast<DiffType>(size), total_size, item_comp,
+            chunks.data(), num_threads,
+            parallel_multiway_merge_oversampling);
+    }
+    else // (mwmsa == MWMSA_EXACT)
+    {
+        multiway_merge_exact_splitting</* Stable */ true>(
+            seqs_ne.begin(), seqs_ne.end(),
+            static_cast<DiffType>(size), total_size, item_comp,
+            chunks.data(), num_threads);
+    }
+
+    auto merge_part = [&](size_t iam) {
+                          DiffType target_position = 0, local_size = 0;
+
+                          for (size_t s = 0; s < num_seqs; ++s)
+                          {
+                              target_position +=
+                                  chunks[iam][s].first - seqs_ne[s].first;
+                              local_size +=
+                                  chunks[iam][s].second - chunks[iam][s].first;
+                          }
+
+                          multiway_merge_arg_loser_tree(
+                              chunks[iam].begin(), chunks[iam].end(),
+                              target + target_position,
+                              std::min(local_size, size - target_position),
+                              key, comp, seq_ids.data(), origins.data(),
+                              transform);
+                      };
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(num_threads)
+    merge_part(omp_get_thread_num());
+#else
+    std::vector<std::thread> threads(num_threads);
+
+    for (size_t iam = 0; iam < num_threads; ++iam)
+        threads[iam] = std::thread(merge_part, iam);
+
+    for (size_t i = 0; i < num_threads; ++i)
+        threads[i].join();
+#endif
+
+    // update ends of sequences
+    size_t count_seqs = 0;
+    for (RandomAccessIteratorIterator ii = seqs_begin; ii != seqs_end; ++ii)
+    {
+        if (ii->first != ii->second)
+            ii->first = chunks[num_threads - 1][count_seqs++].second;
+    }
+
+    return target + size;
+}
+
+//! transform to (sequence, index) pairs
+struct MergeArgPairTransform {
+    std::pair<size_t, size_t> operator () (size_t seq, size_t index) const {
+        return std::make_pair(seq, index);
+    }
+};
+
+//! transform to index in the concatenation of the sequences
+struct MergeArgRankTransform {
+    const size_t* offsets;
+
+    size_t operator () (size_t seq, size_t index) const {
+        return offsets[seq] + index;
+    }
+};
+
+//! calculate the exclusive prefix sum of the sequences' sizes
+template <typename RandomAccessIteratorIterator>
+simple_vector<size_t> merge_arg_offsets(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end) {
+    simple_vector<size_t> offsets(static_cast<size_t>(seqs_end - seqs_begin));
+    size_t sum = 0;
+    for (size_t s = 0; s < offsets.size(); ++s) {
+        offsets[s] = sum;
+        sum += static_cast<size_t>(iterpair_size(seqs_begin[s]));
+    }
+    return offsets;
+}
+
+//! whether to run the parallel merge, see parallel_multiway_merge()
+static inline bool merge_arg_use_parallel(
+    size_t k, size_t size, size_t num_threads) {
+    return !parallel_multiway_merge_force_sequential &&
+           (parallel_multiway_merge_force_parallel ||
+            (num_threads > 1 && k >= parallel_multiway_merge_minimal_k &&
+             size >= parallel_multiway_merge_minimal_n));
+}
+
+} // namespace multiway_merge_detail
+
+/******************************************************************************/
+// multiway_merge_arg() Frontends
+
+/*!
+ * Sequential index-only multi-way merge. Instead of the items, the positions
+ * of the merged items are written to target as std::pair<size_t, size_t> of
+ * sequence number and index in the sequence. Items are compared through the
+ * keys returned by the KeyExtractor, and only the keys of the current head
+ * items are kept in the loser tree, hence the items themselves are neither
+ * copied nor moved. Equal keys are output in the order of the sequences.
+ *
+ * This allows sorting large records by reference and gathering them once
+ * afterwards. The indexes are relative to the sequence begins at the time of
+ * the call, which are advanced as by multiway_merge().
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator of output sequence.
+ * \param size Maximum size to merge.
+ * \param key Key extractor, called as key(item).
+ * \param comp Comparator on keys.
+ * \return End iterator of output sequence.
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename OutputIterator,
+    typename KeyExtractor,
+    typename Comparator = std::less<
+        multiway_merge_detail::merge_arg_key_type<
+            RandomAccessIteratorIterator, KeyExtractor> > >
+OutputIterator multiway_merge_arg(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    OutputIterator target,
+    typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    KeyExtractor key, Comparator comp = Comparator()) {
+
+    return multiway_merge_detail::multiway_merge_arg_base(
+        seqs_begin, seqs_end, target, size, key, comp,
+        multiway_merge_detail::MergeArgPairTransform());
+}
+
+/*!
+ * Sequential index-only multi-way merge, which outputs a permutation: the
+ * index of each merged item in the concatenation of the sequences, as size_t.
+ * See multiway_merge_arg().
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator of output sequence.
+ * \param size Maximum size to merge.
+ * \param key Key extractor, called as key(item).
+ * \param comp Comparator on keys.
+ * \return End iterator of output sequence.
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename OutputIterator,
+    typename KeyExtractor,
+    typename Comparator = std::less<
+        multiway_merge_detail::merge_arg_key_type<
+            RandomAccessIteratorIterator, KeyExtractor> > >
+OutputIterator multiway_merge_permutation(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    OutputIterator target,
+    typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    KeyExtractor key, Comparator comp = Comparator()) {
+
+    simple_vector<size_t> offsets =
+        multiway_merge_detail::merge_arg_offsets(seqs_begin, seqs_end);
+
+    return multiway_merge_detail::multiway_merge_arg_base(
+        seqs_begin, seqs_end, target, size, key, comp,
+        multiway_merge_detail::MergeArgRankTransform { offsets.data() });
+}
+
+/*!
+ * Parallel index-only multi-way merge, see multiway_merge_arg().
+ *
+ * Implemented either using OpenMP or with std::threads, depending on if
+ * compiled with -fopenmp or not.
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator of output sequence.
+ * \param size Maximum size to merge.
+ * \param key Key extractor, called as key(item).
+ * \param comp Comparator on keys.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ * \param num_threads Number of threads to use (defaults to all cores)
+ * \return End iterator of output sequence.
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename RandomAccessIterator3,
+    typename KeyExtractor,
+    typename Comparator = std::less<
+        multiway_merge_detail::merge_arg_key_type<
+            RandomAccessIteratorIterator, KeyExtractor> > >
+RandomAccessIterator3 parallel_multiway_merge_arg(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    RandomAccessIterator3 target,
+    const typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    KeyExtractor key, Comparator comp = Comparator(),
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT,
+    size_t num_threads = std::thread::hardware_concurrency()) {
+
+    using namespace multiway_merge_detail;
+
+    if (!merge_arg_use_parallel(static_cast<size_t>(seqs_end - seqs_begin),
+                                static_cast<size_t>(size), num_threads)) {
+        return multiway_merge_arg_base(
+            seqs_begin, seqs_end, target, size, key, comp,
+            MergeArgPairTransform());
+    }
+
+    return parallel_multiway_merge_arg_base(
+        seqs_begin, seqs_end, target, size, key, comp,
+        MergeArgPairTransform(), mwmsa, num_threads);
+}
+
+/*!
+ * Parallel index-only multi-way merge, which outputs a permutation, see
+ * multiway_merge_permutation().
+ *
+ * Implemented either using OpenMP or with std::threads, depending on if
+ * compiled with -fopenmp or not.
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator of output sequence.
+ * \param size Maximum size to merge.
+ * \param key Key extractor, called as key(item).
+ * \param comp Comparator on keys.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ * \param num_threads Number of threads to use (defaults to all cores)
+ * \return End iterator of output sequence.
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename RandomAccessIterator3,
+    typename KeyExtractor,
+    typename Comparator = std::less<
+        multiway_merge_detail::merge_arg_key_type<
+            RandomAccessIteratorIterator, KeyExtractor> > >
+RandomAccessIterator3 parallel_multiway_merge_permutation(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    RandomAccessIterator3 target,
+    const typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    KeyExtractor key, Comparator comp = Comparator(),
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT,
+    size_t num_threads = std::thread::hardware_concurrency()) {
+
+    using namespace multiway_merge_detail;
+
+    simple_vector<size_t> offsets = merge_arg_offsets(seqs_begin, seqs_end);
+    MergeArgRankTransform transform { offsets.data() };
+
+    if (!merge_arg_use_parallel(static_cast<size_t>(seqs_end - seqs_begin),
+                                static_cast<size_t>(size), num_threads)) {
+        return multiway_merge_arg_base(
+            seqs_begin, seqs_end, target, size, key, comp, transform);
+    }
+
+    return parallel_multiway_merge_arg_base(
+        seqs_begin, seqs_end, target, size, key, comp,
+        transform, mwmsa, num_threads);
+}
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_ALGORITHM_MULTIWAY_MERGE_ARG_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,310 @@
+/*******************************************************************************
+ * tlx/algorithm/multiway_merge_combine.hpp
+ *
+ * Multiway merge of sorted sequences which combines items with equal keys.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_ALGORITHM_MULTIWAY_MERGE_COMBINE_HEADER
+#define TLX_ALGORITHM_MULTIWAY_MERGE_COMBINE_HEADER
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include <tlx/algorithm/multiway_merge_splitting.hpp>
+#include <tlx/algorithm/parallel_multiway_merge.hpp>
+#include <tlx/container/loser_tree.hpp>
+#include <tlx/simple_vector.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_algorithm
+//! \{
+
+/*!
+ * Sequential multi-way merge which combines all items comparing equal. The
+ * sequences must be sorted by the Comparator, and each group of items which
+ * compare equal, both across and within the sequences, is folded from left to
+ * right with the combine operator into a single output item. The items of a
+ * group are combined in the order of the sequences. Keys are compared with the
+ * input items, hence the combined item need not compare equal to them.
+ *
+ * In contrast to merge_combine(), the Comparator is a less-than comparator as
+ * for multiway_merge().
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator of output sequence.
+ * \param comp Comparator.
+ * \param combine Combine operator, called as combine(accumulated, item).
+ * \return End iterator of output sequence.
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename OutputIterator,
+    typename Comparator = std::less<
+        typename std::iterator_traits<
+            typename std::iterator_traits<RandomAccessIteratorIterator>
+            ::value_type::first_type>::value_type>,
+    typename Combine = std::plus<
+        typename std::iterator_traits<
+            typename std::iterator_traits<RandomAccessIteratorIterator>
+            ::value_type::first_type>::value_type> >
+OutputIterator multiway_merge_combine(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    OutputIterator target,
+    Comparator comp = Comparator(),
+    Combine combine = Combine()) {
+
+    using RandomAccessIterator =
+        typename std::iterator_traits<RandomAccessIteratorIterator>
+        ::value_type::first_type;
+    using value_type = typename std::iterator_traits<RandomAccessIterator>
+                       ::value_type;
+    using LoserTreeType = LoserTree</* Stable */ true, value_type, Comparator>;
+    using Source = typename LoserTreeType::Source;
+
+    const Source k = static_cast<Source>(seqs_end - seqs_begin);
+    if (k == 0)
+        return target;
+
+    LoserTreeType lt(k, comp);
+
+    size_t remaining = 0;
+    for (Source t = 0; t < k; ++t)
+    {
+        remaining += static_cast<size_t>(
+            seqs_begin[t].second - seqs_begin[t].first);
+
+        if (TLX_UNLIKELY(seqs_begin[t].first == seqs_begin[t].second))
+            lt.insert_start(nullptr, t, true);
+        else
+            lt.insert_start(&*seqs_begin[t].first, t, false);
+    }
+
+    lt.init();
+
+    if (remaining == 0)
+        return target;
+
+    // take out first item, which starts the first group
+    Source source = lt.min_source();
+    RandomAccessIterator group = seqs_begin[source].first;
+    value_type acc = *group;
+    ++seqs_begin[source].first;
+
+    while (--remaining != 0)
+    {
+        // feed
+        if (seqs_begin[source].first == seqs_begin[source].second)
+            lt.delete_min_insert(nullptr, true);
+        else
+            lt.delete_min_insert(&*seqs_begin[source].first, false);
+
+        // take out following, and either combine or start a new group
+        source = lt.min_source();
+        RandomAccessIterator item = seqs_begin[source].first;
+
+        if (comp(*group, *item)) {
+            *target = std::move(acc);
+            ++target;
+            group = item;
+            acc = *item;
+        }
+        else {
+            acc = combine(acc, *item);
+        }
+        ++seqs_begin[source].first;
+    }
+
+    *target = std::move(acc);
+    ++target;
+
+    return target;
+}
+
+/*!
+ * Parallel multi-way merge which combines all items comparing equal, see
+ * multiway_merge_combine() for the semantics.
+ *
+ * The sequences are split into num_threads parts of equal size using
+ * multiway_merge_exact_splitting(), after which each boundary is moved down to
+ * the first item of its group, such that no group of equal items is split
+ * between two threads. Each thread merges its part into a local buffer, and
+ * the buffers are then copied to the target in parallel.
+ *
+ * Implemented either using OpenMP or with std::threads, depending on if
+ * compiled with -fopenmp or not.
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator of output sequence.
+ * \param comp Comparator.
+ * \param combine Combine operator, called as combine(accumulated, item).
+ * \param num_threads Number of threads to use (defaults to all cores)
+ * \return End iterator of output sequence.
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename RandomAccessIterator3,
+    typename Comparator = std::less<
+        typename std::iterator_traits<
+            typename std::iterator_traits<RandomAccessIteratorIterator>
+            ::value_type::first_type>::value_type>,
+    typename Combine = std::plus<
+        typename std::iterator_traits<
+            typename std::iterator_traits<RandomAccessIteratorIterator>
+            ::value_type::first_type>::value_type> >
+RandomAccessIterator3 parallel_multiway_merge_combine(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    RandomAccessIterator3 target,
+    Comparator comp = Comparator(),
+    Combine combine = Combine(),
+    size_t num_threads = std::thread::hardware_concurrency()) {
+
+    using RandomAccessIteratorPair =
+        typename std::iterator_traits<RandomAccessIteratorIterator>
+        ::value_type;
+    using RandomAccessIterator =
+        typename RandomAccessIteratorPair::first_type;
+    using value_type = typename std::iterator_traits<RandomAccessIterator>
+                       ::value_type;
+    using DiffType = typename std::iterator_traits<RandomAccessIterator>
+                     ::difference_type;
+
+    // leave only non-empty sequences
+    std::vector<RandomAccessIteratorPair> seqs_ne;
+    seqs_ne.reserve(static_cast<size_t>(seqs_end - seqs_begin));
+    DiffType total_size = 0;
+
+    for (RandomAccessIteratorIterator ii = seqs_begin; ii != seqs_end; ++ii)
+    {
+        if (ii->first != ii->second) {
+            total_size += ii->second - ii->first;
+            seqs_ne.push_back(*ii);
+        }
+    }
+
+    size_t num_seqs = seqs_ne.size();
+
+    if (parallel_multiway_merge_force_sequential ||
+        (!parallel_multiway_merge_force_parallel &&
+         (num_threads <= 1 ||
+          num_seqs < parallel_multiway_merge_minimal_k ||
+          static_cast<size_t>(total_size)
+          < parallel_multiway_merge_minimal_n))) {
+        return multiway_merge_combine(
+            seqs_begin, seqs_end, target, comp, combine);
+    }
+
+    if (static_cast<DiffType>(num_threads) > total_size)
+        num_threads = total_size;
+
+    // thread t will have to merge chunks[iam][0..k - 1]
+
+    simple_vector<std::vector<RandomAccessIteratorPair> > chunks(num_threads);
+
+    for (size_t s = 0; s < num_threads; ++s)
+        chunks[s].resize(num_seqs);
+
+    multiway_merge_exact_splitting</* Stable */ true>(
+        seqs_ne.begin(), seqs_ne.end(),
+        total_size, total_size, comp, chunks.data(), num_threads);
+
+    // move each boundary down to the first item of the group which contains
+    // the smallest item right of it. All items left of the boundary are not
+    // greater, hence the boundary stays consistent across the sequences.
+    for (size_t slab = 1; slab < num_threads; ++slab)
+    {
+        RandomAccessIterator min_item = RandomAccessIterator();
+        bool found = false;
+
+        for (size_t s = 0; s < num_seqs; ++s)
+        {
+            RandomAccessIterator first = chunks[slab][s].first;
+            if (first == seqs_ne[s].second) continue;
+            if (!found || comp(*first, *min_item))
+                min_item = first, found = true;
+        }
+        if (!found) continue;
+
+        for (size_t s = 0; s < num_seqs; ++s)
+        {
+            RandomAccessIterator split = std::lower_bound(
+                seqs_ne[s].first, chunks[slab][s].first, *min_item, comp);
+            chunks[slab - 1][s].second = chunks[slab][s].first = split;
+        }
+    }
+
+    // merge each part into a local buffer, then copy them to their positions
+
+    simple_vector<std::vector<value_type> > buffers(num_threads);
+    simple_vector<size_t> offsets(num_threads + 1);
+
+    auto merge_part = [&](size_t iam) {
+                          multiway_merge_combine(
+                              chunks[iam].begin(), chunks[iam].end(),
+                              std::back_inserter(buffers[iam]), comp, combine);
+                      };
+
+    auto copy_part = [&](size_t iam) {
+                         std::move(buffers[iam].begin(), buffers[iam].end(),
+                                   target + offsets[iam]);
+                     };
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(num_threads)
+    merge_part(omp_get_thread_num());
+#else
+    std::vector<std::thread> threads(num_threads);
+
+    for (size_t iam = 0; iam < num_threads; ++iam)
+        threads[iam] = std::thread(merge_part, iam);
+
+    for (size_t i = 0; i < num_threads; ++i)
+        threads[i].join();
+#endif
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < num_threads; ++i)
+        offsets[i + 1] = offsets[i] + buffers[i].size();
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(num_threads)
+    copy_part(omp_get_thread_num());
+#else
+    for (size_t iam = 0; iam < num_threads; ++iam)
+        threads[iam] = std::thread(copy_part, iam);
+
+    for (size_t i = 0; i < num_threads; ++i)
+        threads[i].join();
+#endif
+
+    // all sequences were consumed
+    for (RandomAccessIteratorIterator ii = seqs_begin; ii != seqs_end; ++ii)
+        ii->first = ii->second;
+
+    return target + offsets[num_threads];
+}
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_ALGORITHM_MULTIWAY_MERGE_COMBINE_HEADER
+
+/******************************************************************************/
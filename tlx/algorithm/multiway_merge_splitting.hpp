@@ -70,6 +70,62 @@ DiffTypeOutputIterator equally_split(
     return s;
 }
 
+/*!
+ * Move the splitting positions of a multisequence partition such that items
+ * equal to the smallest item right of the split are taken into the left part
+ * from the sequences with smaller number first, as required for stable
+ * merging. The global rank of the split remains unchanged.
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param offsets Splitting positions in each sequence.
+ * \param comp Comparator.
+ */
+template <typename RandomAccessIteratorIterator, typename OffsetIterator,
+          typename Comparator>
+void stable_split_ties(
+    const RandomAccessIteratorIterator& seqs_begin,
+    const RandomAccessIteratorIterator& seqs_end,
+    OffsetIterator offsets, Comparator comp) {
+
+    using RandomAccessIterator =
+        typename std::iterator_traits<RandomAccessIteratorIterator>
+        ::value_type::first_type;
+    using DiffType = typename std::iterator_traits<RandomAccessIterator>
+                     ::difference_type;
+
+    const size_t num_seqs = static_cast<size_t>(seqs_end - seqs_begin);
+
+    // find smallest item right of the split
+    RandomAccessIterator min_item = RandomAccessIterator();
+    bool found = false;
+    for (size_t s = 0; s < num_seqs; ++s)
+    {
+        if (offsets[s] == seqs_begin[s].second) continue;
+        if (!found || comp(*offsets[s], *min_item))
+            min_item = offsets[s], found = true;
+    }
+    if (!found) return;
+
+    // count items equal to it left of the split, then redistribute them
+    simple_vector<RandomAccessIterator> lower(num_seqs), upper(num_seqs);
+    DiffType equal_left = 0;
+    for (size_t s = 0; s < num_seqs; ++s)
+    {
+        lower[s] = std::lower_bound(
+            seqs_begin[s].first, offsets[s], *min_item, comp);
+        upper[s] = std::upper_bound(
+            offsets[s], seqs_begin[s].second, *min_item, comp);
+        equal_left += offsets[s] - lower[s];
+    }
+    for (size_t s = 0; s < num_seqs; ++s)
+    {
+        DiffType take = std::min(equal_left, upper[s] - lower[s]);
+        offsets[s] = lower[s] + take;
+        equal_left -= take;
+    }
+}
+
 } // namespace multiway_merge_detail
 
 /*!
@@ -225,6 +281,10 @@ void multiway_merge_exact_splitting(
         multisequence_partition(
             seqs_begin, seqs_end,
             ranks[static_cast<size_t>(s + 1)], offsets[s].begin(), comp);
+        if (Stable) {
+            multiway_merge_detail::stable_split_ties(
+                seqs_begin, seqs_end, offsets[s].begin(), comp);
+        }
 
         if (!tight) // last one also needed and available
         {
@@ -232,6 +292,11 @@ void multiway_merge_exact_splitting(
             multisequence_partition(
                 seqs_begin, seqs_end,
                 size, offsets[num_threads - 1].begin(), comp);
+            if (Stable) {
+                multiway_merge_detail::stable_split_ties(
+                    seqs_begin, seqs_end,
+                    offsets[num_threads - 1].begin(), comp);
+            }
         }
     }
 
@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * tlx/algorithm/multiway_merge_stream.hpp
+ *
+ * Streaming multiway merge of sorted sequences pulled block-wise from sources.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_ALGORITHM_MULTIWAY_MERGE_STREAM_HEADER
+#define TLX_ALGORITHM_MULTIWAY_MERGE_STREAM_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <tlx/container/loser_tree.hpp>
+#include <tlx/container/simple_vector.hpp>
+#include <tlx/delegate.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_algorithm
+//! \{
+
+/*!
+ * Streaming multi-way merge of sorted sequences, which are pulled block-wise
+ * from sources instead of being kept in memory as random access ranges.
+ *
+ * Each source is a callback which fills a buffer with up to block_size next
+ * items of its sorted sequence and returns the number of items written, or
+ * zero at the end of the sequence. Sources may also be given as input iterator
+ * ranges. The merger keeps one buffer of block_size items per source and
+ * refills it from the source when it runs empty, hence it uses O(k *
+ * block_size) memory regardless of the length of the sequences. The head
+ * items of the buffers are merged with a LoserTree.
+ *
+ * The merged output is either pulled with read(), or pushed block-wise into a
+ * sink callback with merge_blocks(), or into an output iterator with merge().
+ *
+ * \tparam ValueType the element type
+ * \tparam Comparator comparator to use for binary comparisons.
+ * \tparam Stable if true, equal items are output in the order of the sources.
+ */
+template <typename ValueType, typename Comparator = std::less<ValueType>,
+          bool Stable = false>
+class MultiwayMergeStream
+{
+public:
+    using value_type = ValueType;
+
+    //! source callback: fill up to n items into the buffer, return the number
+    //! written, or zero if the sequence is finished.
+    using SourceFunction = Delegate<size_t(ValueType* buffer, size_t n)>;
+
+    //! sink callback receiving a block of n merged items
+    using SinkFunction = Delegate<void(const ValueType* data, size_t n)>;
+
+    using LoserTreeType = LoserTree<Stable, ValueType, Comparator>;
+    using Source = typename LoserTreeType::Source;
+
+    //! create a merger which pulls blocks of block_size items from the
+    //! sources.
+    explicit MultiwayMergeStream(size_t block_size = 4096,
+                                 const Comparator& cmp = Comparator())
+        : block_size_(block_size), cmp_(cmp) {
+        assert(block_size > 0);
+    }
+
+    //! non-copyable: delete copy-constructor
+    MultiwayMergeStream(const MultiwayMergeStream&) = delete;
+    //! non-copyable: delete assignment operator
+    MultiwayMergeStream& operator = (const MultiwayMergeStream&) = delete;
+    //! move-constructor: default
+    MultiwayMergeStream(MultiwayMergeStream&&) = default;
+    //! move-assignment operator: default
+    MultiwayMergeStream& operator = (MultiwayMergeStream&&) = default;
+
+    //! add a source callback. Must be called before the merge starts.
+    void add_source(const SourceFunction& source) {
+        assert(!started_);
+        streams_.emplace_back(source);
+    }
+
+    //! add a sorted input iterator range as source. The iterators must remain
+    //! valid until the merge is finished.
+    template <typename InputIterator>
+    void add_source(InputIterator first, InputIterator last) {
+        add_source(SourceFunction(
+                       [first, last](ValueType* buffer, size_t n) mutable {
+                           size_t i = 0;
+                           for ( ; i < n && first != last; ++i, ++first)
+                               buffer[i] = *first;
+                           return i;
+                       }));
+    }
+
+    //! number of sources
+    size_t num_sources() const { return streams_.size(); }
+
+    //! block size of the buffers
+    size_t block_size() const { return block_size_; }
+
+    //! returns true if all sources are finished and all items were output
+    bool empty() {
+        if (!started_) start();
+        return remaining_ == 0;
+    }
+
+    //! write up to n next merged items to out. Returns the number of items
+    //! written, which is less than n only at the end of the merge.
+    template <typename OutputIterator>
+    size_t read(OutputIterator out, size_t n) {
+        if (!started_) start();
+
+        size_t i = 0;
+        while (i < n && remaining_ != 0) {
+            Source source = lt_->min_source();
+            Stream& s = streams_[source];
+
+            *out = std::move(s.buffer[s.pos]);
+            ++out, ++i;
+
+            if (++s.pos == s.end && !refill(s)) {
+                lt_->delete_min_insert(nullptr, true);
+                --remaining_;
+            }
+            else {
+                lt_->delete_min_insert(&s.buffer[s.pos], false);
+            }
+        }
+        return i;
+    }
+
+    //! merge all items and pass them block-wise to the sink. Returns the
+    //! number of items merged.
+    size_t merge_blocks(const SinkFunction& sink) {
+        SimpleVector<ValueType> block(block_size_);
+        size_t total = 0;
+        while (size_t n = read(block.data(), block_size_)) {
+            sink(block.data(), n);
+            total += n;
+        }
+        return total;
+    }
+
+    //! merge all items to the output iterator. Returns the output iterator
+    //! after the last item.
+    template <typename OutputIterator>
+    OutputIterator merge(OutputIterator out) {
+        merge_blocks(SinkFunction(
+                         [&out](const ValueType* data, size_t n) {
+                             out = std::copy(data, data + n, out);
+                         }));
+        return out;
+    }
+
+private:
+    //! buffer of a source
+    struct Stream {
+        //! callback to refill the buffer
+        SourceFunction source;
+        //! block of items pulled from the source
+        SimpleVector<ValueType> buffer;
+        //! current position and end of valid items in the buffer
+        size_t pos = 0, end = 0;
+
+        explicit Stream(const SourceFunction& s) : source(s) { }
+    };
+
+    //! number of items per buffer
+    size_t block_size_;
+
+    //! comparator
+    Comparator cmp_;
+
+    //! sources and their buffers
+    std::vector<Stream> streams_;
+
+    //! loser tree over the current head items of the buffers
+    std::unique_ptr<LoserTreeType> lt_;
+
+    //! number of sources which are not finished
+    size_t remaining_ = 0;
+
+    //! whether the merge was started
+    bool started_ = false;
+
+    //! pull the next block from the source, returns false if it is finished.
+    bool refill(Stream& s) {
+        s.pos = 0;
+        s.end = s.source(s.buffer.data(), block_size_);
+        assert(s.end <= block_size_);
+        return s.end != 0;
+    }
+
+    //! fill all buffers and initialize the loser tree
+    void start() {
+        started_ = true;
+        if (streams_.empty()) return;
+
+        lt_.reset(new LoserTreeType(
+                      static_cast<Source>(streams_.size()), cmp_));
+
+        for (size_t i = 0; i < streams_.size(); ++i) {
+            Stream& s = streams_[i];
+            s.buffer.resize(block_size_);
+            if (refill(s)) {
+                lt_->insert_start(&s.buffer[0], static_cast<Source>(i), false);
+                ++remaining_;
+            }
+            else {
+                lt_->insert_start(nullptr, static_cast<Source>(i), true);
+            }
+        }
+        lt_->init();
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_ALGORITHM_MULTIWAY_MERGE_STREAM_HEADER
+
+/******************************************************************************/
@@ -19,7 +19,9 @@
 #define TLX_ALGORITHM_PARALLEL_MULTIWAY_MERGE_HEADER
 
 #include <algorithm>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -30,6 +32,7 @@
 #include <tlx/algorithm/multiway_merge.hpp>
 #include <tlx/algorithm/multiway_merge_splitting.hpp>
 #include <tlx/simple_vector.hpp>
+#include <tlx/thread_pool.hpp>
 
 namespace tlx {
 
@@ -39,33 +42,66 @@ namespace tlx {
 //! default oversampling factor for parallel_multiway_merge
 extern size_t parallel_multiway_merge_oversampling;
 
+namespace multiway_merge_detail {
+
+//! run job(0), ..., job(n - 1) in n new std::threads, or in an OpenMP team if
+//! compiled with -fopenmp.
+struct ThreadRunner {
+    template <typename Job>
+    void operator () (size_t n, const Job& job) const {
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(n)
+        job(static_cast<size_t>(omp_get_thread_num()));
+#else
+        simple_vector<std::thread> threads(n);
+        for (size_t iam = 0; iam < n; ++iam)
+            threads[iam] = std::thread(job, iam);
+        for (size_t i = 0; i < n; ++i)
+            threads[i].join();
+#endif
+    }
+};
+
+//! run job(0), ..., job(n - 1) as jobs on a ThreadPool, job(0) in the calling
+//! thread, and wait for them to finish. Must not be called from within a job
+//! running on the same pool, since all workers may be blocked waiting.
+struct ThreadPoolRunner {
+    ThreadPool& pool;
+
+    template <typename Job>
+    void operator () (size_t n, const Job& job) const {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t remaining = n - 1;
+
+        for (size_t iam = 1; iam < n; ++iam) {
+            pool.enqueue(
+                [&, iam]() {
+                    job(iam);
+                    std::unique_lock<std::mutex> lock(mutex);
+                    if (--remaining == 0)
+                        cv.notify_one();
+                });
+        }
+
+        job(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return remaining == 0; });
+    }
+};
+
 /*!
- * Parallel multi-way merge routine.
- *
- * Implemented either using OpenMP or with std::threads, depending on if
- * compiled with -fopenmp or not. The OpenMP version uses the implicit thread
- * pool, which is faster when using this method often.
- *
- * \param seqs_begin Begin iterator of iterator pair input sequence.
- * \param seqs_end End iterator of iterator pair input sequence.
- * \param target Begin iterator out output sequence.
- * \param size Maximum size to merge.
- * \param comp Comparator.
- * \param mwma MultiwayMergeAlgorithm set to use.
- * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
- * \param num_threads Number of threads to use (defaults to all cores)
- * \tparam Stable Stable merging incurs a performance penalty.
- * \return End iterator of output sequence.
+ * Parallel multi-way merge routine, which splits the sequences into num_threads
+ * parts and merges them with run(num_threads, merge_part).
  */
 template <
     bool Stable,
     typename RandomAccessIteratorIterator,
     typename RandomAccessIterator3,
-    typename Comparator = std::less<
-        typename std::iterator_traits<
-            typename std::iterator_traits<RandomAccessIteratorIterator>
-            ::value_type::first_type>::value_type> >
-RandomAccessIterator3 parallel_multiway_merge_base(
+    typename Comparator,
+    typename Runner>
+RandomAccessIterator3 parallel_multiway_merge_run(
     RandomAccessIteratorIterator seqs_begin,
     RandomAccessIteratorIterator seqs_end,
     RandomAccessIterator3 target,
@@ -73,10 +109,11 @@ RandomAccessIterator3 parallel_multiway_merge_base(
         typename std::iterator_traits<
             RandomAccessIteratorIterator>::value_type::first_type>::
     difference_type size,
-    Comparator comp = Comparator(),
-    MultiwayMergeAlgorithm mwma = MWMA_ALGORITHM_DEFAULT,
-    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT,
-    size_t num_threads = std::thread::hardware_concurrency()) {
+    Comparator comp,
+    MultiwayMergeAlgorithm mwma,
+    MultiwayMergeSplittingAlgorithm mwmsa,
+    size_t num_threads,
+    const Runner& run) {
 
     using RandomAccessIteratorPair =
         typename std::iterator_traits<RandomAccessIteratorIterator>
@@ -130,50 +167,23 @@ RandomAccessIterator3 parallel_multiway_merge_base(
             chunks.data(), num_threads);
     }
 
-#if defined(_OPENMP)
-#pragma omp parallel num_threads(num_threads)
-    {
-        size_t iam = omp_get_thread_num();
-
-        DiffType target_position = 0, local_size = 0;
-
-        for (size_t s = 0; s < num_seqs; ++s)
-        {
-            target_position += chunks[iam][s].first - seqs_ne[s].first;
-            local_size += chunks[iam][s].second - chunks[iam][s].first;
-        }
+    run(num_threads,
+        [&](size_t iam) {
+            DiffType target_position = 0, local_size = 0;
 
-        multiway_merge_base<Stable, false>(
-            chunks[iam].begin(), chunks[iam].end(),
-            target + target_position,
-            std::min(local_size, static_cast<DiffType>(size) - target_position),
-            comp, mwma);
-    }
-#else
-    std::vector<std::thread> threads(num_threads);
-
-    for (size_t iam = 0; iam < num_threads; ++iam) {
-        threads[iam] = std::thread(
-            [&, iam]() {
-                DiffType target_position = 0, local_size = 0;
-
-                for (size_t s = 0; s < num_seqs; ++s)
-                {
-                    target_position += chunks[iam][s].first - seqs_ne[s].first;
-                    local_size += chunks[iam][s].second - chunks[iam][s].first;
-                }
-
-                multiway_merge_base<Stable, false>(
-                    chunks[iam].begin(), chunks[iam].end(),
-                    target + target_position,
-                    std::min(local_size, static_cast<DiffType>(size) - target_position),
-                    comp, mwma);
-            });
-    }
+            for (size_t s = 0; s < num_seqs; ++s)
+            {
+                target_position += chunks[iam][s].first - seqs_ne[s].first;
+                local_size += chunks[iam][s].second - chunks[iam][s].first;
+            }
 
-    for (size_t i = 0; i < num_threads; ++i)
-        threads[i].join();
-#endif
+            multiway_merge_base<Stable, false>(
+                chunks[iam].begin(), chunks[iam].end(),
+                target + target_position,
+                std::min(local_size,
+                         static_cast<DiffType>(size) - target_position),
+                comp, mwma);
+        });
 
     // update ends of sequences
     size_t count_seqs = 0;
@@ -186,6 +196,95 @@ RandomAccessIterator3 parallel_multiway_merge_base(
     return target + size;
 }
 
+} // namespace multiway_merge_detail
+
+/*!
+ * Parallel multi-way merge routine.
+ *
+ * Implemented either using OpenMP or with std::threads, depending on if
+ * compiled with -fopenmp or not. The OpenMP version uses the implicit thread
+ * pool, which is faster when using this method often.
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator out output sequence.
+ * \param size Maximum size to merge.
+ * \param comp Comparator.
+ * \param mwma MultiwayMergeAlgorithm set to use.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ * \param num_threads Number of threads to use (defaults to all cores)
+ * \tparam Stable Stable merging incurs a performance penalty.
+ * \return End iterator of output sequence.
+ */
+template <
+    bool Stable,
+    typename RandomAccessIteratorIterator,
+    typename RandomAccessIterator3,
+    typename Comparator = std::less<
+        typename std::iterator_traits<
+            typename std::iterator_traits<RandomAccessIteratorIterator>
+            ::value_type::first_type>::value_type> >
+RandomAccessIterator3 parallel_multiway_merge_base(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    RandomAccessIterator3 target,
+    const typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    Comparator comp = Comparator(),
+    MultiwayMergeAlgorithm mwma = MWMA_ALGORITHM_DEFAULT,
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT,
+    size_t num_threads = std::thread::hardware_concurrency()) {
+
+    return multiway_merge_detail::parallel_multiway_merge_run<Stable>(
+        seqs_begin, seqs_end, target, size, comp, mwma, mwmsa, num_threads,
+        multiway_merge_detail::ThreadRunner());
+}
+
+/*!
+ * Parallel multi-way merge routine running on a ThreadPool.
+ *
+ * The sequences are split into pool.size() parts, which are merged as jobs on
+ * the pool, one of them in the calling thread. This avoids creating threads on
+ * every call. The pool may be shared, but the function must not be called from
+ * within one of its jobs.
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator out output sequence.
+ * \param size Maximum size to merge.
+ * \param comp Comparator.
+ * \param pool ThreadPool to run the merge on.
+ * \param mwma MultiwayMergeAlgorithm set to use.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ * \tparam Stable Stable merging incurs a performance penalty.
+ * \return End iterator of output sequence.
+ */
+template <
+    bool Stable,
+    typename RandomAccessIteratorIterator,
+    typename RandomAccessIterator3,
+    typename Comparator>
+RandomAccessIterator3 parallel_multiway_merge_base(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    RandomAccessIterator3 target,
+    const typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    Comparator comp,
+    ThreadPool& pool,
+    MultiwayMergeAlgorithm mwma = MWMA_ALGORITHM_DEFAULT,
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT) {
+
+    return multiway_merge_detail::parallel_multiway_merge_run<Stable>(
+        seqs_begin, seqs_end, target, size, comp, mwma, mwmsa,
+        std::max<size_t>(pool.size(), 1),
+        multiway_merge_detail::ThreadPoolRunner { pool });
+}
+
 /******************************************************************************/
 // parallel_multiway_merge() Frontends
 
@@ -315,6 +414,104 @@ RandomAccessIterator3 stable_parallel_multiway_merge(
     }
 }
 
+/*!
+ * Parallel multi-way merge routine running on a ThreadPool, see
+ * parallel_multiway_merge_base().
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator out output sequence.
+ * \param size Maximum size to merge.
+ * \param comp Comparator.
+ * \param pool ThreadPool to run the merge on.
+ * \param mwma MultiwayMergeAlgorithm set to use.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ * \return End iterator of output sequence.
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename RandomAccessIterator3,
+    typename Comparator>
+RandomAccessIterator3 parallel_multiway_merge(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    RandomAccessIterator3 target,
+    const typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    Comparator comp,
+    ThreadPool& pool,
+    MultiwayMergeAlgorithm mwma = MWMA_ALGORITHM_DEFAULT,
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT) {
+
+    if (seqs_begin == seqs_end)
+        return target;
+
+    if (!parallel_multiway_merge_force_sequential &&
+        (parallel_multiway_merge_force_parallel ||
+         (pool.size() > 1 &&
+          (static_cast<size_t>(seqs_end - seqs_begin)
+           >= parallel_multiway_merge_minimal_k) &&
+          static_cast<size_t>(size) >= parallel_multiway_merge_minimal_n))) {
+        return parallel_multiway_merge_base</* Stable */ false>(
+            seqs_begin, seqs_end, target, size, comp, pool, mwma, mwmsa);
+    }
+    else {
+        return multiway_merge_base</* Stable */ false, /* Sentinels */ false>(
+            seqs_begin, seqs_end, target, size, comp, mwma);
+    }
+}
+
+/*!
+ * Stable parallel multi-way merge routine running on a ThreadPool, see
+ * parallel_multiway_merge_base().
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param target Begin iterator out output sequence.
+ * \param size Maximum size to merge.
+ * \param comp Comparator.
+ * \param pool ThreadPool to run the merge on.
+ * \param mwma MultiwayMergeAlgorithm set to use.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ * \return End iterator of output sequence.
+ */
+template <
+    typename RandomAccessIteratorIterator,
+    typename RandomAccessIterator3,
+    typename Comparator>
+RandomAccessIterator3 stable_parallel_multiway_merge(
+    RandomAccessIteratorIterator seqs_begin,
+    RandomAccessIteratorIterator seqs_end,
+    RandomAccessIterator3 target,
+    const typename std::iterator_traits<
+        typename std::iterator_traits<
+            RandomAccessIteratorIterator>::value_type::first_type>::
+    difference_type size,
+    Comparator comp,
+    ThreadPool& pool,
+    MultiwayMergeAlgorithm mwma = MWMA_ALGORITHM_DEFAULT,
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT) {
+
+    if (seqs_begin == seqs_end)
+        return target;
+
+    if (!parallel_multiway_merge_force_sequential &&
+        (parallel_multiway_merge_force_parallel ||
+         (pool.size() > 1 &&
+          (static_cast<size_t>(seqs_end - seqs_begin)
+           >= parallel_multiway_merge_minimal_k) &&
+          static_cast<size_t>(size) >= parallel_multiway_merge_minimal_n))) {
+        return parallel_multiway_merge_base</* Stable */ true>(
+            seqs_begin, seqs_end, target, size, comp, pool, mwma, mwmsa);
+    }
+    else {
+        return multiway_merge_base</* Stable */ true, /* Sentinels */ false>(
+            seqs_begin, seqs_end, target, size, comp, mwma);
+    }
+}
+
 /*!
  * Parallel multi-way merge routine with sentinels.
  *
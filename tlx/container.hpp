@@ -17,20 +17,34 @@
 /*[[[perl
 print "#include <$_>\n" foreach sort glob("tlx/container/"."*.hpp");
 ]]]*/
+#include <tlx/container/arc_cache.hpp>
+#include <tlx/container/bit_tree_set.hpp>
 #include <tlx/container/btree.hpp>
 #include <tlx/container/btree_map.hpp>
 #include <tlx/container/btree_multimap.hpp>
 #include <tlx/container/btree_multiset.hpp>
 #include <tlx/container/btree_set.hpp>
+#include <tlx/container/clock_cache.hpp>
+#include <tlx/container/concurrent_lru_cache.hpp>
+#include <tlx/container/d_ary_addressable_hash_heap.hpp>
 #include <tlx/container/d_ary_addressable_int_heap.hpp>
+#include <tlx/container/d_ary_aligned_heap.hpp>
 #include <tlx/container/d_ary_heap.hpp>
+#include <tlx/container/flat_lru_cache.hpp>
 #include <tlx/container/loser_tree.hpp>
 #include <tlx/container/lru_cache.hpp>
+#include <tlx/container/mirrored_ring_buffer.hpp>
+#include <tlx/container/mpmc_queue.hpp>
+#include <tlx/container/pairing_heap.hpp>
 #include <tlx/container/radix_heap.hpp>
 #include <tlx/container/ring_buffer.hpp>
+#include <tlx/container/s3fifo_cache.hpp>
+#include <tlx/container/sequence_heap.hpp>
 #include <tlx/container/simple_vector.hpp>
 #include <tlx/container/splay_tree.hpp>
+#include <tlx/container/spsc_queue.hpp>
 #include <tlx/container/string_view.hpp>
+#include <tlx/container/timer_wheel.hpp>
 // [[[end]]]
 
 #endif // !TLX_CONTAINER_HEADER
@@ -0,0 +1,299 @@
+/*******************************************************************************
+ * tlx/container/arc_cache.hpp
+ *
+ * A fixed-capacity cache of (key -> value) pairs with Adaptive Replacement
+ * Cache (ARC) replacement.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_ARC_CACHE_HEADER
+#define TLX_CONTAINER_ARC_CACHE_HEADER
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * This is an expected O(1) cache of a fixed capacity, which contains a map of
+ * (key -> value) elements and evicts with the Adaptive Replacement Cache
+ * policy by Megiddo and Modha ("ARC: A Self-Tuning, Low Overhead Replacement
+ * Cache", FAST 2003). It has the same interface as LruCacheMap with a
+ * capacity, and put() automatically evicts a pair when the cache is full.
+ *
+ * The cached pairs are split into two LRU lists: T1 holds pairs seen once
+ * recently, and T2 pairs hit at least twice. The keys of pairs evicted from T1
+ * and T2 are remembered in the ghost LRU lists B1 and B2. A miss on a key in
+ * B1 grows the target size p of T1, a miss on a key in B2 shrinks it, and
+ * evictions take the LRU pair of T1 if it exceeds p, otherwise of T2. Hence
+ * the cache adapts between recency and frequency, and a scan only flushes T1.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class ArcCacheMap
+{
+public:
+    using KeyValuePair = typename std::pair<Key, Value>;
+
+protected:
+    using List = typename std::list<KeyValuePair>;
+    using GhostList = typename std::list<Key>;
+
+    //! which list an entry is in
+    enum Where : uint8_t { T1, T2, B1, B2 };
+
+    //! Location of a key in one of the four lists.
+    struct Location {
+        Where where;
+        //! entry in t1_ or t2_
+        typename List::iterator it;
+        //! entry in b1_ or b2_
+        typename GhostList::iterator ghost;
+    };
+
+    using Map = typename std::unordered_map<Key, Location, Hash, KeyEqual>;
+
+public:
+    //! construct a cache holding up to capacity pairs
+    explicit ArcCacheMap(size_t capacity)
+        : capacity_(capacity), map_(2 * capacity) {
+        assert(capacity > 0);
+    }
+
+    //! clear cache
+    void clear() {
+        t1_.clear();
+        t2_.clear();
+        b1_.clear();
+        b2_.clear();
+        map_.clear();
+        p_ = 0;
+    }
+
+    //! put or replace/touch item in cache, evicts a pair if the cache is full
+    void put(const Key& key, const Value& value) {
+        typename Map::iterator it = map_.find(key);
+        if (it != map_.end()) {
+            Location& loc = it->second;
+            if (loc.where == T1 || loc.where == T2) {
+                loc.it->second = value;
+                hit(loc);
+                return;
+            }
+            if (loc.where == B1) {
+                // ghost hit in B1: favor recency
+                size_t delta = b1_.size() >= b2_.size()
+                               ? 1 : b2_.size() / b1_.size();
+                p_ = p_ + delta < capacity_ ? p_ + delta : capacity_;
+                b1_.erase(loc.ghost);
+                make_room(false);
+            }
+            else {
+                // ghost hit in B2: favor frequency
+                size_t delta = b2_.size() >= b1_.size()
+                               ? 1 : b1_.size() / b2_.size();
+                p_ = p_ > delta ? p_ - delta : 0;
+                b2_.erase(loc.ghost);
+                make_room(true);
+            }
+            t2_.push_front(KeyValuePair(key, value));
+            loc.where = T2;
+            loc.it = t2_.begin();
+            return;
+        }
+
+        size_t t1b1 = t1_.size() + b1_.size();
+        if (t1b1 >= capacity_) {
+            if (t1_.size() < capacity_) {
+                drop_ghost(b1_);
+                make_room(false);
+            }
+            else {
+                // B1 is empty: discard the LRU pair of T1 without a ghost
+                map_.erase(t1_.back().first);
+                t1_.pop_back();
+            }
+        }
+        else {
+            size_t total = t1b1 + t2_.size() + b2_.size();
+            if (total >= 2 * capacity_)
+                drop_ghost(b2_);
+            make_room(false);
+        }
+
+        t1_.push_front(KeyValuePair(key, value));
+        Location loc;
+        loc.where = T1;
+        loc.it = t1_.begin();
+        map_.emplace(key, loc);
+    }
+
+    //! touch pair in cache for key. Throws if it is not in the cache.
+    void touch(const Key& key) {
+        if (!touch_if_exists(key))
+            throw std::range_error("There is no such key in cache");
+    }
+
+    //! touch pair in cache for key. Returns true if it exists.
+    bool touch_if_exists(const Key& key) noexcept {
+        return find_touch(key) != nullptr;
+    }
+
+    //! remove key from cache. Throws if it is not in the cache.
+    void erase(const Key& key) {
+        if (!erase_if_exists(key))
+            throw std::range_error("There is no such key in cache");
+    }
+
+    //! remove key from cache, also from the ghost lists. Returns true if it
+    //! was in the cache.
+    bool erase_if_exists(const Key& key) noexcept {
+        typename Map::iterator it = map_.find(key);
+        if (it == map_.end()) return false;
+        Location& loc = it->second;
+        bool cached = is_cached(loc);
+        if (loc.where == T1)
+            t1_.erase(loc.it);
+        else if (loc.where == T2)
+            t2_.erase(loc.it);
+        else if (loc.where == B1)
+            b1_.erase(loc.ghost);
+        else
+            b2_.erase(loc.ghost);
+        map_.erase(it);
+        return cached;
+    }
+
+    //! get value from cache for key. Throws if it is not in the cache.
+    const Value& get(const Key& key) const {
+        typename Map::const_iterator it = map_.find(key);
+        if (it == map_.end() || !is_cached(it->second))
+            throw std::range_error("There is no such key in cache");
+        return it->second.it->second;
+    }
+
+    //! get and touch value from cache for key. Throws if it is not in the
+    //! cache.
+    const Value& get_touch(const Key& key) {
+        const Value* v = find_touch(key);
+        if (!v)
+            throw std::range_error("There is no such key in cache");
+        return *v;
+    }
+
+    //! get and touch value from cache for key. Returns nullptr if it is not in
+    //! the cache.
+    const Value* find_touch(const Key& key) noexcept {
+        typename Map::iterator it = map_.find(key);
+        if (it == map_.end() || !is_cached(it->second)) return nullptr;
+        hit(it->second);
+        return &it->second.it->second;
+    }
+
+    //! test if key exists in cache
+    bool exists(const Key& key) const {
+        typename Map::const_iterator it = map_.find(key);
+        return it != map_.end() && is_cached(it->second);
+    }
+
+    //! return number of items in cache
+    size_t size() const noexcept { return t1_.size() + t2_.size(); }
+
+    //! return maximum number of items in cache
+    size_t capacity() const noexcept { return capacity_; }
+
+    //! return the current target size of the recency list T1
+    size_t target_recent() const noexcept { return p_; }
+
+    //! remove and return the pair which would be evicted next
+    KeyValuePair pop() {
+        assert(size());
+        if (evict_from_t1(false))
+            return demote(t1_, b1_, B1);
+        return demote(t2_, b2_, B2);
+    }
+
+private:
+    //! maximum number of pairs
+    size_t capacity_;
+    //! target size of t1_
+    size_t p_ = 0;
+
+    //! recency and frequency lists of cached pairs, MRU at the front
+    List t1_, t2_;
+    //! ghost lists of keys evicted from t1_ and t2_, MRU at the front
+    GhostList b1_, b2_;
+
+    //! map from key to its location in any of the four lists
+    Map map_;
+
+    //! whether the pair is cached, not only its key remembered
+    static bool is_cached(const Location& loc) {
+        return loc.where == T1 || loc.where == T2;
+    }
+
+    //! move a hit pair to the MRU position of T2
+    void hit(Location& loc) {
+        t2_.splice(t2_.begin(), loc.where == T1 ? t1_ : t2_, loc.it);
+        loc.where = T2;
+    }
+
+    //! whether REPLACE evicts from T1 rather than T2
+    bool evict_from_t1(bool in_b2) const {
+        if (t1_.empty()) return false;
+        if (t2_.empty()) return true;
+        return t1_.size() > p_ || (in_b2 && t1_.size() == p_);
+    }
+
+    //! the REPLACE subroutine of ARC, only evicts if the cache is full
+    void make_room(bool in_b2) {
+        if (size() < capacity_) return;
+        if (evict_from_t1(in_b2))
+            demote(t1_, b1_, B1);
+        else
+            demote(t2_, b2_, B2);
+    }
+
+    //! evict the LRU pair of list t, remember its key at the MRU position of
+    //! ghost list b, and return the pair
+    KeyValuePair demote(List& t, GhostList& b, Where where) {
+        typename List::iterator last = std::prev(t.end());
+        Location& loc = map_.find(last->first)->second;
+        b.push_front(last->first);
+        loc.where = where;
+        loc.ghost = b.begin();
+        KeyValuePair out = std::move(*last);
+        t.erase(last);
+        return out;
+    }
+
+    //! forget the LRU key of a ghost list
+    void drop_ghost(GhostList& b) {
+        if (b.empty()) return;
+        map_.erase(b.back());
+        b.pop_back();
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_ARC_CACHE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,251 @@
+/*******************************************************************************
+ * tlx/container/bit_tree_set.hpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_BIT_TREE_SET_HEADER
+#define TLX_CONTAINER_BIT_TREE_SET_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <tlx/math/clz.hpp>
+#include <tlx/math/ctz.hpp>
+#include <tlx/math/popcount.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * A set of integers from a fixed universe [0,U) implemented as a hierarchy of
+ * 64-ary bit arrays, similar to a van Emde Boas tree with constant fan-out.
+ *
+ * Level zero stores one bit per possible element. Each bit of level l+1
+ * records whether the corresponding 64-bit word of level l is non-zero. The
+ * top level consists of a single word. Thus the tree has ceil(log_64(U))
+ * levels, and insert(), erase(), successor(), predecessor(), min(), and max()
+ * all run in O(log_64 U) time, which is at most 11 word operations for 64-bit
+ * universes. Navigation uses only ctz() and clz() on machine words.
+ *
+ * This is the runtime-sized big brother of radix_heap_detail::BitArray, which
+ * is fixed at compile time and only supports find_lsb().
+ */
+class BitTreeSet
+{
+public:
+    using key_type = size_t;
+    using value_type = size_t;
+    using size_type = size_t;
+
+    //! returned by successor() and predecessor() if no such element exists.
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    //! construct an empty set with universe zero, call resize() before use.
+    BitTreeSet() = default;
+
+    //! construct an empty set of integers from [0,universe)
+    explicit BitTreeSet(size_t universe) {
+        resize(universe);
+    }
+
+    //! change the universe to [0,universe), this clears the set.
+    void resize(size_t universe) {
+        universe_ = universe;
+        size_ = 0;
+        levels_.clear();
+
+        size_t n = universe;
+        do {
+            n = (n + 63) / 64;
+            levels_.emplace_back(n, 0);
+        } while (n > 1);
+    }
+
+    //! remove all elements. Runs in O(U/64).
+    void clear() {
+        for (std::vector<uint64_t>& level : levels_)
+            std::fill(level.begin(), level.end(), 0);
+        size_ = 0;
+    }
+
+    //! \name Capacity
+    //! \{
+
+    //! number of elements in the set
+    size_t size() const { return size_; }
+
+    //! true if the set contains no elements
+    bool empty() const { return size_ == 0; }
+
+    //! size of the universe, elements must be smaller than this
+    size_t universe() const { return universe_; }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    //! insert x into the set, returns true if x was not contained before.
+    bool insert(size_t x) {
+        assert(x < universe_);
+        uint64_t& leaf = levels_[0][x / 64];
+        const uint64_t bit = uint64_t(1) << (x % 64);
+        if (leaf & bit) return false;
+        ++size_;
+
+        // set bits upwards until a word was already non-empty
+        bool was_empty = (leaf == 0);
+        leaf |= bit;
+        for (size_t l = 1; was_empty && l < levels_.size(); ++l) {
+            x /= 64;
+            uint64_t& word = levels_[l][x / 64];
+            was_empty = (word == 0);
+            word |= uint64_t(1) << (x % 64);
+        }
+        return true;
+    }
+
+    //! remove x from the set, returns true if x was contained.
+    bool erase(size_t x) {
+        assert(x < universe_);
+        uint64_t& leaf = levels_[0][x / 64];
+        const uint64_t bit = uint64_t(1) << (x % 64);
+        if (!(leaf & bit)) return false;
+        --size_;
+
+        // clear bits upwards until a word remains non-empty
+        leaf &= ~bit;
+        for (size_t l = 1; leaf == 0 && l < levels_.size(); ++l) {
+            x /= 64;
+            uint64_t& word = levels_[l][x / 64];
+            word &= ~(uint64_t(1) << (x % 64));
+            if (word != 0) break;
+        }
+        return true;
+    }
+
+    //! \}
+
+    //! \name Queries
+    //! \{
+
+    //! test whether x is contained in the set
+    bool contains(size_t x) const {
+        assert(x < universe_);
+        return (levels_[0][x / 64] >> (x % 64)) & 1;
+    }
+
+    //! smallest element in the set, or npos if the set is empty.
+    size_t min() const {
+        return empty() ? npos : find_next(0);
+    }
+
+    //! largest element in the set, or npos if the set is empty.
+    size_t max() const {
+        return empty() ? npos : find_prev(universe_ - 1);
+    }
+
+    //! smallest element y in the set with y > x, or npos if none exists.
+    size_t successor(size_t x) const {
+        if (universe_ == 0 || x >= universe_ - 1) return npos;
+        return find_next(x + 1);
+    }
+
+    //! largest element y in the set with y < x, or npos if none exists.
+    size_t predecessor(size_t x) const {
+        if (x == 0 || universe_ == 0) return npos;
+        return find_prev(x <= universe_ ? x - 1 : universe_ - 1);
+    }
+
+    //! smallest element y in the set with y >= x, or npos if none exists.
+    size_t find_next(size_t x) const {
+        if (x >= universe_) return npos;
+
+        // ascend until a word contains a set bit at or right of the position
+        size_t l = 0;
+        uint64_t word;
+        for ( ; ; ++l) {
+            const std::vector<uint64_t>& level = levels_[l];
+            word = level[x / 64] & (~uint64_t(0) << (x % 64));
+            if (word != 0) break;
+            x = x / 64 + 1;
+            if (l + 1 == levels_.size() || x >= level.size())
+                return npos;
+        }
+        x = (x / 64) * 64 + ctz(word);
+
+        // descend along the leftmost set bits
+        while (l-- != 0)
+            x = x * 64 + ctz(levels_[l][x]);
+
+        return x;
+    }
+
+    //! largest element y in the set with y <= x, or npos if none exists.
+    size_t find_prev(size_t x) const {
+        if (universe_ == 0) return npos;
+        if (x >= universe_) x = universe_ - 1;
+
+        // ascend until a word contains a set bit at or left of the position
+        size_t l = 0;
+        uint64_t word;
+        for ( ; ; ++l) {
+            word = levels_[l][x / 64] & ((uint64_t(2) << (x % 64)) - 1);
+            if (word != 0) break;
+            if (l + 1 == levels_.size() || x < 64)
+                return npos;
+            x = x / 64 - 1;
+        }
+        x = (x / 64) * 64 + (63 - clz(word));
+
+        // descend along the rightmost set bits
+        while (l-- != 0)
+            x = x * 64 + (63 - clz(levels_[l][x]));
+
+        return x;
+    }
+
+    //! number of elements y in the set with y < x. Runs in O(x/64) using
+    //! popcount() on the leaf words.
+    size_t rank(size_t x) const {
+        if (x > universe_) x = universe_;
+        const std::vector<uint64_t>& leaves = levels_[0];
+        size_t r = 0;
+        for (size_t i = 0; i < x / 64; ++i)
+            r += popcount(leaves[i]);
+        if (x % 64 != 0)
+            r += popcount(leaves[x / 64] & ((uint64_t(1) << (x % 64)) - 1));
+        return r;
+    }
+
+    //! \}
+
+private:
+    //! size of the universe
+    size_t universe_ = 0;
+
+    //! number of elements in the set
+    size_t size_ = 0;
+
+    //! bit array levels, levels_[0] contains the elements, levels_.back() is a
+    //! single word.
+    std::vector<std::vector<uint64_t> > levels_ { std::vector<uint64_t>(1) };
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_BIT_TREE_SET_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,224 @@
+/*******************************************************************************
+ * tlx/container/clock_cache.hpp
+ *
+ * A fixed-capacity cache of (key -> value) pairs with CLOCK replacement.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_CLOCK_CACHE_HEADER
+#define TLX_CONTAINER_CLOCK_CACHE_HEADER
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * This is an expected O(1) cache of a fixed capacity, which contains a map of
+ * (key -> value) elements and evicts with the CLOCK (second chance) policy. It
+ * has the same interface as LruCacheMap with a capacity, and put()
+ * automatically evicts a pair when the cache is full.
+ *
+ * The pairs are kept in a circular array of slots, each with a reference bit,
+ * which is set on every hit. To evict, the clock hand sweeps over the slots,
+ * clears set reference bits, and evicts the first pair whose bit is already
+ * clear. New pairs start with a clear bit. Hits only set a bit and do not
+ * reorder any list, which makes them cheaper than with LRU, and pairs that
+ * are inserted by a scan but never hit are evicted first.
+ *
+ * Key and Value must be default constructible.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class ClockCacheMap
+{
+public:
+    using KeyValuePair = typename std::pair<Key, Value>;
+
+protected:
+    //! A slot in the clock.
+    struct Slot {
+        KeyValuePair pair;
+        //! slot contains a pair
+        bool used = false;
+        //! pair was hit since the clock hand last passed
+        bool referenced = false;
+    };
+
+    using Map = typename std::unordered_map<Key, size_t, Hash, KeyEqual>;
+
+public:
+    //! construct a cache holding up to capacity pairs
+    explicit ClockCacheMap(size_t capacity)
+        : slots_(capacity), map_(capacity) {
+        assert(capacity > 0);
+    }
+
+    //! clear cache
+    void clear() {
+        for (Slot& s : slots_)
+            s = Slot();
+        map_.clear();
+        free_.clear();
+        hand_ = unused_ = 0;
+    }
+
+    //! put or replace/touch item in cache, evicts a pair if the cache is full
+    void put(const Key& key, const Value& value) {
+        typename Map::iterator it = map_.find(key);
+        if (it != map_.end()) {
+            Slot& s = slots_[it->second];
+            s.pair.second = value;
+            s.referenced = true;
+            return;
+        }
+        size_t i = take_slot();
+        Slot& s = slots_[i];
+        s.pair = KeyValuePair(key, value);
+        s.used = true;
+        s.referenced = false;
+        map_.emplace(key, i);
+    }
+
+    //! touch pair in cache for key. Throws if it is not in the cache.
+    void touch(const Key& key) {
+        if (!touch_if_exists(key))
+            throw std::range_error("There is no such key in cache");
+    }
+
+    //! touch pair in cache for key. Returns true if it exists.
+    bool touch_if_exists(const Key& key) noexcept {
+        return find_touch(key) != nullptr;
+    }
+
+    //! remove key from cache. Throws if it is not in the cache.
+    void erase(const Key& key) {
+        if (!erase_if_exists(key))
+            throw std::range_error("There is no such key in cache");
+    }
+
+    //! remove key from cache. Returns true if it existed.
+    bool erase_if_exists(const Key& key) noexcept {
+        typename Map::iterator it = map_.find(key);
+        if (it == map_.end()) return false;
+        release_slot(it->second);
+        map_.erase(it);
+        return true;
+    }
+
+    //! get value from cache for key. Throws if it is not in the cache.
+    const Value& get(const Key& key) const {
+        typename Map::const_iterator it = map_.find(key);
+        if (it == map_.end())
+            throw std::range_error("There is no such key in cache");
+        return slots_[it->second].pair.second;
+    }
+
+    //! get and touch value from cache for key. Throws if it is not in the
+    //! cache.
+    const Value& get_touch(const Key& key) {
+        const Value* v = find_touch(key);
+        if (!v)
+            throw std::range_error("There is no such key in cache");
+        return *v;
+    }
+
+    //! get and touch value from cache for key. Returns nullptr if it is not in
+    //! the cache.
+    const Value* find_touch(const Key& key) noexcept {
+        typename Map::iterator it = map_.find(key);
+        if (it == map_.end()) return nullptr;
+        Slot& s = slots_[it->second];
+        s.referenced = true;
+        return &s.pair.second;
+    }
+
+    //! test if key exists in cache
+    bool exists(const Key& key) const {
+        return map_.find(key) != map_.end();
+    }
+
+    //! return number of items in cache
+    size_t size() const noexcept { return map_.size(); }
+
+    //! return maximum number of items in cache
+    size_t capacity() const noexcept { return slots_.size(); }
+
+    //! remove and return the pair which the clock would evict next
+    KeyValuePair pop() {
+        assert(size());
+        size_t i = victim();
+        KeyValuePair out = std::move(slots_[i].pair);
+        map_.erase(out.first);
+        release_slot(i);
+        return out;
+    }
+
+private:
+    //! circular array of slots
+    std::vector<Slot> slots_;
+    //! map from key to slot
+    Map map_;
+    //! unused slots below unused_
+    std::vector<size_t> free_;
+    //! clock hand
+    size_t hand_ = 0;
+    //! slots at and after unused_ were never used
+    size_t unused_ = 0;
+
+    //! return an unused slot, evicts a pair if the cache is full
+    size_t take_slot() {
+        if (!free_.empty()) {
+            size_t i = free_.back();
+            free_.pop_back();
+            return i;
+        }
+        if (unused_ < slots_.size())
+            return unused_++;
+        size_t i = victim();
+        map_.erase(slots_[i].pair.first);
+        return i;
+    }
+
+    //! advance the clock hand to the next pair to evict
+    size_t victim() {
+        for ( ; ; ) {
+            size_t i = hand_;
+            if (++hand_ == slots_.size()) hand_ = 0;
+            Slot& s = slots_[i];
+            if (!s.used) continue;
+            if (s.referenced) {
+                s.referenced = false;
+                continue;
+            }
+            return i;
+        }
+    }
+
+    //! clear a slot and put it on the free list
+    void release_slot(size_t i) {
+        slots_[i] = Slot();
+        free_.push_back(i);
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_CLOCK_CACHE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,304 @@
+/*******************************************************************************
+ * tlx/container/concurrent_lru_cache.hpp
+ *
+ * A thread-safe LRU cache of (key -> value) pairs, which is sharded by key
+ * hash into independently locked FlatLruCacheMaps.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_CONCURRENT_LRU_CACHE_HEADER
+#define TLX_CONTAINER_CONCURRENT_LRU_CACHE_HEADER
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <shared_mutex>
+#endif
+
+#include <tlx/container/flat_lru_cache.hpp>
+#include <tlx/math/round_to_power_of_two.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+namespace concurrent_lru_cache_detail {
+
+#if __cplusplus >= 201703L
+//! Readers of a shard share the lock.
+using SharedMutex = std::shared_mutex;
+#else
+//! Without std::shared_mutex, readers take the lock exclusively.
+class SharedMutex : public std::mutex
+{
+public:
+    void lock_shared() { lock(); }
+    void unlock_shared() { unlock(); }
+};
+#endif
+
+//! RAII guard holding a SharedMutex in shared mode.
+class SharedLock
+{
+public:
+    explicit SharedLock(SharedMutex& m) : m_(m) { m_.lock_shared(); }
+    ~SharedLock() { m_.unlock_shared(); }
+
+    SharedLock(const SharedLock&) = delete;
+    SharedLock& operator = (const SharedLock&) = delete;
+
+private:
+    SharedMutex& m_;
+};
+
+} // namespace concurrent_lru_cache_detail
+
+/*!
+ * This is a thread-safe, capacity-bounded LRU cache which contains a map of
+ * (key -> value) elements. Keys are distributed by hash over a power of two
+ * number of shards. Each shard is a FlatLruCacheMap with its own recency list
+ * and its own lock, hence threads accessing different shards do not contend.
+ * The LRU order is maintained per shard, and the capacity is divided evenly
+ * among the shards.
+ *
+ * Values are returned by copy, since other threads may evict them at any
+ * time.
+ *
+ * If buffered promotions are enabled, a cache hit only takes the shard lock in
+ * shared mode and records the item's entry index in a small per-shard
+ * promotion buffer instead of moving the entry to the front of the recency
+ * list. Pending promotions are applied in one batch before the next
+ * modification of the shard, or by the reader that fills the buffer if it can
+ * acquire the lock without waiting. If the buffer is full, promotions are
+ * dropped. The LRU order is thus only approximate.
+ *
+ * Hits are not lock-free: they always take the shard lock, at least in shared
+ * mode. Before C++17 there is no std::shared_mutex, and the shared lock is the
+ * exclusive one. Buffered promotions then only shorten the critical section
+ * of a hit but do not allow concurrent hits on the same shard.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class ConcurrentLruCacheMap
+{
+public:
+    //! number of promotions buffered per shard
+    static constexpr size_t promotion_buffer_size = 64;
+
+protected:
+    using SharedMutex = concurrent_lru_cache_detail::SharedMutex;
+    using SharedLock = concurrent_lru_cache_detail::SharedLock;
+    using Lru = FlatLruCacheMap<Key, Value, Hash, KeyEqual>;
+
+    //! A shard, padded to avoid false sharing of the locks.
+    struct Shard {
+        //! lock of the shard, shared by readers
+        SharedMutex mutex;
+        //! LRU cache of the shard
+        Lru lru;
+        //! number of recorded promotions, may exceed the buffer size
+        std::atomic<size_t> pending { 0 };
+        //! entries of promotions to apply, these remain valid since the
+        //! promotions are applied before any modification of the shard.
+        typename Lru::entry_type promotions[promotion_buffer_size];
+        //! padding
+        char padding[64];
+
+        Shard(size_t capacity, const Hash& hash, const KeyEqual& equal)
+            : lru(capacity, hash, equal) { }
+    };
+
+    //! array of shards
+    std::vector<std::unique_ptr<Shard> > shards_;
+    //! mask for selecting the shard from the hash value
+    size_t shard_mask_;
+    //! total capacity of all shards
+    size_t capacity_;
+    //! whether to buffer promotions of cache hits
+    bool buffer_promotions_;
+    //! hash function
+    Hash hash_;
+
+public:
+    /*!
+     * Create a cache for up to capacity items.
+     *
+     * \param capacity          maximum total number of items
+     * \param num_shards        number of shards, rounded up to a power of
+     *                          two, and reduced such that each shard holds
+     *                          at least one item. Zero selects 4 * hardware
+     *                          threads.
+     * \param buffer_promotions buffer and batch promotions of cache hits
+     */
+    explicit ConcurrentLruCacheMap(
+        size_t capacity, size_t num_shards = 0,
+        bool buffer_promotions = false,
+        const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : capacity_(capacity), buffer_promotions_(buffer_promotions),
+          hash_(hash) {
+        if (num_shards == 0)
+            num_shards = 4 * std::max(1u, std::thread::hardware_concurrency());
+        num_shards = round_up_to_power_of_two(num_shards);
+        while (num_shards > 1 && num_shards > capacity)
+            num_shards /= 2;
+        shard_mask_ = num_shards - 1;
+        // the first capacity % num_shards shards get one more item
+        for (size_t i = 0; i < num_shards; ++i) {
+            size_t shard_capacity =
+                capacity / num_shards + (i < capacity % num_shards ? 1 : 0);
+            shards_.emplace_back(
+                new Shard(shard_capacity, hash, equal));
+        }
+    }
+
+    //! number of shards
+    size_t num_shards() const { return shards_.size(); }
+
+    //! maximum number of items in the cache
+    size_t capacity() const { return capacity_; }
+
+    //! return number of items in the cache, which may be outdated immediately.
+    size_t size() const {
+        size_t total = 0;
+        for (const std::unique_ptr<Shard>& s : shards_) {
+            SharedLock lock(s->mutex);
+            total += s->lru.size();
+        }
+        return total;
+    }
+
+    //! clear the cache
+    void clear() {
+        for (const std::unique_ptr<Shard>& s : shards_) {
+            std::unique_lock<SharedMutex> lock(s->mutex);
+            s->pending = 0;
+            s->lru.clear();
+        }
+    }
+
+    //! put or replace/touch item, evicts the least recently used item of the
+    //! shard if it is full.
+    void put(const Key& key, const Value& value) {
+        Shard& s = shard(key);
+        std::unique_lock<SharedMutex> lock(s.mutex);
+        apply_promotions(s);
+        s.lru.put(key, value);
+    }
+
+    //! get and touch value for key. Returns false if it is not in the cache.
+    bool get(const Key& key, Value& value) {
+        Shard& s = shard(key);
+        if (!buffer_promotions_) {
+            std::unique_lock<SharedMutex> lock(s.mutex);
+            const Value* v = s.lru.find_touch(key);
+            if (!v) return false;
+            value = *v;
+            return true;
+        }
+        bool full;
+        {
+            SharedLock lock(s.mutex);
+            typename Lru::entry_type entry;
+            const Value* v = s.lru.find(key, entry);
+            if (!v) return false;
+            value = *v;
+            full = !record_promotion(s, entry);
+        }
+        // the buffer is full: apply promotions if the lock is free
+        if (full && s.mutex.try_lock()) {
+            apply_promotions(s);
+            s.mutex.unlock();
+        }
+        return true;
+    }
+
+    /*!
+     * Get and touch value for key, or insert the value created by factory(key)
+     * if it is not in the cache. The factory is called without holding a lock,
+     * hence it may be called concurrently for the same key. In this case, the
+     * value inserted first is kept and returned by all callers.
+     */
+    template <typename Factory>
+    Value get_or_insert(const Key& key, Factory&& factory) {
+        Value value;
+        if (get(key, value))
+            return value;
+
+        Value created = factory(key);
+
+        Shard& s = shard(key);
+        std::unique_lock<SharedMutex> lock(s.mutex);
+        apply_promotions(s);
+        if (const Value* v = s.lru.find_touch(key))
+            return *v;
+        s.lru.put(key, created);
+        return created;
+    }
+
+    //! test if key exists in the cache
+    bool exists(const Key& key) const {
+        Shard& s = shard(key);
+        SharedLock lock(s.mutex);
+        return s.lru.exists(key);
+    }
+
+    //! remove key from the cache. Returns true if it existed.
+    bool erase(const Key& key) {
+        Shard& s = shard(key);
+        std::unique_lock<SharedMutex> lock(s.mutex);
+        apply_promotions(s);
+        return s.lru.erase_if_exists(key);
+    }
+
+private:
+    //! select the shard of a key using the middle bits of a multiplicative
+    //! hash, the FlatLruCacheMap index uses the top bits of another one.
+    Shard& shard(const Key& key) const {
+        uint64_t h = static_cast<uint64_t>(hash_(key));
+        return *shards_[((h * 0xC2B2AE3D27D4EB4Full) >> 32) & shard_mask_];
+    }
+
+    //! record a promotion while holding the shared lock. Returns false if the
+    //! buffer is full and the promotion was dropped.
+    bool record_promotion(Shard& s, typename Lru::entry_type entry) {
+        size_t i = s.pending.fetch_add(1, std::memory_order_relaxed);
+        if (i >= promotion_buffer_size)
+            return false;
+        // slot i is exclusive to this thread, and it is read only while
+        // holding the exclusive lock.
+        s.promotions[i] = entry;
+        return true;
+    }
+
+    //! apply buffered promotions while holding the exclusive lock.
+    void apply_promotions(Shard& s) {
+        size_t n = s.pending.load(std::memory_order_relaxed);
+        if (n == 0) return;
+        if (n > promotion_buffer_size) n = promotion_buffer_size;
+        for (size_t i = 0; i < n; ++i)
+            s.lru.touch_entry(s.promotions[i]);
+        s.pending.store(0, std::memory_order_relaxed);
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_CONCURRENT_LRU_CACHE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,486 @@
+/*******************************************************************************
+ * tlx/container/d_ary_addressable_hash_heap.hpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_D_ARY_ADDRESSABLE_HASH_HEAP_HEADER
+#define TLX_CONTAINER_D_ARY_ADDRESSABLE_HASH_HEAP_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include <tlx/math/integer_log2.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * This class implements an addressable priority queue for sparse keys,
+ * precisely a d-ary heap, like DAryAddressableIntHeap.
+ *
+ * Keys must be unique, but may be arbitrary (e.g. 64-bit) values. Instead of
+ * an array indexed by the keys, the positions of keys in the heap are stored
+ * in a compact open-addressing hash table with linear probing and backward
+ * shift deletion, hence the space is proportional to the number of items in
+ * the heap. Each heap cell also remembers the hash table slot of its key, such
+ * that moving items during sift operations requires no hash lookups.
+ *
+ * update_many() restores the heap property after the priorities of many keys
+ * changed at once, by sifting down only the changed nodes and their ancestors,
+ * or by rebuilding the whole heap if that is cheaper.
+ *
+ * \tparam KeyType    Key type, must be hashable and equality comparable.
+ * \tparam Arity      A positive integer.
+ * \tparam Compare    Function object.
+ * \tparam Hash       Hash function object for keys.
+ */
+template <typename KeyType, unsigned Arity = 2,
+          class Compare = std::less<KeyType>,
+          class Hash = std::hash<KeyType> >
+class DAryAddressableHashHeap
+{
+    static_assert(Arity, "Arity must be greater than zero.");
+
+public:
+    using key_type = KeyType;
+    using compare_type = Compare;
+    using hash_type = Hash;
+
+    static constexpr size_t arity = Arity;
+
+protected:
+    //! A cell in the heap: the key and its slot in the hash table.
+    struct Cell {
+        key_type key;
+        size_t   slot;
+    };
+
+    //! A slot in the hash table: a key and its position in the heap.
+    struct Slot {
+        key_type key;
+        size_t   pos;
+    };
+
+    //! Marks an empty hash table slot.
+    static constexpr size_t not_present = static_cast<size_t>(-1);
+
+    //! Cells in the heap.
+    std::vector<Cell> heap_;
+
+    //! Open-addressing hash table mapping keys to positions in heap_.
+    std::vector<Slot> table_;
+
+    //! table_.size() - 1, table_.size() is always a power of two.
+    size_t mask_ = 0;
+
+    //! shift for Fibonacci hashing: 64 - log2(table_.size())
+    unsigned shift_ = 64;
+
+    //! Compare function.
+    compare_type cmp_;
+
+    //! Hash function.
+    hash_type hash_;
+
+public:
+    //! Allocates an empty heap.
+    explicit DAryAddressableHashHeap(
+        compare_type cmp = compare_type(), hash_type hash = hash_type())
+        : cmp_(cmp), hash_(hash) { }
+
+    //! Allocates space for \c new_size items.
+    void reserve(size_t new_size) {
+        heap_.reserve(new_size);
+        if (!fits_table(new_size))
+            rehash(new_size);
+    }
+
+    //! Copy.
+    DAryAddressableHashHeap(const DAryAddressableHashHeap&) = default;
+    DAryAddressableHashHeap& operator = (const DAryAddressableHashHeap&) =
+        default;
+
+    //! Move.
+    DAryAddressableHashHeap(DAryAddressableHashHeap&&) = default;
+    DAryAddressableHashHeap& operator = (DAryAddressableHashHeap&&) = default;
+
+    //! Empties the heap.
+    void clear() {
+        for (Slot& s : table_)
+            s.pos = not_present;
+        heap_.clear();
+    }
+
+    //! Returns the number of items in the heap.
+    size_t size() const noexcept { return heap_.size(); }
+
+    //! Returns the capacity of the heap.
+    size_t capacity() const noexcept { return heap_.capacity(); }
+
+    //! Returns true if the heap has no items, false otherwise.
+    bool empty() const noexcept { return heap_.empty(); }
+
+    //! Returns the number of slots in the hash table.
+    size_t table_size() const noexcept { return table_.size(); }
+
+    //! Inserts a new item.
+    void push(const key_type& new_key) {
+        assert(!contains(new_key));
+        append(new_key);
+        sift_up(heap_.size() - 1);
+    }
+
+    //! Removes the item with key \c key.
+    void remove(const key_type& key) {
+        size_t s = find_slot(key);
+        assert(s != not_present);
+        remove_at(table_[s].pos);
+    }
+
+    //! Returns the top item.
+    const key_type& top() const noexcept {
+        assert(!empty());
+        return heap_[0].key;
+    }
+
+    //! Removes the top item.
+    void pop() {
+        assert(!empty());
+        remove_at(0);
+    }
+
+    //! Removes and returns the top item.
+    key_type extract_top() {
+        key_type top_item = top();
+        pop();
+        return top_item;
+    }
+
+    //! Rebuilds the heap.
+    void update_all() {
+        heapify();
+    }
+
+    /*!
+     * Updates the priority queue after the priority associated to the item with
+     * key \c key has been changed; if the key \c key is not present in the
+     * priority queue, it will be added.
+     *
+     * Note: if not called after a priority is changed, the behavior of the data
+     * structure is undefined.
+     */
+    void update(const key_type& key) {
+        size_t s = find_slot(key);
+        if (s == not_present) {
+            push(key);
+            return;
+        }
+        size_t h = table_[s].pos;
+        if (h && cmp_(heap_[h].key, heap_[parent(h)].key))
+            sift_up(h);
+        else
+            sift_down(h);
+    }
+
+    /*!
+     * Updates the priority queue after the priorities of all items in [first,
+     * last) have been changed; keys not present in the priority queue will be
+     * added. The keys must be distinct.
+     *
+     * This sifts down the changed nodes and all their ancestors in bottom-up
+     * order, which costs O(k log_d(n)) sift operations for k changed keys, or
+     * rebuilds the whole heap in O(n) if that is cheaper.
+     */
+    template <class InputIterator>
+    void update_many(InputIterator first, InputIterator last) {
+        std::vector<size_t> changed;
+        for ( ; first != last; ++first) {
+            size_t s = find_slot(*first);
+            if (s == not_present) {
+                changed.push_back(heap_.size());
+                append(*first);
+            }
+            else {
+                changed.push_back(table_[s].pos);
+            }
+        }
+        update_positions(changed);
+    }
+
+    //! Updates the priority queue after the priorities of all items in \c keys
+    //! have been changed, see update_many(first, last).
+    void update_many(const std::vector<key_type>& keys) {
+        update_many(keys.begin(), keys.end());
+    }
+
+    //! Returns true if the key \c key is in the heap, false otherwise.
+    bool contains(const key_type& key) const {
+        return find_slot(key) != not_present;
+    }
+
+    //! Builds a heap from a container. The keys must be distinct.
+    template <class InputIterator>
+    void build_heap(InputIterator first, InputIterator last) {
+        clear();
+        for ( ; first != last; ++first) {
+            assert(!contains(*first));
+            append(*first);
+        }
+        heapify();
+    }
+
+    //! Builds a heap from the vector \c keys. The keys must be distinct.
+    void build_heap(const std::vector<key_type>& keys) {
+        reserve(keys.size());
+        build_heap(keys.begin(), keys.end());
+    }
+
+    //! For debugging: runs a BFS from the root node and verifies that the heap
+    //! property is respected, and that the hash table is consistent.
+    bool sanity_check() {
+        // check the hash table
+        size_t occupied = 0;
+        for (size_t s = 0; s < table_.size(); ++s) {
+            if (table_[s].pos == not_present) continue;
+            ++occupied;
+            size_t h = table_[s].pos;
+            if (h >= heap_.size() || heap_[h].slot != s ||
+                !(heap_[h].key == table_[s].key))
+                return false;
+            if (find_slot(table_[s].key) != s)
+                return false;
+        }
+        if (occupied != heap_.size())
+            return false;
+        if (empty()) {
+            return true;
+        }
+        std::queue<size_t> q;
+        // Explore from the root.
+        q.push(0);
+        while (!q.empty()) {
+            size_t s = q.front();
+            q.pop();
+            size_t l = left(s);
+            for (size_t i = 0; i < arity && l < heap_.size(); ++i) {
+                // check that the priority of the children is not strictly less
+                // than their parent.
+                if (cmp_(heap_[l].key, heap_[s].key))
+                    return false;
+                q.push(l++);
+            }
+        }
+        return true;
+    }
+
+private:
+    //! Returns the position of the left child of the node at position \c k.
+    size_t left(size_t k) const { return arity * k + 1; }
+
+    //! Returns the position of the parent of the node at position \c k.
+    size_t parent(size_t k) const { return (k - 1) / arity; }
+
+    //! \name Hash Table
+    //! \{
+
+    //! Returns the home slot of a key (Fibonacci hashing).
+    size_t home_slot(const key_type& key) const {
+        return static_cast<size_t>(
+            (static_cast<uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ull)
+            >> shift_) & mask_;
+    }
+
+    //! Returns true if the table can hold n keys at load factor <= 3/4.
+    bool fits_table(size_t n) const {
+        return 4 * n <= 3 * table_.size();
+    }
+
+    //! Returns the slot of key or not_present.
+    size_t find_slot(const key_type& key) const {
+        if (table_.empty()) return not_present;
+        size_t s = home_slot(key);
+        while (table_[s].pos != not_present) {
+            if (table_[s].key == key) return s;
+            s = (s + 1) & mask_;
+        }
+        return not_present;
+    }
+
+    //! Inserts a key which is not present into the table, returns its slot.
+    size_t insert_slot(const key_type& key, size_t pos) {
+        size_t s = home_slot(key);
+        while (table_[s].pos != not_present)
+            s = (s + 1) & mask_;
+        table_[s].key = key;
+        table_[s].pos = pos;
+        return s;
+    }
+
+    //! Removes the key in slot s from the table by shifting back the
+    //! following keys of the cluster, and updates their heap cells.
+    void erase_slot(size_t s) {
+        size_t j = s;
+        while (true) {
+            j = (j + 1) & mask_;
+            if (table_[j].pos == not_present) break;
+            // keep the key at j if its home slot is cyclically in (s,j]
+            size_t k = home_slot(table_[j].key);
+            if (s <= j ? (s < k && k <= j) : (s < k || k <= j))
+                continue;
+            table_[s] = table_[j];
+            heap_[table_[s].pos].slot = s;
+            s = j;
+        }
+        table_[s].pos = not_present;
+    }
+
+    //! Rebuild the hash table with enough slots for n keys.
+    void rehash(size_t n) {
+        size_t cap = 16;
+        while (4 * n > 3 * cap) cap *= 2;
+        table_.assign(cap, Slot { key_type(), not_present });
+        mask_ = cap - 1;
+        shift_ = 64 - integer_log2_floor(cap);
+        for (size_t i = 0; i < heap_.size(); ++i)
+            heap_[i].slot = insert_slot(heap_[i].key, i);
+    }
+
+    //! \}
+
+    //! Appends a key at the end of heap_ and inserts it into the table.
+    void append(const key_type& key) {
+        // double the table size when full
+        if (!fits_table(heap_.size() + 1))
+            rehash(table_.size());
+        size_t pos = heap_.size();
+        heap_.push_back(Cell { key, insert_slot(key, pos) });
+    }
+
+    //! Puts cell c at position k and updates its slot.
+    void place(size_t k, const Cell& c) {
+        heap_[k] = c;
+        table_[c.slot].pos = k;
+    }
+
+    //! Removes the item at position h.
+    void remove_at(size_t h) {
+        size_t s = heap_[h].slot;
+        if (h + 1 != heap_.size())
+            place(h, heap_.back());
+        heap_.pop_back();
+        erase_slot(s);
+        // If we did not remove the last item in the heap vector.
+        if (h < size()) {
+            if (h && cmp_(heap_[h].key, heap_[parent(h)].key)) {
+                sift_up(h);
+            }
+            else {
+                sift_down(h);
+            }
+        }
+    }
+
+    //! Pushes the node at position \c k up until either it becomes the root or
+    //! its parent has lower or equal priority.
+    void sift_up(size_t k) {
+        Cell value = heap_[k];
+        size_t p = parent(k);
+        while (k > 0 && !cmp_(heap_[p].key, value.key)) {
+            place(k, heap_[p]);
+            k = p, p = parent(k);
+        }
+        place(k, value);
+    }
+
+    //! Pushes the item at position \c k down until either it becomes a leaf or
+    //! all its children have higher priority
+    void sift_down(size_t k) {
+        Cell value = heap_[k];
+        while (true) {
+            size_t l = left(k);
+            if (l >= heap_.size()) {
+                break;
+            }
+            // Get the min child.
+            size_t c = l;
+            size_t right = std::min(heap_.size(), c + arity);
+            while (++l < right) {
+                if (cmp_(heap_[l].key, heap_[c].key)) {
+                    c = l;
+                }
+            }
+
+            // Current item has lower or equal priority than the child with
+            // minimum priority, stop.
+            if (!cmp_(heap_[c].key, value.key)) {
+                break;
+            }
+
+            // Swap current item with the child with minimum priority.
+            place(k, heap_[c]);
+            k = c;
+        }
+        place(k, value);
+    }
+
+    //! Restores the heap property after the items at the given positions
+    //! changed. Each subtree without changed nodes is still a heap, so sifting
+    //! down all changed nodes and their ancestors in decreasing order of
+    //! position suffices.
+    void update_positions(std::vector<size_t>& changed) {
+        std::vector<size_t> nodes;
+        for (size_t k : changed) {
+            while (true) {
+                nodes.push_back(k);
+                if (k == 0) break;
+                k = parent(k);
+            }
+            // rebuilding everything is cheaper than many sift operations
+            if (nodes.size() >= heap_.size()) {
+                heapify();
+                return;
+            }
+        }
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        for (size_t i = nodes.size(); i != 0; --i)
+            sift_down(nodes[i - 1]);
+    }
+
+    //! Reorganize heap_ into a heap.
+    void heapify() {
+        if (heap_.size() >= 2) {
+            // Iterate from the last internal node up to the root.
+            size_t last_internal = (heap_.size() - 2) / arity;
+            for (size_t i = last_internal + 1; i; --i)
+                sift_down(i - 1);
+        }
+    }
+};
+
+//! make template alias due to similarity with std::priority_queue
+template <typename KeyType, unsigned Arity = 2,
+          typename Compare = std::less<KeyType>,
+          typename Hash = std::hash<KeyType> >
+using d_ary_addressable_hash_heap =
+    DAryAddressableHashHeap<KeyType, Arity, Compare, Hash>;
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_D_ARY_ADDRESSABLE_HASH_HEAP_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,494 @@
+/*******************************************************************************
+ * tlx/container/d_ary_aligned_heap.hpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_D_ARY_ALIGNED_HEAP_HEADER
+#define TLX_CONTAINER_D_ARY_ALIGNED_HEAP_HEADER
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <tlx/math/ctz.hpp>
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+namespace d_ary_heap_detail {
+
+//! size of a cache line, to which the heap arrays are aligned.
+static constexpr size_t cache_line_size = 64;
+
+/*!
+ * Allocator returning memory aligned to at least Alignment bytes. The raw
+ * pointer returned by operator new is stored directly in front of the aligned
+ * block.
+ */
+template <typename Type, size_t Alignment = cache_line_size>
+class AlignedAllocator
+{
+    static_assert(Alignment >= sizeof(void*) &&
+                  (Alignment & (Alignment - 1)) == 0,
+                  "Alignment must be a power of two holding a pointer");
+
+public:
+    using value_type = Type;
+    using pointer = Type *;
+    using const_pointer = const Type *;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    //! C++11 type flag
+    using is_always_equal = std::true_type;
+    //! C++11 type flag
+    using propagate_on_container_move_assignment = std::true_type;
+
+    //! Return allocator for different type.
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept { }
+
+    //! Allocate n objects of Type, aligned to Alignment bytes.
+    pointer allocate(size_type n, const void* /* hint */ = nullptr) {
+        char* raw = static_cast<char*>(
+            ::operator new (n * sizeof(Type) + Alignment));
+        char* aligned = raw + Alignment -
+                        (reinterpret_cast<uintptr_t>(raw) & (Alignment - 1));
+        reinterpret_cast<char**>(aligned)[-1] = raw;
+        return reinterpret_cast<pointer>(aligned);
+    }
+
+    //! Deallocate memory returned by allocate().
+    void deallocate(pointer p, size_type /* n */) noexcept {
+        if (p == nullptr) return;
+        ::operator delete (reinterpret_cast<char**>(p)[-1]);
+    }
+};
+
+template <typename T, typename U, size_t A>
+bool operator == (const AlignedAllocator<T, A>&,
+                  const AlignedAllocator<U, A>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U, size_t A>
+bool operator != (const AlignedAllocator<T, A>&,
+                  const AlignedAllocator<U, A>&) noexcept {
+    return false;
+}
+
+/*!
+ * Selects the index of the minimum of Arity consecutive keys with respect to
+ * Compare. This generic version is used for arbitrary key types and
+ * comparators, and breaks ties towards the smaller index.
+ */
+template <typename KeyType, size_t Arity, typename Compare,
+          typename Enable = void>
+struct SelectChild {
+    static constexpr bool simd = false;
+
+    static size_t select(const KeyType* c, const Compare& cmp) {
+        size_t m = 0;
+        for (size_t i = 1; i < Arity; ++i) {
+            if (cmp(c[i], c[m]))
+                m = i;
+        }
+        return m;
+    }
+};
+
+#if defined(__SSE4_1__)
+
+//! SSE operations for selecting the minimum or maximum of integer vectors.
+template <typename KeyType, typename Compare>
+struct SimdOps {
+    static constexpr bool available = false;
+    static constexpr size_t lanes = 1;
+};
+
+template <bool IsMin, bool IsSigned>
+struct SimdOps32 {
+    static constexpr bool available = true;
+    static constexpr size_t lanes = 4;
+
+    static __m128i select(__m128i a, __m128i b) {
+        return IsMin ? (IsSigned ? _mm_min_epi32(a, b) : _mm_min_epu32(a, b))
+               : (IsSigned ? _mm_max_epi32(a, b) : _mm_max_epu32(a, b));
+    }
+    static __m128i reduce(__m128i m) {
+        m = select(m, _mm_shuffle_epi32(m, 0x4E));
+        return select(m, _mm_shuffle_epi32(m, 0xB1));
+    }
+    static unsigned equal_mask(__m128i a, __m128i b) {
+        return static_cast<unsigned>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b))));
+    }
+};
+
+template <>
+struct SimdOps<uint32_t, std::less<uint32_t> >
+    : public SimdOps32</* IsMin */ true, /* IsSigned */ false>{ };
+template <>
+struct SimdOps<uint32_t, std::greater<uint32_t> >
+    : public SimdOps32</* IsMin */ false, /* IsSigned */ false>{ };
+template <>
+struct SimdOps<int32_t, std::less<int32_t> >
+    : public SimdOps32</* IsMin */ true, /* IsSigned */ true>{ };
+template <>
+struct SimdOps<int32_t, std::greater<int32_t> >
+    : public SimdOps32</* IsMin */ false, /* IsSigned */ true>{ };
+
+#if defined(__SSE4_2__)
+
+template <bool IsMin, bool IsSigned>
+struct SimdOps64 {
+    static constexpr bool available = true;
+    static constexpr size_t lanes = 2;
+
+    static __m128i select(__m128i a, __m128i b) {
+        // there is no unsigned 64-bit compare: flip the sign bits instead.
+        const __m128i flip = _mm_set1_epi64x(
+            IsSigned ? 0 : static_cast<int64_t>(uint64_t(1) << 63));
+        const __m128i gt = _mm_cmpgt_epi64(
+            _mm_xor_si128(a, flip), _mm_xor_si128(b, flip));
+        return IsMin ? _mm_blendv_epi8(a, b, gt) : _mm_blendv_epi8(b, a, gt);
+    }
+    static __m128i reduce(__m128i m) {
+        return select(m, _mm_shuffle_epi32(m, 0x4E));
+    }
+    static unsigned equal_mask(__m128i a, __m128i b) {
+        return static_cast<unsigned>(
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(a, b))));
+    }
+};
+
+template <>
+struct SimdOps<uint64_t, std::less<uint64_t> >
+    : public SimdOps64</* IsMin */ true, /* IsSigned */ false>{ };
+template <>
+struct SimdOps<uint64_t, std::greater<uint64_t> >
+    : public SimdOps64</* IsMin */ false, /* IsSigned */ false>{ };
+template <>
+struct SimdOps<int64_t, std::less<int64_t> >
+    : public SimdOps64</* IsMin */ true, /* IsSigned */ true>{ };
+template <>
+struct SimdOps<int64_t, std::greater<int64_t> >
+    : public SimdOps64</* IsMin */ false, /* IsSigned */ true>{ };
+
+#endif // defined(__SSE4_2__)
+
+/*!
+ * SSE version of SelectChild for 32- and 64-bit integers with std::less or
+ * std::greater: compute the vertical min/max over all vectors of the group, a
+ * horizontal min/max of the result, and then find the first lane equal to it.
+ */
+template <typename KeyType, size_t Arity, typename Compare>
+struct SelectChild<
+    KeyType, Arity, Compare,
+    typename std::enable_if<
+        SimdOps<KeyType, Compare>::available &&
+        Arity % SimdOps<KeyType, Compare>::lanes == 0 &&
+        Arity <= 64>::type>{
+    static constexpr bool simd = true;
+
+    using Ops = SimdOps<KeyType, Compare>;
+    static constexpr size_t vectors = Arity / Ops::lanes;
+
+    static size_t select(const KeyType* c, const Compare&) {
+        const __m128i* p = reinterpret_cast<const __m128i*>(c);
+        __m128i v[vectors];
+        for (size_t i = 0; i < vectors; ++i)
+            v[i] = _mm_loadu_si128(p + i);
+
+        __m128i m = v[0];
+        for (size_t i = 1; i < vectors; ++i)
+            m = Ops::select(m, v[i]);
+        m = Ops::reduce(m);
+
+        uint64_t mask = 0;
+        for (size_t i = 0; i < vectors; ++i) {
+            mask |= static_cast<uint64_t>(Ops::equal_mask(v[i], m))
+                    << (i * Ops::lanes);
+        }
+        return ctz(mask);
+    }
+};
+
+#endif // defined(__SSE4_1__)
+
+} // namespace d_ary_heap_detail
+
+/*!
+ * This class implements a d-ary comparison-based heap like DAryHeap, but with
+ * a cache-aligned memory layout: the array is aligned to a cache line and
+ * shifted by Arity-1 slots such that the Arity children of each node are
+ * stored consecutively starting at a multiple of Arity. If Arity *
+ * sizeof(KeyType) divides the cache line size, every sibling group lies in
+ * exactly one cache line, hence sift_down() touches one line per level.
+ *
+ * For 32- and 64-bit integer keys with std::less or std::greater, the minimum
+ * of a full sibling group is selected using SSE4.1 (32-bit) or SSE4.2 (64-bit)
+ * horizontal min/max, if the compiler targets these instruction sets
+ * (e.g. with -msse4.2 or -march=native). Otherwise a scalar loop is used.
+ *
+ * \tparam KeyType    Key type.
+ * \tparam Arity      A positive integer.
+ * \tparam Compare    Function object to order keys.
+ */
+template <typename KeyType, unsigned Arity = 8,
+          typename Compare = std::less<KeyType> >
+class DAryAlignedHeap
+{
+    static_assert(Arity, "Arity must be greater than zero.");
+
+public:
+    using key_type = KeyType;
+    using compare_type = Compare;
+
+    static constexpr size_t arity = Arity;
+
+    //! true if sift_down() uses SIMD instructions to select children.
+    static constexpr bool simd_select = d_ary_heap_detail::SelectChild<
+        key_type, arity, compare_type>::simd;
+
+protected:
+    using allocator_type = d_ary_heap_detail::AlignedAllocator<key_type>;
+
+    //! number of unused slots in front of the root
+    static constexpr size_t offset_ = arity - 1;
+
+    //! Cells in the heap, with offset_ unused cells in front.
+    std::vector<key_type, allocator_type> heap_;
+
+    //! Compare function.
+    compare_type cmp_;
+
+public:
+    //! Allocates an empty heap.
+    explicit DAryAlignedHeap(compare_type cmp = compare_type())
+        : heap_(offset_), cmp_(cmp) { }
+
+    //! Allocates space for \c new_size items.
+    void reserve(size_t new_size) {
+        heap_.reserve(offset_ + new_size);
+    }
+
+    //! Copy.
+    DAryAlignedHeap(const DAryAlignedHeap&) = default;
+    DAryAlignedHeap& operator = (const DAryAlignedHeap&) = default;
+
+    //! Move.
+    DAryAlignedHeap(DAryAlignedHeap&& o)
+        : heap_(std::move(o.heap_)), cmp_(std::move(o.cmp_)) {
+        o.heap_.resize(offset_);
+    }
+    DAryAlignedHeap& operator = (DAryAlignedHeap&& o) {
+        if (this == &o) return *this;
+        heap_ = std::move(o.heap_), cmp_ = std::move(o.cmp_);
+        o.heap_.resize(offset_);
+        return *this;
+    }
+
+    //! Empties the heap.
+    void clear() {
+        heap_.resize(offset_);
+    }
+
+    //! Returns the number of items in the heap.
+    size_t size() const noexcept { return heap_.size() - offset_; }
+
+    //! Returns the capacity of the heap.
+    size_t capacity() const noexcept { return heap_.capacity() - offset_; }
+
+    //! Returns true if the heap has no items, false otherwise.
+    bool empty() const noexcept { return size() == 0; }
+
+    //! Inserts a new item.
+    void push(const key_type& new_key) {
+        // Insert the new item at the end of the heap.
+        heap_.push_back(new_key);
+        sift_up(size() - 1);
+    }
+
+    //! Inserts a new item.
+    void push(key_type&& new_key) {
+        // Insert the new item at the end of the heap.
+        heap_.push_back(std::move(new_key));
+        sift_up(size() - 1);
+    }
+
+    //! Returns the top item.
+    const key_type& top() const noexcept {
+        assert(!empty());
+        return heap_[offset_];
+    }
+
+    //! Removes the top item.
+    void pop() {
+        assert(!empty());
+        std::swap(heap_[offset_], heap_.back());
+        heap_.pop_back();
+        if (!empty())
+            sift_down(0);
+    }
+
+    //! Removes and returns the top item.
+    key_type extract_top() {
+        key_type top_item = top();
+        pop();
+        return top_item;
+    }
+
+    //! Rebuilds the heap.
+    void update_all() {
+        heapify();
+    }
+
+    //! Builds a heap from a container.
+    template <class InputIterator>
+    void build_heap(InputIterator first, InputIterator last) {
+        heap_.resize(offset_);
+        heap_.insert(heap_.end(), first, last);
+        heapify();
+    }
+
+    //! Builds a heap from the vector \c keys. Items of \c keys are copied.
+    void build_heap(const std::vector<key_type>& keys) {
+        build_heap(keys.begin(), keys.end());
+    }
+
+    //! For debugging: runs a BFS from the root node and verifies that the heap
+    //! property is respected.
+    bool sanity_check() {
+        if (empty()) {
+            return true;
+        }
+        // check alignment of the array
+        if (reinterpret_cast<uintptr_t>(heap_.data()) %
+            d_ary_heap_detail::cache_line_size != 0)
+            return false;
+        std::queue<size_t> q;
+        // Explore from the root.
+        q.push(0);
+        while (!q.empty()) {
+            size_t s = q.front();
+            q.pop();
+            size_t l = left(s);
+            for (size_t i = 0; i < arity && l < size(); ++i) {
+                // Check that the priority of the children is not strictly less
+                // than their parent.
+                if (cmp_(at(l), at(s)))
+                    return false;
+                q.push(l++);
+            }
+        }
+        return true;
+    }
+
+private:
+    //! Returns the item at logical position \c k.
+    key_type& at(size_t k) { return heap_[offset_ + k]; }
+
+    //! Returns the position of the left child of the node at position \c k.
+    size_t left(size_t k) const { return arity * k + 1; }
+
+    //! Returns the position of the parent of the node at position \c k.
+    size_t parent(size_t k) const { return (k - 1) / arity; }
+
+    //! Returns the position of the child with minimum priority among the
+    //! children starting at position \c l.
+    size_t min_child(size_t l) {
+        if (l + arity <= size()) {
+            // full sibling group: use (SIMD) selection
+            return l + d_ary_heap_detail::SelectChild<
+                key_type, arity, compare_type>::select(&at(l), cmp_);
+        }
+        size_t c = l;
+        while (++l < size()) {
+            if (cmp_(at(l), at(c))) {
+                c = l;
+            }
+        }
+        return c;
+    }
+
+    //! Pushes the node at position \c k up until either it becomes the root or
+    //! its parent has lower or equal priority.
+    void sift_up(size_t k) {
+        key_type value = std::move(at(k));
+        size_t p = parent(k);
+        while (k > 0 && !cmp_(at(p), value)) {
+            at(k) = std::move(at(p));
+            k = p, p = parent(k);
+        }
+        at(k) = std::move(value);
+    }
+
+    //! Pushes the item at position \c k down until either it becomes a leaf or
+    //! all its children have higher priority
+    void sift_down(size_t k) {
+        key_type value = std::move(at(k));
+        while (true) {
+            size_t l = left(k);
+            if (l >= size()) {
+                break;
+            }
+            // Get the min child.
+            size_t c = min_child(l);
+
+            // Current item has lower or equal priority than the child with
+            // minimum priority, stop.
+            if (!cmp_(at(c), value)) {
+                break;
+            }
+
+            // Swap current item with the child with minimum priority.
+            at(k) = std::move(at(c));
+            k = c;
+        }
+        at(k) = std::move(value);
+    }
+
+    //! Reorganize heap_ into a heap.
+    void heapify() {
+        if (size() >= 2) {
+            // Iterate from the last internal node up to the root.
+            size_t last_internal = (size() - 2) / arity;
+            for (size_t i = last_internal + 1; i; --i)
+                sift_down(i - 1);
+        }
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_D_ARY_ALIGNED_HEAP_HEADER
+
+/******************************************************************************/
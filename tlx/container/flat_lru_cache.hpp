@@ -0,0 +1,463 @@
+/*******************************************************************************
+ * tlx/container/flat_lru_cache.hpp
+ *
+ * A fixed-capacity LRU cache stored in flat arrays without per-item
+ * allocations.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_FLAT_LRU_CACHE_HEADER
+#define TLX_CONTAINER_FLAT_LRU_CACHE_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <tlx/math/integer_log2.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+namespace flat_lru_cache_detail {
+
+/*!
+ * Common implementation of FlatLruCacheSet and FlatLruCacheMap. All entries
+ * live in one array allocated at construction. The recency list is threaded
+ * through the array by 32-bit prev/next indexes, and keys are located with an
+ * open-addressing index table of 32-bit entry numbers using linear probing at
+ * load factor <= 1/2 and backward-shift deletion. Hence, the overhead per
+ * entry is 16 bytes, and no operation allocates memory.
+ *
+ * \tparam Key        Key type.
+ * \tparam Value      Stored entry type containing the key.
+ * \tparam KeyOfValue Function object with static get(const Value&) returning
+ *                    the key of an entry.
+ */
+template <typename Key, typename Value, typename KeyOfValue,
+          typename Hash, typename KeyEqual>
+class FlatLruCacheBase
+{
+protected:
+    using index_type = uint32_t;
+
+    //! marks empty index slots and the ends of the recency list
+    static constexpr index_type nil = static_cast<index_type>(-1);
+
+    //! An entry in the array, the value is only constructed while in use.
+    struct Entry {
+        typename std::aligned_storage<
+            sizeof(Value), alignof(Value)>::type storage;
+        //! more recently used entry, or nil
+        index_type prev;
+        //! less recently used entry, or next free entry, or nil
+        index_type next;
+    };
+
+    //! array of all entries
+    std::vector<Entry> entries_;
+    //! open-addressing index into entries_
+    std::vector<index_type> index_;
+    //! mask for index_ positions
+    size_t mask_;
+    //! shift for Fibonacci hashing: 64 - log2(index_.size())
+    unsigned shift_;
+
+    //! most recently used entry
+    index_type head_ = nil;
+    //! least recently used entry
+    index_type tail_ = nil;
+    //! list of free entries, linked by next
+    index_type free_ = nil;
+    //! number of entries ever used, the remaining ones are free
+    size_t used_ = 0;
+    //! number of items in the cache
+    size_t size_ = 0;
+
+    //! hash function
+    Hash hash_;
+    //! key equality
+    KeyEqual equal_;
+
+public:
+    explicit FlatLruCacheBase(size_t capacity, const Hash& hash = Hash(),
+                              const KeyEqual& equal = KeyEqual())
+        : entries_(capacity), hash_(hash), equal_(equal) {
+        if (capacity >= nil)
+            throw std::length_error("FlatLruCache capacity is too large");
+        size_t cap = 16;
+        while (cap < 2 * capacity) cap *= 2;
+        index_.assign(cap, index_type(nil));
+        mask_ = cap - 1;
+        shift_ = 64 - integer_log2_floor(cap);
+    }
+
+    //! non-copyable: delete copy-constructor
+    FlatLruCacheBase(const FlatLruCacheBase&) = delete;
+    //! non-copyable: delete assignment operator
+    FlatLruCacheBase& operator = (const FlatLruCacheBase&) = delete;
+
+    //! move-constructor
+    FlatLruCacheBase(FlatLruCacheBase&& other) noexcept
+        : entries_(std::move(other.entries_)),
+          index_(std::move(other.index_)),
+          mask_(other.mask_), shift_(other.shift_),
+          head_(other.head_), tail_(other.tail_), free_(other.free_),
+          used_(other.used_), size_(other.size_),
+          hash_(std::move(other.hash_)), equal_(std::move(other.equal_)) {
+        other.head_ = other.tail_ = other.free_ = nil;
+        other.used_ = other.size_ = 0;
+    }
+
+    ~FlatLruCacheBase() {
+        destroy_all();
+    }
+
+    //! clear LRU
+    void clear() {
+        destroy_all();
+        std::fill(index_.begin(), index_.end(), index_type(nil));
+        head_ = tail_ = free_ = nil;
+        used_ = size_ = 0;
+    }
+
+    //! touch item in LRU cache for key. Throws if it is not in the cache.
+    void touch(const Key& key) {
+        if (!touch_if_exists(key))
+            throw std::range_error("There is no such key in cache");
+    }
+
+    //! touch item in LRU cache for key. Returns true if it exists.
+    bool touch_if_exists(const Key& key) noexcept {
+        index_type e = index_[find_slot(key)];
+        if (e == nil) return false;
+        move_to_front(e);
+        return true;
+    }
+
+    //! remove key from LRU cache. Throws if it is not in the cache.
+    void erase(const Key& key) {
+        if (!erase_if_exists(key))
+            throw std::range_error("There is no such key in cache");
+    }
+
+    //! remove key from LRU cache. Returns true if it existed.
+    bool erase_if_exists(const Key& key) noexcept {
+        size_t slot = find_slot(key);
+        index_type e = index_[slot];
+        if (e == nil) return false;
+        erase_slot(slot);
+        unlink(e);
+        free_entry(e);
+        return true;
+    }
+
+    //! test if key exists in LRU cache
+    bool exists(const Key& key) const {
+        return index_[find_slot(key)] != nil;
+    }
+
+    //! return number of items in LRU cache
+    size_t size() const noexcept { return size_; }
+
+    //! return maximum number of items in LRU cache
+    size_t capacity() const noexcept { return entries_.size(); }
+
+    //! return true if no more items fit without eviction
+    bool full() const noexcept { return size_ == entries_.size(); }
+
+protected:
+    //! access the constructed value of an entry
+    Value& value(index_type e) {
+        return *reinterpret_cast<Value*>(&entries_[e].storage);
+    }
+    //! access the constructed value of an entry
+    const Value& value(index_type e) const {
+        return *reinterpret_cast<const Value*>(&entries_[e].storage);
+    }
+
+    //! return entry of key or nil
+    index_type find_entry(const Key& key) const {
+        return index_[find_slot(key)];
+    }
+
+    //! put or replace/touch an entry, evicts the least recently used entry if
+    //! the cache is full.
+    template <typename ValueRef>
+    void put_entry(const Key& key, ValueRef&& v) {
+        if (entries_.empty()) return;
+        size_t slot = find_slot(key);
+        index_type e = index_[slot];
+        if (e != nil) {
+            // replace in place and move to front
+            value(e) = std::forward<ValueRef>(v);
+            move_to_front(e);
+            return;
+        }
+        if (size_ == entries_.size()) {
+            // evict least recently used entry, which may shift the slots
+            index_type t = tail_;
+            erase_slot(find_slot(KeyOfValue::get(value(t))));
+            unlink(t);
+            free_entry(t);
+            slot = find_slot(key);
+        }
+        e = alloc_entry();
+        new (&entries_[e].storage)Value(std::forward<ValueRef>(v));
+        index_[slot] = e;
+        push_front(e);
+        ++size_;
+    }
+
+    //! remove and return the least recently used entry
+    Value pop_entry() {
+        assert(size_);
+        index_type t = tail_;
+        erase_slot(find_slot(KeyOfValue::get(value(t))));
+        unlink(t);
+        Value out = std::move(value(t));
+        free_entry(t);
+        return out;
+    }
+
+    //! move entry to the front of the recency list
+    void move_to_front(index_type e) {
+        if (e == head_) return;
+        unlink(e);
+        push_front(e);
+    }
+
+private:
+    //! Returns the home slot of a key (Fibonacci hashing).
+    size_t home_slot(const Key& key) const {
+        return static_cast<size_t>(
+            (static_cast<uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ull)
+            >> shift_) & mask_;
+    }
+
+    //! Returns the slot containing key, or the empty slot where it belongs.
+    size_t find_slot(const Key& key) const {
+        size_t s = home_slot(key);
+        while (index_[s] != nil && !equal_(KeyOfValue::get(value(index_[s])),
+                                           key))
+            s = (s + 1) & mask_;
+        return s;
+    }
+
+    //! Clears a slot and shifts following entries of the cluster back.
+    void erase_slot(size_t hole) {
+        size_t s = hole;
+        for ( ; ; ) {
+            s = (s + 1) & mask_;
+            if (index_[s] == nil) break;
+            size_t home = home_slot(KeyOfValue::get(value(index_[s])));
+            // move entry if its home is not cyclically in (hole, s]
+            if (((s - home) & mask_) >= ((s - hole) & mask_)) {
+                index_[hole] = index_[s];
+                hole = s;
+            }
+        }
+        index_[hole] = nil;
+    }
+
+    //! unlink entry from the recency list
+    void unlink(index_type e) {
+        Entry& x = entries_[e];
+        if (x.prev != nil) entries_[x.prev].next = x.next;
+        else head_ = x.next;
+        if (x.next != nil) entries_[x.next].prev = x.prev;
+        else tail_ = x.prev;
+    }
+
+    //! link entry as most recently used
+    void push_front(index_type e) {
+        Entry& x = entries_[e];
+        x.prev = nil;
+        x.next = head_;
+        if (head_ != nil) entries_[head_].prev = e;
+        else tail_ = e;
+        head_ = e;
+    }
+
+    //! take an unused entry
+    index_type alloc_entry() {
+        if (free_ != nil) {
+            index_type e = free_;
+            free_ = entries_[e].next;
+            return e;
+        }
+        return static_cast<index_type>(used_++);
+    }
+
+    //! destroy the value of an unlinked entry and put it on the free list
+    void free_entry(index_type e) {
+        value(e).~Value();
+        entries_[e].next = free_;
+        free_ = e;
+        --size_;
+    }
+
+    //! destroy all values in the recency list
+    void destroy_all() {
+        for (index_type e = head_; e != nil; e = entries_[e].next)
+            value(e).~Value();
+    }
+};
+
+//! Extracts the key of a set entry.
+template <typename Key>
+struct KeyOfKey {
+    static const Key& get(const Key& k) { return k; }
+};
+
+//! Extracts the key of a map entry.
+template <typename Key, typename Value>
+struct KeyOfPair {
+    static const Key& get(const std::pair<Key, Value>& p) { return p.first; }
+};
+
+} // namespace flat_lru_cache_detail
+
+/*!
+ * This is an expected O(1) LRU cache of a fixed capacity, which contains a set
+ * of key-only elements. It has the same interface as LruCacheSet, except that
+ * put() automatically evicts the least recently used key when the cache is
+ * full. All memory is allocated at construction: one array of keys with 32-bit
+ * recency links and one open-addressing index.
+ */
+template <typename Key, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class FlatLruCacheSet
+    : public flat_lru_cache_detail::FlatLruCacheBase<
+          Key, Key, flat_lru_cache_detail::KeyOfKey<Key>, Hash, KeyEqual>
+{
+    using Super = flat_lru_cache_detail::FlatLruCacheBase<
+        Key, Key, flat_lru_cache_detail::KeyOfKey<Key>, Hash, KeyEqual>;
+
+public:
+    explicit FlatLruCacheSet(size_t capacity, const Hash& hash = Hash(),
+                             const KeyEqual& equal = KeyEqual())
+        : Super(capacity, hash, equal) { }
+
+    //! put or touch item in LRU cache
+    void put(const Key& key) {
+        Super::put_entry(key, key);
+    }
+
+    //! return the least recently used key
+    Key pop() {
+        return Super::pop_entry();
+    }
+};
+
+/*!
+ * This is an expected O(1) LRU cache of a fixed capacity, which contains a map
+ * of (key -> value) elements. It has the same interface as LruCacheMap, except
+ * that put() automatically evicts the least recently used pair when the cache
+ * is full. All memory is allocated at construction: one array of pairs with
+ * 32-bit recency links and one open-addressing index. Hence, hits and
+ * replacements do not allocate.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class FlatLruCacheMap
+    : public flat_lru_cache_detail::FlatLruCacheBase<
+          Key, std::pair<Key, Value>,
+          flat_lru_cache_detail::KeyOfPair<Key, Value>, Hash, KeyEqual>
+{
+public:
+    using KeyValuePair = typename std::pair<Key, Value>;
+
+private:
+    using Super = flat_lru_cache_detail::FlatLruCacheBase<
+        Key, KeyValuePair,
+        flat_lru_cache_detail::KeyOfPair<Key, Value>, Hash, KeyEqual>;
+
+public:
+    explicit FlatLruCacheMap(size_t capacity, const Hash& hash = Hash(),
+                             const KeyEqual& equal = KeyEqual())
+        : Super(capacity, hash, equal) { }
+
+    //! put or replace/touch item in LRU cache
+    void put(const Key& key, const Value& value) {
+        Super::put_entry(key, KeyValuePair(key, value));
+    }
+
+    //! get value from LRU cache for key. Throws if it is not in the cache.
+    const Value& get(const Key& key) const {
+        typename Super::index_type e = Super::find_entry(key);
+        if (e == Super::nil)
+            throw std::range_error("There is no such key in cache");
+        return Super::value(e).second;
+    }
+
+    //! get value from LRU cache for key without touching it. Returns nullptr
+    //! if it is not in the cache.
+    const Value* find(const Key& key) const noexcept {
+        typename Super::index_type e = Super::find_entry(key);
+        if (e == Super::nil) return nullptr;
+        return &Super::value(e).second;
+    }
+
+    //! position of an item in the cache, valid until the item is removed.
+    using entry_type = typename Super::index_type;
+
+    //! get value from LRU cache for key without touching it, and store its
+    //! entry for touch_entry(). Returns nullptr if it is not in the cache.
+    const Value* find(const Key& key, entry_type& entry) const noexcept {
+        entry = Super::find_entry(key);
+        if (entry == Super::nil) return nullptr;
+        return &Super::value(entry).second;
+    }
+
+    //! touch the item of an entry returned by find(), which must not have
+    //! been removed from the cache since.
+    void touch_entry(entry_type entry) noexcept {
+        Super::move_to_front(entry);
+    }
+
+    //! get and touch value from LRU cache for key. Throws if it is not in the
+    //! cache.
+    const Value& get_touch(const Key& key) {
+        typename Super::index_type e = Super::find_entry(key);
+        if (e == Super::nil)
+            throw std::range_error("There is no such key in cache");
+        Super::move_to_front(e);
+        return Super::value(e).second;
+    }
+
+    //! get and touch value from LRU cache for key. Returns nullptr if it is
+    //! not in the cache.
+    const Value* find_touch(const Key& key) noexcept {
+        typename Super::index_type e = Super::find_entry(key);
+        if (e == Super::nil) return nullptr;
+        Super::move_to_front(e);
+        return &Super::value(e).second;
+    }
+
+    //! return the least recently used key value pair
+    KeyValuePair pop() {
+        return Super::pop_entry();
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_FLAT_LRU_CACHE_HEADER
+
+/******************************************************************************/
@@ -21,7 +21,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <type_traits>
 #include <utility>
 
 #include <tlx/container/simple_vector.hpp>
@@ -864,7 +867,190 @@ public:
 };
 
 /******************************************************************************/
-// LoserTreeSwitch selects loser tree by size of value type
+// LoserTreeIntegral: branchless loser tree for integral keys
+
+/*!
+ * Traits of the comparators supported by LoserTreeIntegral: the key which
+ * compares greater or equal to all other keys is used as supremum sentinel.
+ */
+template <typename ValueType, typename Comparator>
+struct LoserTreeIntegralTraits {
+    static constexpr bool enabled = false;
+};
+
+template <typename ValueType>
+struct LoserTreeIntegralTraits<ValueType, std::less<ValueType> > {
+    static constexpr bool enabled = std::is_integral<ValueType>::value;
+    static ValueType sentinel() {
+        return std::numeric_limits<ValueType>::max();
+    }
+};
+
+template <typename ValueType>
+struct LoserTreeIntegralTraits<ValueType, std::greater<ValueType> > {
+    static constexpr bool enabled = std::is_integral<ValueType>::value;
+    static ValueType sentinel() {
+        return std::numeric_limits<ValueType>::lowest();
+    }
+};
+
+/*!
+ * Guarded loser tree for integral keys compared with std::less or
+ * std::greater, which replays the tournament without branches.
+ *
+ * Instead of a sup flag, finished players hold the extreme key as sentinel and
+ * the invalid source index. All games compare (key, source) pairs
+ * lexicographically, hence sentinels lose against real keys equal to the
+ * extreme, and equal keys are ordered by source. The tree is therefore always
+ * stable, and the Stable parameter only exists for interface compatibility.
+ *
+ * The keys and sources are kept in two separate arrays (struct-of-arrays),
+ * and each game of delete_min_insert() selects winner and loser with
+ * conditional moves, which avoids the branch mispredictions of the other
+ * variants on random inputs.
+ */
+template <bool Stable, typename ValueType,
+          typename Comparator = std::less<ValueType> >
+class LoserTreeIntegral
+{
+    using Traits = LoserTreeIntegralTraits<ValueType, Comparator>;
+
+    static_assert(Traits::enabled,
+                  "LoserTreeIntegral requires integral keys and std::less "
+                  "or std::greater");
+
+public:
+    //! size of counters and array indexes
+    using Source = uint32_t;
+
+    //! sentinel for invalid or finished Sources
+    static constexpr Source invalid_ = Source(-1);
+
+protected:
+    //! number of nodes
+    const Source ik_;
+    //! log_2(ik) next greater power of 2
+    const Source k_;
+    //! keys of the loser tree nodes
+    SimpleVector<ValueType> keys_;
+    //! sources of the loser tree nodes
+    SimpleVector<Source> sources_;
+    //! the comparator object
+    Comparator cmp_;
+    //! supremum sentinel key
+    const ValueType sentinel_;
+
+    //! true if (k1, s1) is less than (k2, s2)
+    bool less(const ValueType& k1, Source s1,
+              const ValueType& k2, Source s2) const {
+        // bitwise operators to avoid short-circuit branches
+        return cmp_(k1, k2) | (!cmp_(k2, k1) & (s1 < s2));
+    }
+
+public:
+    explicit LoserTreeIntegral(const Source& k,
+                               const Comparator& cmp = Comparator())
+        : ik_(k), k_(round_up_to_power_of_two(ik_)),
+          keys_(2 * k_), sources_(2 * k_), cmp_(cmp),
+          sentinel_(Traits::sentinel()) {
+        for (Source i = 0; i < 2 * k_; ++i) {
+            keys_[i] = sentinel_;
+            sources_[i] = invalid_;
+        }
+    }
+
+    //! return the index of the player with the smallest element.
+    Source min_source() { return sources_[0]; }
+
+    /*!
+     * Initializes the player source with the element key.
+     *
+     * \param keyp the element to insert
+     * \param source index of the player
+     * \param sup flag that determines whether the value to insert is an
+     *   explicit supremum sentinel.
+     */
+    void insert_start(const ValueType* keyp, const Source& source, bool sup) {
+        Source pos = k_ + source;
+
+        assert(pos < keys_.size());
+        assert(sup == (keyp == nullptr));
+
+        keys_[pos] = sup ? sentinel_ : *keyp;
+        sources_[pos] = sup ? invalid_ : source;
+    }
+
+    /*!
+     * Computes the winner of the competition at player root.  Called
+     * recursively (starting at 0) to build the initial tree.
+     *
+     * \param root index of the game to start.
+     */
+    Source init_winner(const Source& root) {
+        if (root >= k_)
+            return root;
+
+        Source left = init_winner(2 * root);
+        Source right = init_winner(2 * root + 1);
+        if (!less(keys_[right], sources_[right], keys_[left], sources_[left])) {
+            // left one is less or equal
+            keys_[root] = keys_[right];
+            sources_[root] = sources_[right];
+            return left;
+        }
+        else {
+            // right one is less
+            keys_[root] = keys_[left];
+            sources_[root] = sources_[left];
+            return right;
+        }
+    }
+
+    void init() {
+        if (TLX_UNLIKELY(k_ == 0))
+            return;
+        Source winner = init_winner(1);
+        keys_[0] = keys_[winner];
+        sources_[0] = sources_[winner];
+    }
+
+    void delete_min_insert(const ValueType* keyp, bool sup) {
+        assert(sup == (keyp == nullptr));
+
+        Source source = sources_[0];
+        Source pos = (k_ + source) / 2;
+
+        ValueType key = sup ? sentinel_ : *keyp;
+        source = sup ? invalid_ : source;
+
+        ValueType* keys = keys_.data();
+        Source* sources = sources_.data();
+
+        while (pos > 0) {
+            ValueType other_key = keys[pos];
+            Source other_source = sources[pos];
+            // the smaller one moves up, the larger one stays. Swap using
+            // all-ones or all-zeros masks, which the compiler cannot turn back
+            // into branches.
+            bool up = less(other_key, other_source, key, source);
+            ValueType key_diff = static_cast<ValueType>(
+                (key ^ other_key) & (ValueType(0) - ValueType(up)));
+            Source source_diff =
+                (source ^ other_source) & (Source(0) - Source(up));
+            keys[pos] = static_cast<ValueType>(other_key ^ key_diff);
+            sources[pos] = other_source ^ source_diff;
+            key = static_cast<ValueType>(key ^ key_diff);
+            source ^= source_diff;
+            pos /= 2;
+        }
+
+        keys_[0] = key;
+        sources_[0] = source;
+    }
+};
+
+/******************************************************************************/
+// LoserTreeSwitch selects loser tree by size of value type and comparator
 
 template <bool Stable, typename ValueType, typename Comparator,
           typename Enable = void>
@@ -877,12 +1063,24 @@ public:
 template <bool Stable, typename ValueType, typename Comparator>
 class LoserTreeSwitch<
         Stable, ValueType, Comparator,
-        typename std::enable_if<sizeof(ValueType) <= 2 * sizeof(size_t)>::type>
+        typename std::enable_if<
+            sizeof(ValueType) <= 2 * sizeof(size_t) &&
+            !LoserTreeIntegralTraits<ValueType, Comparator>::enabled>::type>
 {
 public:
     using Type = LoserTreeCopy<Stable, ValueType, Comparator>;
 };
 
+template <bool Stable, typename ValueType, typename Comparator>
+class LoserTreeSwitch<
+        Stable, ValueType, Comparator,
+        typename std::enable_if<
+            LoserTreeIntegralTraits<ValueType, Comparator>::enabled>::type>
+{
+public:
+    using Type = LoserTreeIntegral<Stable, ValueType, Comparator>;
+};
+
 template <bool Stable, typename ValueType, typename Comparator>
 using LoserTree = typename LoserTreeSwitch<Stable, ValueType, Comparator>::Type;
 
@@ -16,7 +16,9 @@
 #define TLX_CONTAINER_LRU_CACHE_HEADER
 
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <memory>
@@ -24,6 +26,9 @@
 #include <unordered_map>
 #include <utility>
 
+#include <tlx/container/timer_wheel.hpp>
+#include <tlx/delegate.hpp>
+
 namespace tlx {
 
 //! \addtogroup tlx_container
@@ -63,11 +68,11 @@ public:
 
     //! put or replace/touch item in LRU cache
     void put(const Key& key) {
-        // first try to find an existing key
+        // first try to find an existing key, move it to the front
         typename Map::iterator it = map_.find(key);
         if (it != map_.end()) {
-            list_.erase(it->second);
-            map_.erase(it);
+            list_.splice(list_.begin(), list_, it->second);
+            return;
         }
 
         // insert key into linked list at the front (most recently used)
@@ -154,9 +159,29 @@ private:
  * elements. Elements can be put() by key into LRU cache, and later retrieved
  * with get() using the same key. Insertion and retrieval will remark the
  * elements as most recently used, pushing all other back in priority. The LRU
- * cache itself does not limit the number of items, because it has no eviction
- * mechanism. Instead, the user program must check size() before or after an
- * insert and may extract the least recently used element.
+ * cache by default does not limit the number of items. Then the user program
+ * must check size() before or after an insert and may extract the least
+ * recently used element.
+ *
+ * Alternatively, the cache can be constructed with a capacity and a cost
+ * function, which assigns each (key, value) pair a cost, e.g. its size in
+ * bytes. The default cost of each pair is one. put() then automatically evicts
+ * least recently used pairs while the total cost exceeds the capacity, and
+ * calls the eviction callback for each one, e.g. to free resources or to write
+ * back dirty entries. A pair whose cost alone exceeds the capacity is evicted
+ * immediately. The cost function must return the same cost for the same pair,
+ * and the callback must not modify the cache.
+ *
+ * Pairs may also be given a time-to-live (TTL), either a default one with
+ * set_ttl() or per pair with put(key, value, ttl). Expired pairs are treated
+ * as missing by lookups, which erase them lazily. Each pair with a TTL has a
+ * timer in a TimerWheel, which is advanced by put() and expire() to reclaim
+ * all expired pairs in one batch, without scanning the cache and without
+ * allocating a timer per pair. Expired pairs are passed to the eviction
+ * callback. The time is measured by a time function in ticks, which are by
+ * default milliseconds of std::chrono::steady_clock. The timer wheel and the
+ * timer handles are kept apart from the map and allocated by the first put()
+ * with a TTL, hence caches without TTLs do not pay for them.
  */
 template <typename Key, typename Value,
           typename Alloc = std::allocator<std::pair<Key, Value> > >
@@ -165,6 +190,15 @@ class LruCacheMap
 public:
     using KeyValuePair = typename std::pair<Key, Value>;
 
+    //! returns the cost of a (key, value) pair in the cache
+    using CostFunction = Delegate<size_t(const Key&, const Value&)>;
+
+    //! called with each (key, value) pair evicted by put() or expired
+    using EvictionCallback = Delegate<void(const Key&, Value&)>;
+
+    //! returns the current time in ticks for TTL expiry
+    using TimeFunction = Delegate<uint64_t()>;
+
 protected:
     using List = typename std::list<KeyValuePair, Alloc>;
     using ListIterator = typename List::iterator;
@@ -174,35 +208,113 @@ protected:
         typename Alloc::template rebind<
             std::pair<const Key, ListIterator> >::other>;
 
+    using Wheel = TimerWheel<Key>;
+    using Timer = typename Wheel::handle;
+
+    using TimerMap = typename std::unordered_map<
+        Key, Timer, std::hash<Key>, std::equal_to<Key>,
+        typename Alloc::template rebind<
+            std::pair<const Key, Timer> >::other>;
+
+    //! expiry state, allocated by the first put() with a TTL
+    struct Expiry {
+        //! timers of pairs with a TTL, carrying their keys
+        Wheel wheel;
+        //! timer handles of pairs with a TTL
+        TimerMap timers;
+
+        explicit Expiry(const Alloc& alloc)
+            : timers(0, std::hash<Key>(), std::equal_to<Key>(), alloc) { }
+    };
+
 public:
     explicit LruCacheMap(const Alloc& alloc = Alloc())
         : list_(alloc),
           map_(0, std::hash<Key>(), std::equal_to<Key>(), alloc) { }
 
-    //! clear LRU
+    //! construct LRU cache which evicts pairs while their total cost exceeds
+    //! capacity. An empty cost function assigns each pair the cost one.
+    explicit LruCacheMap(
+        size_t capacity,
+        const CostFunction& cost = CostFunction(),
+        const EvictionCallback& on_evict = EvictionCallback(),
+        const Alloc& alloc = Alloc())
+        : list_(alloc),
+          map_(0, std::hash<Key>(), std::equal_to<Key>(), alloc),
+          capacity_(capacity), cost_(cost), on_evict_(on_evict) { }
+
+    //! clear LRU, does not call the eviction callback
     void clear() {
         list_.clear();
         map_.clear();
+        if (expiry_) {
+            expiry_->wheel.clear();
+            expiry_->timers.clear();
+        }
+        total_cost_ = 0;
     }
 
-    //! put or replace/touch item in LRU cache
+    //! return the capacity in cost units, zero if unlimited
+    size_t capacity() const noexcept { return capacity_; }
+
+    //! return the total cost of all pairs in the cache
+    size_t total_cost() const noexcept { return total_cost_; }
+
+    //! change the capacity, evicts pairs if the total cost exceeds it
+    void set_capacity(size_t capacity) {
+        capacity_ = capacity;
+        evict();
+    }
+
+    //! set the default TTL of pairs put() afterwards in ticks, zero disables
+    //! expiry. An empty time function counts milliseconds.
+    void set_ttl(uint64_t ttl, const TimeFunction& time = TimeFunction()) {
+        ttl_ = ttl;
+        time_ = time;
+    }
+
+    //! return the default TTL in ticks, zero if disabled
+    uint64_t ttl() const noexcept { return ttl_; }
+
+    //! put or replace/touch item in LRU cache with the default TTL
     void put(const Key& key, const Value& value) {
-        // first try to find an existing key
+        put(key, value, ttl_);
+    }
+
+    //! put or replace/touch item in LRU cache, which expires after ttl ticks.
+    //! A zero ttl never expires.
+    void put(const Key& key, const Value& value, uint64_t ttl) {
+        uint64_t now = 0;
+        if (ttl != 0 || (expiry_ && !expiry_->wheel.empty())) {
+            now = current_time();
+            expire(now);
+        }
+
+        // first try to find an existing key, replace value and move it to the
+        // front
         typename Map::iterator it = map_.find(key);
         if (it != map_.end()) {
-            list_.erase(it->second);
-            map_.erase(it);
+            total_cost_ -= cost(*it->second);
+            it->second->second = value;
+            total_cost_ += cost(*it->second);
+            list_.splice(list_.begin(), list_, it->second);
+            set_timer(key, now, ttl);
+            evict();
+            return;
         }
 
         // insert key into linked list at the front (most recently used)
         list_.push_front(KeyValuePair(key, value));
+        set_timer(key, now, ttl);
         // store iterator to linked list entry in map
         map_.insert(std::make_pair(key, list_.begin()));
+        total_cost_ += cost(list_.front());
+        evict();
     }
 
     //! touch pair in LRU cache for key. Throws if it is not in the map.
     void touch(const Key& key) {
-        typename Map::iterator it = map_.find(key);
+        typename Map::iterator it = find(key);
         if (it == map_.end()) {
             throw std::range_error("There is no such key in cache");
         }
@@ -211,9 +323,10 @@ public:
         }
     }
 
-    //! touch pair in LRU cache for key. Returns true if it exists.
-    bool touch_if_exists(const Key& key) noexcept {
-        typename Map::iterator it = map_.find(key);
+    //! touch pair in LRU cache for key. Returns true if it exists. Not
+    //! noexcept, since erasing an expired pair calls the delegates.
+    bool touch_if_exists(const Key& key) {
+        typename Map::iterator it = find(key);
         if (it != map_.end()) {
             list_.splice(list_.begin(), list_, it->second);
             return true;
@@ -228,17 +341,15 @@ public:
             throw std::range_error("There is no such key in cache");
         }
         else {
-            list_.erase(it->second);
-            map_.erase(it);
+            remove(it);
         }
     }
 
-    //! remove key from LRU cache
-    bool erase_if_exists(const Key& key) noexcept {
+    //! remove key from LRU cache. Returns true if it existed.
+    bool erase_if_exists(const Key& key) {
         typename Map::iterator it = map_.find(key);
         if (it != map_.end()) {
-            list_.erase(it->second);
-            map_.erase(it);
+            remove(it);
             return true;
         }
         return false;
@@ -246,7 +357,7 @@ public:
 
     //! get and touch value from LRU cache for key.
     const Value& get(const Key& key) {
-        typename Map::iterator it = map_.find(key);
+        typename Map::iterator it = find(key);
         if (it == map_.end()) {
             throw std::range_error("There is no such key in cache");
         }
@@ -257,7 +368,7 @@ public:
 
     //! get and touch value from LRU cache for key.
     const Value& get_touch(const Key& key) {
-        typename Map::iterator it = map_.find(key);
+        typename Map::iterator it = find(key);
         if (it == map_.end()) {
             throw std::range_error("There is no such key in cache");
         }
@@ -267,32 +378,162 @@ public:
         }
     }
 
-    //! test if key exists in LRU cache
+    //! get and touch value from LRU cache for key. Returns nullptr if it is
+    //! not in the cache.
+    const Value* find_touch(const Key& key) {
+        typename Map::iterator it = find(key);
+        if (it == map_.end()) return nullptr;
+        list_.splice(list_.begin(), list_, it->second);
+        return &it->second->second;
+    }
+
+    //! test if key exists in LRU cache and has not expired
     bool exists(const Key& key) const {
-        return map_.find(key) != map_.end();
+        typename Map::const_iterator it = map_.find(key);
+        return it != map_.end() && !expired(key);
     }
 
-    //! return number of items in LRU cache
+    //! return number of items in LRU cache, including expired ones which were
+    //! not reclaimed yet
     size_t size() const noexcept {
         return map_.size();
     }
 
-    //! return the least recently used key value pair
+    //! return the least recently used key value pair, does not call the
+    //! eviction callback
     KeyValuePair pop() {
         assert(size());
         typename List::iterator last = list_.end();
         --last;
         KeyValuePair out = *last;
-        map_.erase(last->first);
-        list_.pop_back();
+        remove(map_.find(last->first));
         return out;
     }
 
+    //! reclaim all expired pairs and pass them to the eviction callback.
+    //! Returns the number of reclaimed pairs.
+    size_t expire() {
+        if (!expiry_ || expiry_->wheel.empty()) return 0;
+        return expire(current_time());
+    }
+
 private:
     //! list of entries in least-recently used order.
     List list_;
     //! map for accelerated access to keys
     Map map_;
+
+    //! maximum total cost, zero if unlimited
+    size_t capacity_ = 0;
+    //! total cost of all pairs
+    size_t total_cost_ = 0;
+    //! cost function, empty for unit costs
+    CostFunction cost_;
+    //! eviction callback, may be empty
+    EvictionCallback on_evict_;
+
+    //! default TTL in ticks, zero if disabled
+    uint64_t ttl_ = 0;
+    //! time function, empty for milliseconds of steady_clock
+    TimeFunction time_;
+    //! timers of pairs with a TTL, nullptr until the first one is set
+    std::unique_ptr<Expiry> expiry_;
+
+    //! return cost of a pair
+    size_t cost(const KeyValuePair& p) {
+        return cost_ ? cost_(p.first, p.second) : 1;
+    }
+
+    //! return the current time in ticks
+    uint64_t current_time() const {
+        if (time_) return time_();
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    //! test if the pair of key has expired
+    bool expired(const Key& key) const {
+        if (!expiry_ || expiry_->timers.empty()) return false;
+        typename TimerMap::const_iterator t = expiry_->timers.find(key);
+        return t != expiry_->timers.end() &&
+               expiry_->wheel.expiry(t->second) <= current_time();
+    }
+
+    //! set, change, or cancel the timer of the pair of key
+    void set_timer(const Key& key, uint64_t now, uint64_t ttl) {
+        if (ttl == 0) {
+            cancel_timer(key);
+            return;
+        }
+        if (!expiry_)
+            expiry_.reset(new Expiry(list_.get_allocator()));
+        typename TimerMap::iterator t = expiry_->timers.find(key);
+        if (t != expiry_->timers.end()) {
+            expiry_->wheel.reschedule(t->second, now + ttl);
+        }
+        else {
+            Timer timer = expiry_->wheel.schedule(now + ttl, key);
+            expiry_->timers.insert(std::make_pair(key, timer));
+        }
+    }
+
+    //! cancel the timer of the pair of key, if it has one
+    void cancel_timer(const Key& key) {
+        if (!expiry_) return;
+        typename TimerMap::iterator t = expiry_->timers.find(key);
+        if (t == expiry_->timers.end()) return;
+        expiry_->wheel.cancel(t->second);
+        expiry_->timers.erase(t);
+    }
+
+    //! find key, erases and skips it if it has expired
+    typename Map::iterator find(const Key& key) {
+        typename Map::iterator it = map_.find(key);
+        if (it != map_.end() && expired(key)) {
+            Value& value = it->second->second;
+            if (on_evict_)
+                on_evict_(key, value);
+            remove(it);
+            return map_.end();
+        }
+        return it;
+    }
+
+    //! remove an entry
+    void remove(typename Map::iterator it) {
+        total_cost_ -= cost(*it->second);
+        cancel_timer(it->first);
+        list_.erase(it->second);
+        map_.erase(it);
+    }
+
+    //! advance the timer wheel and reclaim expired pairs
+    size_t expire(uint64_t now) {
+        if (!expiry_) return 0;
+        return expiry_->wheel.advance(
+            now, [this](Key&& key) {
+                // the timer has fired and is no longer valid
+                expiry_->timers.erase(key);
+                typename Map::iterator it = map_.find(key);
+                assert(it != map_.end());
+                if (on_evict_)
+                    on_evict_(it->first, it->second->second);
+                remove(it);
+            });
+    }
+
+    //! evict least recently used pairs while the total cost exceeds capacity
+    void evict() {
+        while (capacity_ != 0 && total_cost_ > capacity_) {
+            typename List::iterator last = list_.end();
+            --last;
+            typename Map::iterator it = map_.find(last->first);
+            if (on_evict_)
+                on_evict_(last->first, last->second);
+            remove(it);
+        }
+    }
 };
 
 //! \}
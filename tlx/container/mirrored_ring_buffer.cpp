@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * tlx/container/mirrored_ring_buffer.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/container/mirrored_ring_buffer.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <tlx/math/round_to_power_of_two.hpp>
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#define TLX_MIRRORED_RING_BUFFER_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace tlx {
+
+#if TLX_MIRRORED_RING_BUFFER_MMAP
+
+static void throw_errno(const char* what) {
+    throw std::runtime_error(
+              std::string("MirroredRingBuffer: ") + what + "() failed: " +
+              std::strerror(errno));
+}
+
+//! create an anonymous shared memory file of the given size
+static int create_memory_file(size_t size) {
+#if defined(__linux__)
+    int fd = ::memfd_create("tlx_mirrored_ring_buffer", MFD_CLOEXEC);
+    if (fd < 0) throw_errno("memfd_create");
+#else
+    // pick a unique name, open the object, and immediately unlink it again.
+    static std::atomic<unsigned> counter { 0 };
+    std::string name = "/tlx_mrb_" + std::to_string(::getpid()) + "_" +
+                       std::to_string(counter++);
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) throw_errno("shm_open");
+    ::shm_unlink(name.c_str());
+#endif
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        throw_errno("ftruncate");
+    }
+    return fd;
+}
+
+size_t MirroredRingBuffer::page_size() {
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+void MirroredRingBuffer::allocate(size_t min_capacity) {
+    size_t capacity = round_up_to_power_of_two(min_capacity);
+    if (capacity < page_size())
+        capacity = page_size();
+
+    int fd = create_memory_file(capacity);
+
+    // reserve address space for both mappings, then map the file twice into it
+    void* base = ::mmap(nullptr, 2 * capacity, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        throw_errno("mmap");
+    }
+
+    char* data = static_cast<char*>(base);
+    for (size_t i = 0; i < 2; ++i) {
+        void* p = ::mmap(data + i * capacity, capacity, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, fd, 0);
+        if (p == MAP_FAILED) {
+            int err = errno;
+            ::munmap(base, 2 * capacity);
+            ::close(fd);
+            errno = err;
+            throw_errno("mmap");
+        }
+    }
+
+    // the mappings keep the memory alive
+    ::close(fd);
+
+    // release a previous buffer only after the new one was mapped
+    deallocate();
+    data_ = data;
+    capacity_ = capacity;
+    head_ = tail_ = 0;
+}
+
+void MirroredRingBuffer::deallocate() noexcept {
+    if (data_) {
+        ::munmap(data_, 2 * capacity_);
+        data_ = nullptr;
+    }
+    capacity_ = head_ = tail_ = 0;
+}
+
+#else
+
+size_t MirroredRingBuffer::page_size() {
+    return 4096;
+}
+
+void MirroredRingBuffer::allocate(size_t /* min_capacity */) {
+    throw std::runtime_error(
+              "MirroredRingBuffer: not supported on this platform");
+}
+
+void MirroredRingBuffer::deallocate() noexcept {
+    data_ = nullptr;
+    capacity_ = head_ = tail_ = 0;
+}
+
+#endif
+
+MirroredRingBuffer::MirroredRingBuffer(size_t min_capacity) {
+    allocate(min_capacity);
+}
+
+} // namespace tlx
+
+/******************************************************************************/
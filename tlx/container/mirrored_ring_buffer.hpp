@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * tlx/container/mirrored_ring_buffer.hpp
+ *
+ * Byte ring buffer whose memory is mapped twice back to back, such that every
+ * readable and writable region is contiguous.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_MIRRORED_RING_BUFFER_HEADER
+#define TLX_CONTAINER_MIRRORED_RING_BUFFER_HEADER
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * A ring buffer of bytes of static (non-growing) size, which maps the same
+ * physical memory twice, back to back, into the address space. Reading or
+ * writing past the end of the first mapping transparently continues at the
+ * beginning of the buffer, hence every readable or writable region is a
+ * single contiguous span and records crossing the wrap-around point need not
+ * be copied out.
+ *
+ * Producers fill the span returned by write_span() and publish the bytes with
+ * commit(); consumers inspect the span returned by read_span() and release the
+ * bytes with consume(). The buffer itself is not thread-safe.
+ *
+ * The capacity is rounded up to a power of two which is at least the page
+ * size. On Linux the memory is created with memfd_create(), on other POSIX
+ * systems with shm_open(). On other platforms the constructor throws
+ * std::runtime_error.
+ */
+class MirroredRingBuffer
+{
+public:
+    //! contiguous region of the buffer
+    struct Span {
+        char* data;
+        size_t size;
+
+        char * begin() const { return data; }
+        char * end() const { return data + size; }
+    };
+
+    //! default constructor: no buffer allocated
+    MirroredRingBuffer() = default;
+
+    //! allocate a buffer holding at least min_capacity bytes
+    explicit MirroredRingBuffer(size_t min_capacity);
+
+    //! non-copyable: delete copy-constructor
+    MirroredRingBuffer(const MirroredRingBuffer&) = delete;
+    //! non-copyable: delete assignment operator
+    MirroredRingBuffer& operator = (const MirroredRingBuffer&) = delete;
+
+    //! move-constructor: move buffer
+    MirroredRingBuffer(MirroredRingBuffer&& rb) noexcept
+        : data_(rb.data_), capacity_(rb.capacity_),
+          head_(rb.head_), tail_(rb.tail_) {
+        rb.data_ = nullptr;
+        rb.capacity_ = rb.head_ = rb.tail_ = 0;
+    }
+
+    //! move-assignment operator: move buffer
+    MirroredRingBuffer& operator = (MirroredRingBuffer&& rb) noexcept {
+        if (this == &rb) return *this;
+        deallocate();
+        data_ = rb.data_, capacity_ = rb.capacity_;
+        head_ = rb.head_, tail_ = rb.tail_;
+        rb.data_ = nullptr;
+        rb.capacity_ = rb.head_ = rb.tail_ = 0;
+        return *this;
+    }
+
+    //! unmap the buffer
+    ~MirroredRingBuffer() {
+        deallocate();
+    }
+
+    //! allocate buffer holding at least min_capacity bytes, replaces and
+    //! unmaps a previously allocated buffer and discards its contents.
+    void allocate(size_t min_capacity);
+
+    //! deallocate buffer
+    void deallocate() noexcept;
+
+    //! return the system's page size
+    static size_t page_size();
+
+    //! \name Producer and Consumer
+    //! \{
+
+    //! return the contiguous free region after the last byte
+    Span write_span() noexcept {
+        return Span { data_ + (tail_ & (capacity_ - 1)), space() };
+    }
+
+    //! append n bytes previously written into write_span()
+    void commit(size_t n) noexcept {
+        assert(n <= space());
+        tail_ += n;
+    }
+
+    //! return the contiguous region of all bytes in the buffer
+    Span read_span() noexcept {
+        return Span { data_ + (head_ & (capacity_ - 1)), size() };
+    }
+
+    //! remove n bytes from the beginning of the buffer
+    void consume(size_t n) noexcept {
+        assert(n <= size());
+        head_ += n;
+    }
+
+    //! copy up to n bytes into the buffer, as many as fit. Returns the number
+    //! of bytes written.
+    size_t write(const void* src, size_t n) noexcept {
+        Span s = write_span();
+        if (n > s.size) n = s.size;
+        std::memcpy(s.data, src, n);
+        commit(n);
+        return n;
+    }
+
+    //! copy up to n bytes out of the buffer, as many as are available. Returns
+    //! the number of bytes read.
+    size_t read(void* dst, size_t n) noexcept {
+        Span s = read_span();
+        if (n > s.size) n = s.size;
+        std::memcpy(dst, s.data, n);
+        consume(n);
+        return n;
+    }
+
+    //! remove all bytes
+    void clear() noexcept {
+        head_ = tail_ = 0;
+    }
+
+    //! \}
+
+    //! \name Element access
+    //! \{
+
+    //! Returns a reference to the i-th byte.
+    char& operator [] (size_t i) noexcept {
+        assert(i < size());
+        return data_[((head_ & (capacity_ - 1)) + i)];
+    }
+    //! Returns a reference to the i-th byte.
+    const char& operator [] (size_t i) const noexcept {
+        assert(i < size());
+        return data_[((head_ & (capacity_ - 1)) + i)];
+    }
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    //! return the number of bytes in the buffer
+    size_t size() const noexcept { return tail_ - head_; }
+
+    //! return the number of bytes which can be appended
+    size_t space() const noexcept { return capacity_ - size(); }
+
+    //! return the capacity of the buffer, a power of two
+    size_t capacity() const noexcept { return capacity_; }
+
+    //! returns true if no bytes are in the buffer
+    bool empty() const noexcept { return head_ == tail_; }
+
+    //! returns true if no more bytes can be appended
+    bool full() const noexcept { return size() == capacity_; }
+
+    //! \}
+
+private:
+    //! start of the double mapping of 2 * capacity_ bytes
+    char* data_ = nullptr;
+
+    //! capacity of the buffer, a power of two multiple of the page size
+    size_t capacity_ = 0;
+
+    //! free-running counters of consumed and committed bytes
+    size_t head_ = 0, tail_ = 0;
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_MIRRORED_RING_BUFFER_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,437 @@
+/*******************************************************************************
+ * tlx/container/mpmc_queue.hpp
+ *
+ * Bounded lock-free multi-producer/multi-consumer array queue, and a blocking
+ * wrapper.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_MPMC_QUEUE_HEADER
+#define TLX_CONTAINER_MPMC_QUEUE_HEADER
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <tlx/math/round_to_power_of_two.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * A bounded lock-free queue for any number of producer and consumer threads,
+ * following Dmitry Vyukov's bounded MPMC queue. The items are stored in an
+ * array of cells with a power of two capacity. Each cell has a sequence
+ * number, which tells whether the cell is free for the producer, or full for
+ * the consumer, of a given position. Producers and consumers claim positions
+ * by compare-and-swap on separate enqueue and dequeue counters, which are
+ * placed on separate cache lines, and then publish the cell by storing the
+ * next sequence number. Hence there is no shared lock and no ABA problem.
+ *
+ * push_n() and pop_n() claim a run of consecutive cells with a single
+ * compare-and-swap, which reduces contention on the counters.
+ *
+ * The array of cells is allocated with the Allocator rebound to the cell type,
+ * and items are constructed in the cells with the Allocator.
+ */
+template <typename Type, class Allocator = std::allocator<Type> >
+class MpmcQueue
+{
+public:
+    using value_type = Type;
+    using allocator_type = Allocator;
+
+    using alloc_traits = std::allocator_traits<allocator_type>;
+
+    //! size of a cache line, by which the counters are separated
+    static constexpr size_t cache_line_size = 64;
+
+protected:
+    //! A cell holding an item and its sequence number.
+    struct Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<
+            sizeof(Type), alignof(Type)>::type storage;
+
+        Type * item() { return reinterpret_cast<Type*>(&storage); }
+    };
+
+    using cell_alloc_type =
+        typename alloc_traits::template rebind_alloc<Cell>;
+    using cell_alloc_traits = std::allocator_traits<cell_alloc_type>;
+
+public:
+    //! create a queue holding at least max_size items, rounded up to the next
+    //! power of two.
+    explicit MpmcQueue(size_t max_size,
+                       const Allocator& alloc = allocator_type())
+        : alloc_(alloc), cell_alloc_(alloc),
+          capacity_(round_up_to_power_of_two(max_size)),
+          mask_(capacity_ - 1),
+          cells_(cell_alloc_traits::allocate(cell_alloc_, capacity_)) {
+        assert(max_size > 0);
+        for (size_t i = 0; i < capacity_; ++i) {
+            cell_alloc_traits::construct(cell_alloc_, &cells_[i]);
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    //! non-copyable: delete copy-constructor
+    MpmcQueue(const MpmcQueue&) = delete;
+    //! non-copyable: delete assignment operator
+    MpmcQueue& operator = (const MpmcQueue&) = delete;
+
+    //! destroy remaining items and free the cells
+    ~MpmcQueue() {
+        size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+        for (size_t i = dequeue_pos_.load(std::memory_order_relaxed);
+             i != end; ++i)
+            alloc_traits::destroy(alloc_, cells_[i & mask_].item());
+        for (size_t i = 0; i < capacity_; ++i)
+            cell_alloc_traits::destroy(cell_alloc_, &cells_[i]);
+        cell_alloc_traits::deallocate(cell_alloc_, cells_, capacity_);
+    }
+
+    //! return the maximum number of items in the queue
+    size_t capacity() const noexcept { return capacity_; }
+
+    //! return the approximate number of items in the queue
+    size_t size() const noexcept {
+        size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    //! return true if the queue appears empty
+    bool empty() const noexcept { return size() == 0; }
+
+    //! construct an item in place. Returns false if the queue is full.
+    template <typename... Args>
+    bool try_emplace(Args&& ... args) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for ( ; ; ) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq - pos);
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0) {
+                // the cell still holds the item of the previous round
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        alloc_traits::construct(alloc_, cell->item(),
+                                std::forward<Args>(args) ...);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! copy an item to the queue. Returns false if the queue is full.
+    bool try_push(const Type& item) { return try_emplace(item); }
+
+    //! move an item to the queue. Returns false if the queue is full.
+    bool try_push(Type&& item) { return try_emplace(std::move(item)); }
+
+    //! move an item out of the queue. Returns false if the queue is empty.
+    bool try_pop(Type& out) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for ( ; ; ) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0) {
+                // the cell was not yet written in this round
+                return false;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(*cell->item());
+        alloc_traits::destroy(alloc_, cell->item());
+        cell->sequence.store(pos + capacity_, std::memory_order_release);
+        return true;
+    }
+
+    //! push up to n items from a forward iterator, as many as there are
+    //! consecutive free cells. Returns the number of items pushed.
+    template <typename ForwardIterator>
+    size_t push_n(ForwardIterator first, size_t n) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        size_t k;
+        for ( ; ; ) {
+            // count free cells, which stay free until their position is
+            // claimed, hence the claim below is safe if the CAS succeeds.
+            k = 0;
+            while (k < n && cells_[(pos + k) & mask_].sequence.load(
+                       std::memory_order_acquire) == pos + k)
+                ++k;
+            if (k == 0) {
+                size_t seq = cells_[pos & mask_].sequence.load(
+                    std::memory_order_acquire);
+                if (static_cast<std::ptrdiff_t>(seq - pos) < 0 || n == 0)
+                    return 0;
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (enqueue_pos_.compare_exchange_weak(
+                    pos, pos + k, std::memory_order_relaxed))
+                break;
+        }
+        for (size_t i = 0; i < k; ++i, ++first) {
+            Cell& cell = cells_[(pos + i) & mask_];
+            alloc_traits::construct(alloc_, cell.item(), *first);
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return k;
+    }
+
+    //! move up to n items to an output iterator, as many as there are
+    //! consecutive full cells. Returns the number of items popped.
+    template <typename OutputIterator>
+    size_t pop_n(OutputIterator out, size_t n) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t k;
+        for ( ; ; ) {
+            k = 0;
+            while (k < n && cells_[(pos + k) & mask_].sequence.load(
+                       std::memory_order_acquire) == pos + k + 1)
+                ++k;
+            if (k == 0) {
+                size_t seq = cells_[pos & mask_].sequence.load(
+                    std::memory_order_acquire);
+                if (static_cast<std::ptrdiff_t>(seq - (pos + 1)) < 0 || n == 0)
+                    return 0;
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (dequeue_pos_.compare_exchange_weak(
+                    pos, pos + k, std::memory_order_relaxed))
+                break;
+        }
+        for (size_t i = 0; i < k; ++i, ++out) {
+            Cell& cell = cells_[(pos + i) & mask_];
+            *out = std::move(*cell.item());
+            alloc_traits::destroy(alloc_, cell.item());
+            cell.sequence.store(pos + i + capacity_, std::memory_order_release);
+        }
+        return k;
+    }
+
+private:
+    //! used allocator for constructing and destroying items
+    allocator_type alloc_;
+    //! allocator of the array of cells
+    cell_alloc_type cell_alloc_;
+    //! capacity of the array, a power of two
+    const size_t capacity_;
+    //! mask for indexing the array
+    const size_t mask_;
+    //! the array of cells
+    Cell* cells_;
+
+    //! padding to separate the read-only fields from the enqueue counter
+    char pad0_[cache_line_size];
+    //! next position to push
+    std::atomic<size_t> enqueue_pos_ { 0 };
+    //! padding to separate the counters
+    char pad1_[cache_line_size];
+    //! next position to pop
+    std::atomic<size_t> dequeue_pos_ { 0 };
+    //! padding to separate the dequeue counter from following objects
+    char pad2_[cache_line_size];
+};
+
+/*!
+ * A blocking multi-producer/multi-consumer queue on top of MpmcQueue. push()
+ * waits while the queue is full, and pop() waits while it is empty. Waiting
+ * threads first spin on the lock-free queue for a while, and then sleep on a
+ * condition variable. The other side only takes the mutex to wake them if
+ * threads are actually sleeping, hence the uncontended path is lock-free.
+ *
+ * After close(), push() fails, and pop() returns the remaining items and then
+ * fails, which signals the end of the stream to the consumers.
+ */
+template <typename Type, class Allocator = std::allocator<Type> >
+class BlockingMpmcQueue
+{
+public:
+    using value_type = Type;
+    using allocator_type = Allocator;
+
+    //! number of attempts on the lock-free queue before sleeping
+    static constexpr size_t spin_count = 256;
+
+    //! create a queue holding at least max_size items
+    explicit BlockingMpmcQueue(size_t max_size,
+                               const Allocator& alloc = allocator_type())
+        : queue_(max_size, alloc) { }
+
+    //! return the maximum number of items in the queue
+    size_t capacity() const noexcept { return queue_.capacity(); }
+
+    //! return the approximate number of items in the queue
+    size_t size() const noexcept { return queue_.size(); }
+
+    //! close the queue and wake all waiting threads
+    void close() {
+        closed_.store(true);
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    //! test if the queue was closed
+    bool closed() const noexcept { return closed_.load(); }
+
+    //! copy an item to the queue, waits while it is full. Returns false if
+    //! the queue is closed.
+    bool push(const Type& item) { return emplace(item); }
+
+    //! move an item to the queue, waits while it is full. Returns false if
+    //! the queue is closed.
+    bool push(Type&& item) { return emplace(std::move(item)); }
+
+    //! construct an item in the queue, waits while it is full. Returns false
+    //! if the queue is closed.
+    template <typename... Args>
+    bool emplace(Args&& ... args) {
+        if (closed_.load(std::memory_order_relaxed) ||
+            !wait(push_waiters_, not_full_, [&]() {
+                      return queue_.try_emplace(std::forward<Args>(args) ...);
+                  }))
+            return false;
+        wake(pop_waiters_, not_empty_, false);
+        return true;
+    }
+
+    //! push n items from a forward iterator, waits while the queue is full.
+    //! Returns the number of items pushed, which is less than n only if the
+    //! queue was closed.
+    template <typename ForwardIterator>
+    size_t push_n(ForwardIterator first, size_t n) {
+        size_t done = 0;
+        while (done < n && !closed_.load(std::memory_order_relaxed)) {
+            size_t k = 0;
+            if (!wait(push_waiters_, not_full_, [&]() {
+                          k = queue_.push_n(first, n - done);
+                          return k != 0;
+                      }))
+                break;
+            std::advance(first, k);
+            done += k;
+            wake(pop_waiters_, not_empty_, k > 1);
+        }
+        return done;
+    }
+
+    //! move an item out of the queue, waits while it is empty. Returns false
+    //! if the queue is empty and closed.
+    bool pop(Type& out) {
+        if (!wait(pop_waiters_, not_empty_,
+                  [&]() { return queue_.try_pop(out); }))
+            return false;
+        wake(push_waiters_, not_full_, false);
+        return true;
+    }
+
+    //! move up to n items to an output iterator, waits until at least one is
+    //! available. Returns the number of items popped, which is zero only if
+    //! the queue is empty and closed.
+    template <typename OutputIterator>
+    size_t pop_n(OutputIterator out, size_t n) {
+        size_t k = 0;
+        if (!wait(pop_waiters_, not_empty_, [&]() {
+                      k = queue_.pop_n(out, n);
+                      return k != 0;
+                  }))
+            return 0;
+        wake(push_waiters_, not_full_, k > 1);
+        return k;
+    }
+
+private:
+    //! lock-free core
+    MpmcQueue<Type, Allocator> queue_;
+    //! whether the queue was closed
+    std::atomic<bool> closed_ { false };
+    //! number of sleeping producers
+    std::atomic<size_t> push_waiters_ { 0 };
+    //! number of sleeping consumers
+    std::atomic<size_t> pop_waiters_ { 0 };
+    //! mutex for sleeping
+    std::mutex mutex_;
+    //! condition variables for sleeping
+    std::condition_variable not_empty_, not_full_;
+
+    //! retry op() until it succeeds or the queue is closed. Returns whether
+    //! op() succeeded.
+    template <typename Op>
+    bool wait(std::atomic<size_t>& waiters, std::condition_variable& cv,
+              Op op) {
+        for (size_t i = 0; i < spin_count; ++i) {
+            if (op()) return true;
+            if (closed_.load(std::memory_order_relaxed)) return op();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters.fetch_add(1);
+        // pairs with the fence in wake(): either the other side sees the
+        // counter, or this side sees its update.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool success;
+        while (!(success = op())) {
+            if (closed_.load()) break;
+            cv.wait(lock);
+        }
+        waiters.fetch_sub(1);
+        return success;
+    }
+
+    //! wake one or all sleeping threads of the other side
+    void wake(std::atomic<size_t>& waiters, std::condition_variable& cv,
+              bool all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) != 0) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (all)
+                cv.notify_all();
+            else
+                cv.notify_one();
+        }
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_MPMC_QUEUE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,536 @@
+/*******************************************************************************
+ * tlx/container/pairing_heap.hpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_PAIRING_HEAP_HEADER
+#define TLX_CONTAINER_PAIRING_HEAP_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * This class implements a meldable, addressable priority queue, precisely a
+ * pairing heap by Fredman, Sedgewick, Sleator, and Tarjan.
+ *
+ * push(), meld(), and top() run in O(1), pop(), erase(), and decrease_key()
+ * in amortized O(log n) time. push() returns a handle to the item, which stays
+ * valid until the item is removed, also across meld().
+ *
+ * The tree nodes are allocated from a slab pool owned by the heap: slabs grow
+ * geometrically and removed nodes are put on a free list, hence there is no
+ * malloc() per item. meld() splices the other heap's slabs and free list into
+ * this one in constant time. Slabs in which all nodes are free are released by
+ * shrink(), which meld() also calls whenever the pool has doubled since the
+ * last shrink. Hence, a heap into which other heaps are melded repeatedly does
+ * not retain the nodes of all items it has ever contained.
+ *
+ * \tparam KeyType    Key type.
+ * \tparam Compare    Function object to order keys.
+ */
+template <typename KeyType, typename Compare = std::less<KeyType> >
+class PairingHeap
+{
+public:
+    using key_type = KeyType;
+    using compare_type = Compare;
+
+    //! A node of the pairing heap.
+    class Node
+    {
+    public:
+        //! the key of the item
+        const key_type& key() const {
+            return *reinterpret_cast<const key_type*>(&storage_);
+        }
+
+    private:
+        friend class PairingHeap;
+
+        key_type& key_ref() {
+            return *reinterpret_cast<key_type*>(&storage_);
+        }
+
+        //! uninitialized space for the key, constructed while in the heap
+        typename std::aligned_storage<
+            sizeof(key_type), alignof(key_type)>::type storage_;
+        //! leftmost child
+        Node* child_;
+        //! next sibling, or next node in the free list
+        Node* next_;
+        //! previous sibling, or parent if this is the leftmost child
+        Node* prev_;
+    };
+
+    //! Handle of an item, which can be used for decrease_key() and erase().
+    using handle = Node *;
+
+protected:
+    //! A slab of nodes, slabs form a singly linked list.
+    struct Slab {
+        Node* nodes;
+        size_t capacity;
+        Slab* next;
+    };
+
+    //! root of the heap
+    Node* root_ = nullptr;
+
+    //! number of items
+    size_t size_ = 0;
+
+    //! list of slabs, the first one is used for bump allocation
+    Slab* slabs_ = nullptr;
+    //! last slab in the list, for O(1) splicing in meld()
+    Slab* slabs_tail_ = nullptr;
+    //! number of nodes used in the first slab
+    size_t slab_used_ = 0;
+    //! total number of nodes in all slabs
+    size_t capacity_ = 0;
+    //! meld() calls shrink() if the capacity exceeds this limit
+    size_t shrink_limit_ = 0;
+
+    //! list of free nodes, linked by next_
+    Node* free_ = nullptr;
+    //! last node in the free list, for O(1) splicing in meld()
+    Node* free_tail_ = nullptr;
+
+    //! Compare function.
+    compare_type cmp_;
+
+    //! initial number of nodes in the first slab
+    static constexpr size_t min_slab_size = 64;
+    //! maximum number of nodes of slabs added by growth
+    static constexpr size_t max_slab_size = 65536;
+
+public:
+    //! Allocates an empty heap.
+    explicit PairingHeap(compare_type cmp = compare_type())
+        : cmp_(cmp) { }
+
+    //! non-copyable: delete copy-constructor
+    PairingHeap(const PairingHeap&) = delete;
+    //! non-copyable: delete assignment operator
+    PairingHeap& operator = (const PairingHeap&) = delete;
+
+    //! move-constructor: take over nodes and pool
+    PairingHeap(PairingHeap&& other) noexcept
+        : cmp_(std::move(other.cmp_)) {
+        take(other);
+    }
+
+    //! move-assignment operator: take over nodes and pool
+    PairingHeap& operator = (PairingHeap&& other) noexcept {
+        if (this == &other) return *this;
+        release();
+        cmp_ = std::move(other.cmp_);
+        take(other);
+        return *this;
+    }
+
+    //! free all nodes and slabs
+    ~PairingHeap() {
+        release();
+    }
+
+    //! Allocates space for \c new_size items.
+    void reserve(size_t new_size) {
+        size_t avail = slabs_ ? slabs_->capacity - slab_used_ : 0;
+        if (new_size > size_ + avail)
+            add_slab(new_size - size_);
+    }
+
+    //! Empties the heap, keeps the node pool for reuse.
+    void clear() {
+        destroy_tree(root_);
+        root_ = nullptr;
+        size_ = 0;
+    }
+
+    //! Returns the number of items in the heap.
+    size_t size() const noexcept { return size_; }
+
+    //! Returns true if the heap has no items, false otherwise.
+    bool empty() const noexcept { return size_ == 0; }
+
+    //! Returns the number of nodes in the pool, used or free.
+    size_t capacity() const noexcept { return capacity_; }
+
+    //! Inserts a new item and returns its handle.
+    handle push(const key_type& new_key) {
+        Node* n = allocate_node();
+        new (&n->storage_)key_type(new_key);
+        return push_node(n);
+    }
+
+    //! Inserts a new item and returns its handle.
+    handle push(key_type&& new_key) {
+        Node* n = allocate_node();
+        new (&n->storage_)key_type(std::move(new_key));
+        return push_node(n);
+    }
+
+    //! Returns the top item.
+    const key_type& top() const noexcept {
+        assert(!empty());
+        return root_->key();
+    }
+
+    //! Returns the handle of the top item.
+    handle top_handle() const noexcept {
+        assert(!empty());
+        return root_;
+    }
+
+    //! Removes the top item.
+    void pop() {
+        assert(!empty());
+        Node* r = root_;
+        root_ = r->child_ ? combine_siblings(r->child_) : nullptr;
+        free_node(r);
+        --size_;
+    }
+
+    //! Removes and returns the top item.
+    key_type extract_top() {
+        key_type top_item = std::move(root_->key_ref());
+        pop();
+        return top_item;
+    }
+
+    //! Replaces the key of item \c h with \c new_key, which must not be ordered
+    //! after the current key.
+    void decrease_key(handle h, const key_type& new_key) {
+        assert(!cmp_(h->key(), new_key));
+        h->key_ref() = new_key;
+        if (h == root_) return;
+        cut(h);
+        root_ = link(root_, h);
+    }
+
+    //! Removes the item \c h from the heap.
+    void erase(handle h) {
+        if (h == root_) {
+            pop();
+            return;
+        }
+        cut(h);
+        if (h->child_)
+            root_ = link(root_, combine_siblings(h->child_));
+        free_node(h);
+        --size_;
+    }
+
+    //! Moves all items of \c other into this heap in O(1) time, plus a
+    //! shrink() if the pool has doubled. Handles of \c other stay valid and
+    //! now refer to this heap. Both heaps must use equivalent compare
+    //! functions.
+    void meld(PairingHeap& other) {
+        if (this == &other || other.slabs_ == nullptr) return;
+
+        if (other.root_)
+            root_ = root_ ? link(root_, other.root_) : other.root_;
+        size_ += other.size_;
+
+        // append other's slabs, keep our first slab for bump allocation. The
+        // unused tail of other's first slab goes to its free list.
+        if (slabs_ != nullptr)
+            other.retire_slab_tail();
+        if (slabs_ == nullptr) {
+            slabs_ = other.slabs_;
+            slab_used_ = other.slab_used_;
+        }
+        else {
+            slabs_tail_->next = other.slabs_;
+        }
+        slabs_tail_ = other.slabs_tail_;
+
+        // append other's free list
+        if (free_ == nullptr)
+            free_ = other.free_;
+        else
+            free_tail_->next_ = other.free_;
+        if (other.free_tail_)
+            free_tail_ = other.free_tail_;
+
+        capacity_ += other.capacity_;
+        other.reset();
+
+        if (capacity_ > shrink_limit_) {
+            shrink();
+            shrink_limit_ = 2 * capacity_;
+        }
+    }
+
+    //! Releases all slabs in which no node is used. Handles stay valid. Runs
+    //! in O(f log s + s) time for f free nodes and s slabs.
+    void shrink() {
+        if (!slabs_) return;
+        retire_slab_tail();
+
+        // sort slabs by address to map free nodes to their slabs
+        std::vector<Slab*> slabs;
+        for (Slab* s = slabs_; s; s = s->next)
+            slabs.push_back(s);
+        std::less<const Node*> less;
+        std::sort(slabs.begin(), slabs.end(),
+                  [&](const Slab* a, const Slab* b) {
+                      return less(a->nodes, b->nodes);
+                  });
+        auto slab_of = [&](const Node* n) {
+            return std::upper_bound(
+                slabs.begin(), slabs.end(), n,
+                [&](const Node* x, const Slab* s) {
+                    return less(x, s->nodes);
+                }) - slabs.begin() - 1;
+        };
+
+        std::vector<size_t> num_free(slabs.size());
+        for (Node* n = free_; n; n = n->next_)
+            ++num_free[slab_of(n)];
+
+        // rebuild the free list without the nodes of empty slabs
+        Node* n = free_;
+        free_ = free_tail_ = nullptr;
+        while (n) {
+            Node* next = n->next_;
+            size_t i = slab_of(n);
+            if (num_free[i] != slabs[i]->capacity) {
+                n->next_ = free_;
+                free_ = n;
+                if (!free_tail_) free_tail_ = n;
+            }
+            n = next;
+        }
+
+        // free the empty slabs and relink the others
+        slabs_ = slabs_tail_ = nullptr;
+        for (size_t i = slabs.size(); i-- > 0; ) {
+            Slab* s = slabs[i];
+            if (num_free[i] == s->capacity) {
+                capacity_ -= s->capacity;
+                delete[] s->nodes;
+                delete s;
+                continue;
+            }
+            s->next = slabs_;
+            if (!slabs_) slabs_tail_ = s;
+            slabs_ = s;
+        }
+        slab_used_ = slabs_ ? slabs_->capacity : 0;
+    }
+
+    //! For debugging: runs a heap sanity check on the tree structure.
+    bool sanity_check() const {
+        if (root_ == nullptr)
+            return size_ == 0;
+        if (root_->prev_ != nullptr || root_->next_ != nullptr)
+            return false;
+
+        size_t count = 0;
+        std::vector<const Node*> stack(1, root_);
+        while (!stack.empty()) {
+            const Node* n = stack.back();
+            stack.pop_back();
+            ++count;
+            const Node* prev = n;
+            for (const Node* c = n->child_; c; prev = c, c = c->next_) {
+                if (c->prev_ != prev)
+                    return false;
+                if (cmp_(c->key(), n->key()))
+                    return false;
+                stack.push_back(c);
+            }
+        }
+        return count == size_;
+    }
+
+private:
+    //! Links root \c n into the heap.
+    handle push_node(Node* n) {
+        n->child_ = n->next_ = n->prev_ = nullptr;
+        root_ = root_ ? link(root_, n) : n;
+        ++size_;
+        return n;
+    }
+
+    //! Links two roots, makes the larger one the leftmost child of the smaller
+    //! one and returns the smaller one. Sibling links of the returned root are
+    //! cleared.
+    Node * link(Node* a, Node* b) {
+        if (cmp_(b->key(), a->key()))
+            std::swap(a, b);
+        b->prev_ = a;
+        b->next_ = a->child_;
+        if (a->child_)
+            a->child_->prev_ = b;
+        a->child_ = b;
+        a->next_ = a->prev_ = nullptr;
+        return a;
+    }
+
+    //! Detaches the subtree rooted at non-root \c n from its parent.
+    void cut(Node* n) {
+        if (n->prev_->child_ == n)
+            n->prev_->child_ = n->next_;
+        else
+            n->prev_->next_ = n->next_;
+        if (n->next_)
+            n->next_->prev_ = n->prev_;
+        n->next_ = n->prev_ = nullptr;
+    }
+
+    //! Two-pass pairing: links pairs of siblings left to right, then links the
+    //! pairs right to left. Returns the new root.
+    Node * combine_siblings(Node* first) {
+        // first pass, collect the pairs in reverse order
+        Node* pairs = nullptr;
+        while (first) {
+            Node* a = first;
+            Node* b = a->next_;
+            if (!b) {
+                a->next_ = pairs;
+                pairs = a;
+                break;
+            }
+            first = b->next_;
+            Node* w = link(a, b);
+            w->next_ = pairs;
+            pairs = w;
+        }
+
+        // second pass, accumulate from the right
+        Node* root = pairs;
+        pairs = pairs->next_;
+        while (pairs) {
+            Node* next = pairs->next_;
+            root = link(pairs, root);
+            pairs = next;
+        }
+        root->next_ = root->prev_ = nullptr;
+        return root;
+    }
+
+    //! Returns a node from the free list or the current slab.
+    Node * allocate_node() {
+        if (free_) {
+            Node* n = free_;
+            free_ = n->next_;
+            if (!free_) free_tail_ = nullptr;
+            return n;
+        }
+        if (!slabs_ || slab_used_ == slabs_->capacity) {
+            size_t cap = slabs_ ? 2 * slabs_->capacity : min_slab_size;
+            add_slab(cap < max_slab_size ? cap : max_slab_size);
+        }
+        return &slabs_->nodes[slab_used_++];
+    }
+
+    //! Destroys the key and puts the node on the free list.
+    void free_node(Node* n) {
+        n->key_ref().~key_type();
+        n->next_ = free_;
+        free_ = n;
+        if (!free_tail_) free_tail_ = n;
+    }
+
+    //! Puts the remaining nodes of the first slab on the free list.
+    void retire_slab_tail() {
+        if (!slabs_) return;
+        while (slab_used_ < slabs_->capacity) {
+            Node* n = &slabs_->nodes[slab_used_++];
+            n->next_ = free_;
+            free_ = n;
+            if (!free_tail_) free_tail_ = n;
+        }
+    }
+
+    //! Prepends a new slab with \c capacity nodes for bump allocation. The
+    //! remaining nodes of the previous first slab are put on the free list.
+    void add_slab(size_t capacity) {
+        retire_slab_tail();
+        Slab* s = new Slab { new Node[capacity], capacity, slabs_ };
+        if (!slabs_) slabs_tail_ = s;
+        slabs_ = s;
+        slab_used_ = 0;
+        capacity_ += capacity;
+    }
+
+    //! Destroys all keys in the subtree of n and puts its nodes on the free
+    //! list.
+    void destroy_tree(Node* n) {
+        if (!n) return;
+        std::vector<Node*> stack(1, n);
+        while (!stack.empty()) {
+            n = stack.back();
+            stack.pop_back();
+            for (Node* c = n->child_; c; c = c->next_)
+                stack.push_back(c);
+            free_node(n);
+        }
+    }
+
+    //! Destroys all keys and frees all slabs.
+    void release() {
+        clear();
+        while (slabs_) {
+            Slab* s = slabs_;
+            slabs_ = s->next;
+            delete[] s->nodes;
+            delete s;
+        }
+        reset();
+    }
+
+    //! Forgets all nodes and slabs, which have been moved elsewhere.
+    void reset() {
+        root_ = nullptr;
+        size_ = 0;
+        slabs_ = slabs_tail_ = nullptr;
+        slab_used_ = 0;
+        capacity_ = shrink_limit_ = 0;
+        free_ = free_tail_ = nullptr;
+    }
+
+    //! Takes over all nodes and slabs of other.
+    void take(PairingHeap& other) {
+        root_ = other.root_;
+        size_ = other.size_;
+        slabs_ = other.slabs_;
+        slabs_tail_ = other.slabs_tail_;
+        slab_used_ = other.slab_used_;
+        capacity_ = other.capacity_;
+        shrink_limit_ = other.shrink_limit_;
+        free_ = other.free_;
+        free_tail_ = other.free_tail_;
+        other.reset();
+    }
+};
+
+//! make template alias due to similarity with std::priority_queue
+template <typename KeyType, typename Compare = std::less<KeyType> >
+using pairing_heap = PairingHeap<KeyType, Compare>;
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_PAIRING_HEAP_HEADER
+
+/******************************************************************************/
@@ -11,10 +11,14 @@
 #ifndef TLX_CONTAINER_RING_BUFFER_HEADER
 #define TLX_CONTAINER_RING_BUFFER_HEADER
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <tlx/math/round_to_power_of_two.hpp>
@@ -31,6 +35,11 @@ namespace tlx {
  * the next power of two, even for powers of two! This is because otherwise
  * size() == end - begin == 0 after filling the ring buffer, and adding another
  * size_ member requires more book-keeping.
+ *
+ * The items are stored in at most two contiguous segments of the array, which
+ * peek_segments() exposes. The bulk operations push_back_range(),
+ * pop_front_into(), and copy_to() work segment-wise, and use memcpy() for
+ * trivially copyable types.
  */
 template <typename Type, class Allocator = std::allocator<Type> >
 class RingBuffer
@@ -49,6 +58,19 @@ public:
     using size_type = typename allocator_type::size_type;
     using difference_type = typename allocator_type::difference_type;
 
+    //! contiguous segment of items in the buffer
+    template <typename Pointer>
+    struct BasicSpan {
+        Pointer data;
+        size_type size;
+
+        Pointer begin() const { return data; }
+        Pointer end() const { return data + size; }
+    };
+
+    using Span = BasicSpan<Type*>;
+    using ConstSpan = BasicSpan<const Type*>;
+
     // using iterator;
     // using const_iterator;
     // using reverse_iterator = std::reverse_iterator<iterator>;
@@ -219,8 +241,8 @@ public:
     //! remove element at the end
     void pop_back() {
         assert(!empty());
-        alloc_traits::destroy(alloc_, std::addressof(data_[begin_]));
         --end_ &= mask_;
+        alloc_traits::destroy(alloc_, std::addressof(data_[end_]));
     }
 
     //! reset buffer contents
@@ -229,10 +251,42 @@ public:
             pop_front();
     }
 
+    //! add n items from the array at the end
+    void push_back_range(const value_type* in, size_t n) {
+        assert(size() + n <= max_size_);
+        size_t first = std::min(n, capacity_ - end_);
+        construct_range(data_ + end_, in, first, is_trivially_copyable());
+        construct_range(data_, in + first, n - first, is_trivially_copyable());
+        end_ = (end_ + n) & mask_;
+    }
+
+    //! move up to n items from the beginning into the array and remove them.
+    //! Returns the number of items moved.
+    size_t pop_front_into(value_type* out, size_t n) {
+        n = std::min(n, size());
+        size_t first = std::min(n, capacity_ - begin_);
+        move_range(out, data_ + begin_, first, is_trivially_copyable());
+        move_range(out + first, data_, n - first, is_trivially_copyable());
+        begin_ = (begin_ + n) & mask_;
+        return n;
+    }
+
     //! copy all element into the vector
     void copy_to(std::vector<value_type>* out) const {
-        for (size_t i = 0; i < size(); ++i)
-            out->emplace_back(operator [] (i));
+        std::pair<ConstSpan, ConstSpan> seg = peek_segments();
+        out->reserve(out->size() + size());
+        out->insert(out->end(), seg.first.begin(), seg.first.end());
+        out->insert(out->end(), seg.second.begin(), seg.second.end());
+    }
+
+    //! copy up to n items from the beginning into the array, without removing
+    //! them. Returns the number of items copied.
+    size_t copy_to(value_type* out, size_t n) const {
+        n = std::min(n, size());
+        size_t first = std::min(n, capacity_ - begin_);
+        copy_range(out, data_ + begin_, first, is_trivially_copyable());
+        copy_range(out + first, data_, n - first, is_trivially_copyable());
+        return n;
     }
 
     //! move all element from the RingBuffer into the vector
@@ -281,6 +335,21 @@ public:
         return data_[(end_ - 1) & mask_];
     }
 
+    //! Returns the two contiguous segments holding the items in order. The
+    //! second segment is empty unless the items wrap around the array's end.
+    std::pair<Span, Span> peek_segments() noexcept {
+        size_t first = std::min(size(), capacity_ - begin_);
+        return std::make_pair(Span { data_ + begin_, first },
+                              Span { data_, size() - first });
+    }
+    //! Returns the two contiguous segments holding the items in order. The
+    //! second segment is empty unless the items wrap around the array's end.
+    std::pair<ConstSpan, ConstSpan> peek_segments() const noexcept {
+        size_t first = std::min(size(), capacity_ - begin_);
+        return std::make_pair(ConstSpan { data_ + begin_, first },
+                              ConstSpan { data_, size() - first });
+    }
+
     //! \}
 
     //! \name Capacity
@@ -346,6 +415,47 @@ public:
     //! \}
 
 protected:
+    //! tag for selecting the memcpy() implementations of bulk operations
+    using is_trivially_copyable =
+        std::integral_constant<bool, std::is_trivially_copyable<Type>::value>;
+
+    //! construct n items at out from in, using memcpy()
+    void construct_range(Type* out, const Type* in, size_t n, std::true_type) {
+        if (n != 0) std::memcpy(out, in, n * sizeof(Type));
+    }
+
+    //! construct n items at out from in
+    void construct_range(Type* out, const Type* in, size_t n, std::false_type) {
+        for (size_t i = 0; i < n; ++i)
+            alloc_traits::construct(alloc_, std::addressof(out[i]), in[i]);
+    }
+
+    //! move n items from in to out and destroy them, using memcpy()
+    void move_range(Type* out, Type* in, size_t n, std::true_type) {
+        if (n != 0) std::memcpy(out, in, n * sizeof(Type));
+    }
+
+    //! move n items from in to out and destroy them
+    void move_range(Type* out, Type* in, size_t n, std::false_type) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = std::move(in[i]);
+            alloc_traits::destroy(alloc_, std::addressof(in[i]));
+        }
+    }
+
+    //! copy n items from in to out, using memcpy()
+    static void copy_range(Type* out, const Type* in, size_t n,
+                           std::true_type) {
+        if (n != 0) std::memcpy(out, in, n * sizeof(Type));
+    }
+
+    //! copy n items from in to out
+    static void copy_range(Type* out, const Type* in, size_t n,
+                           std::false_type) {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = in[i];
+    }
+
     //! target max_size of circular buffer prescribed by the user. Never equal
     //! to the data_.size(), which is rounded up to a power of two.
     size_t max_size_;
@@ -0,0 +1,272 @@
+/*******************************************************************************
+ * tlx/container/s3fifo_cache.hpp
+ *
+ * A fixed-capacity cache of (key -> value) pairs with S3-FIFO replacement.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_S3FIFO_CACHE_HEADER
+#define TLX_CONTAINER_S3FIFO_CACHE_HEADER
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * This is an expected O(1) cache of a fixed capacity, which contains a map of
+ * (key -> value) elements and evicts with the S3-FIFO policy by Yang et al.
+ * ("FIFO queues are all you need for cache eviction", SOSP 2023). It has the
+ * same interface as LruCacheMap with a capacity, and put() automatically
+ * evicts a pair when the cache is full.
+ *
+ * New pairs enter a small FIFO queue holding 10% of the capacity. Hits only
+ * increment a two-bit frequency counter. Pairs leaving the small queue move to
+ * the main FIFO queue if they were hit, otherwise they are evicted and their
+ * key is remembered in a ghost FIFO queue. Missed keys found in the ghost
+ * queue are inserted directly into the main queue. Pairs leaving the main queue
+ * are reinserted while their decremented frequency is non-zero. Hence
+ * one-hit wonders, e.g. from scans, are evicted quickly from the small queue.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key> >
+class S3FifoCacheMap
+{
+public:
+    using KeyValuePair = typename std::pair<Key, Value>;
+
+protected:
+    //! A cached pair with its access frequency.
+    struct Entry {
+        KeyValuePair pair;
+        //! number of hits, saturates at max_freq
+        uint8_t freq;
+        //! entry is in the main queue
+        bool main;
+    };
+
+    //! maximum value of the frequency counter
+    static constexpr uint8_t max_freq = 3;
+
+    using Queue = typename std::list<Entry>;
+    using GhostQueue = typename std::list<Key>;
+
+    using Map = typename std::unordered_map<
+        Key, typename Queue::iterator, Hash, KeyEqual>;
+    using GhostMap = typename std::unordered_map<
+        Key, typename GhostQueue::iterator, Hash, KeyEqual>;
+
+public:
+    //! construct a cache holding up to capacity pairs
+    explicit S3FifoCacheMap(size_t capacity)
+        : capacity_(capacity),
+          small_capacity_(capacity / 10 > 0 ? capacity / 10 : 1),
+          ghost_capacity_(capacity - capacity / 10) {
+        assert(capacity > 0);
+    }
+
+    //! clear cache
+    void clear() {
+        small_.clear();
+        main_.clear();
+        ghost_.clear();
+        map_.clear();
+        ghost_map_.clear();
+    }
+
+    //! put or replace/touch item in cache, evicts a pair if the cache is full
+    void put(const Key& key, const Value& value) {
+        typename Map::iterator it = map_.find(key);
+        if (it != map_.end()) {
+            it->second->pair.second = value;
+            hit(*it->second);
+            return;
+        }
+
+        while (map_.size() >= capacity_)
+            evict();
+
+        typename GhostMap::iterator g = ghost_map_.find(key);
+        if (g != ghost_map_.end()) {
+            // seen recently: insert into main queue
+            ghost_.erase(g->second);
+            ghost_map_.erase(g);
+            main_.push_front(Entry { KeyValuePair(key, value), 0, true });
+            map_.emplace(key, main_.begin());
+        }
+        else {
+            small_.push_front(Entry { KeyValuePair(key, value), 0, false });
+            map_.emplace(key, small_.begin());
+        }
+    }
+
+    //! touch pair in cache for key. Throws if it is not in the cache.
+    void touch(const Key& key) {
+        if (!touch_if_exists(key))
+            throw std::range_error("There is no such key in cache");
+    }
+
+    //! touch pair in cache for key. Returns true if it exists.
+    bool touch_if_exists(const Key& key) noexcept {
+        return find_touch(key) != nullptr;
+    }
+
+    //! remove key from cache. Throws if it is not in the cache.
+    void erase(const Key& key) {
+        if (!erase_if_exists(key))
+            throw std::range_error("There is no such key in cache");
+    }
+
+    //! remove key from cache. Returns true if it existed.
+    bool erase_if_exists(const Key& key) noexcept {
+        typename Map::iterator it = map_.find(key);
+        if (it == map_.end()) return false;
+        (it->second->main ? main_ : small_).erase(it->second);
+        map_.erase(it);
+        return true;
+    }
+
+    //! get value from cache for key. Throws if it is not in the cache.
+    const Value& get(const Key& key) const {
+        typename Map::const_iterator it = map_.find(key);
+        if (it == map_.end())
+            throw std::range_error("There is no such key in cache");
+        return it->second->pair.second;
+    }
+
+    //! get and touch value from cache for key. Throws if it is not in the
+    //! cache.
+    const Value& get_touch(const Key& key) {
+        const Value* v = find_touch(key);
+        if (!v)
+            throw std::range_error("There is no such key in cache");
+        return *v;
+    }
+
+    //! get and touch value from cache for key. Returns nullptr if it is not in
+    //! the cache.
+    const Value* find_touch(const Key& key) noexcept {
+        typename Map::iterator it = map_.find(key);
+        if (it == map_.end()) return nullptr;
+        hit(*it->second);
+        return &it->second->pair.second;
+    }
+
+    //! test if key exists in cache
+    bool exists(const Key& key) const {
+        return map_.find(key) != map_.end();
+    }
+
+    //! return number of items in cache
+    size_t size() const noexcept { return map_.size(); }
+
+    //! return maximum number of items in cache
+    size_t capacity() const noexcept { return capacity_; }
+
+    //! remove and return the pair which would be evicted next
+    KeyValuePair pop() {
+        assert(size());
+        return evict();
+    }
+
+private:
+    //! maximum number of pairs
+    size_t capacity_;
+    //! target size of the small queue
+    size_t small_capacity_;
+    //! maximum number of keys in the ghost queue
+    size_t ghost_capacity_;
+
+    //! small and main queues, new entries at the front
+    Queue small_, main_;
+    //! ghost queue of keys evicted from the small queue
+    GhostQueue ghost_;
+
+    //! map from key to entry in small_ or main_
+    Map map_;
+    //! map from key to entry in ghost_
+    GhostMap ghost_map_;
+
+    //! count a hit
+    static void hit(Entry& e) {
+        if (e.freq < max_freq) ++e.freq;
+    }
+
+    //! evict and return one pair
+    KeyValuePair evict() {
+        if (small_.size() >= small_capacity_ || main_.empty())
+            return evict_small();
+        return evict_main();
+    }
+
+    //! evict from the small queue, moving hit entries to the main queue
+    KeyValuePair evict_small() {
+        while (!small_.empty()) {
+            typename Queue::iterator t = std::prev(small_.end());
+            if (t->freq > 0) {
+                t->freq = 0;
+                t->main = true;
+                main_.splice(main_.begin(), small_, t);
+                continue;
+            }
+            remember(t->pair.first);
+            return remove(small_, t);
+        }
+        return evict_main();
+    }
+
+    //! evict from the main queue, reinserting entries with non-zero frequency
+    KeyValuePair evict_main() {
+        for ( ; ; ) {
+            typename Queue::iterator t = std::prev(main_.end());
+            if (t->freq > 0) {
+                --t->freq;
+                main_.splice(main_.begin(), main_, t);
+                continue;
+            }
+            return remove(main_, t);
+        }
+    }
+
+    //! insert key into the ghost queue
+    void remember(const Key& key) {
+        if (ghost_capacity_ == 0) return;
+        if (ghost_.size() >= ghost_capacity_) {
+            ghost_map_.erase(ghost_.back());
+            ghost_.pop_back();
+        }
+        ghost_.push_front(key);
+        ghost_map_[key] = ghost_.begin();
+    }
+
+    //! remove an entry and return its pair
+    KeyValuePair remove(Queue& q, typename Queue::iterator t) {
+        KeyValuePair out = std::move(t->pair);
+        map_.erase(out.first);
+        q.erase(t);
+        return out;
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_S3FIFO_CACHE_HEADER
+
+/******************************************************************************/
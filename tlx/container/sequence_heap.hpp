@@ -0,0 +1,474 @@
+/*******************************************************************************
+ * tlx/container/sequence_heap.hpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_SEQUENCE_HEAP_HEADER
+#define TLX_CONTAINER_SEQUENCE_HEAP_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <tlx/container/d_ary_heap.hpp>
+#include <tlx/container/loser_tree.hpp>
+#include <tlx/container/ring_buffer.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * This class implements a cache-efficient priority queue for very large
+ * numbers of items, a variant of the sequence heap by Peter Sanders ("Fast
+ * Priority Queues for Cached Memory", ACM JEA, 2000).
+ *
+ * The sequence heap consists of
+ *
+ * - an insertion heap (a DAryHeap) holding at most BufferSize new items,
+ *
+ * - groups 0, 1, 2, ... of at most Arity sorted sequences each, which are
+ *   merged by a LoserTreeCopy per group into a RingBuffer group buffer,
+ *
+ * - a RingBuffer deletion buffer containing the smallest items of all groups.
+ *
+ * When the insertion heap is full, its items are sorted, merged with the
+ * deletion buffer and group buffer 0, and added as a new sequence to group
+ * 0. When a group already contains Arity sequences, all of them are merged into
+ * one sequence, which is added to the next group. Hence group i contains
+ * sequences of about BufferSize * Arity^i items, and all operations access
+ * memory mostly sequentially.
+ *
+ * The invariant is that all items in the deletion buffer are smaller or equal
+ * to all items in the groups, and all items in a group buffer are smaller or
+ * equal to all items in the sequences of that group. The top item is thus
+ * either the top of the insertion heap or the front of the deletion buffer.
+ *
+ * \tparam KeyType    Key type.
+ * \tparam Arity      Maximum number of sequences per group.
+ * \tparam Compare    Function object to order keys.
+ * \tparam BufferSize Size of insertion heap, group and deletion buffers.
+ */
+template <typename KeyType, unsigned Arity = 64,
+          typename Compare = std::less<KeyType>, size_t BufferSize = 256>
+class SequenceHeap
+{
+    static_assert(Arity, "Arity must be greater than zero.");
+    static_assert(BufferSize, "BufferSize must be greater than zero.");
+
+public:
+    using key_type = KeyType;
+    using compare_type = Compare;
+
+    static constexpr size_t arity = Arity;
+    static constexpr size_t buffer_size = BufferSize;
+
+protected:
+    using LoserTreeType = LoserTreeCopy<false, key_type, compare_type>;
+    using Source = typename LoserTreeType::Source;
+
+    //! A group of up to Arity sorted sequences, merged by a loser tree into
+    //! the group buffer.
+    struct Group {
+        //! sorted sequences, consumed from heads[i]
+        std::vector<std::vector<key_type> > seqs;
+        //! current positions in the sequences
+        std::vector<size_t> heads;
+        //! number of items remaining in seqs
+        size_t remaining = 0;
+        //! loser tree merging the seqs
+        std::unique_ptr<LoserTreeType> tree;
+        //! smallest items of the group, already removed from the seqs
+        RingBuffer<key_type> buffer;
+
+        explicit Group(size_t buffer_size) : buffer(buffer_size) { }
+
+        //! copy group, the loser tree must be rebuilt
+        Group(const Group& g)
+            : seqs(g.seqs), heads(g.heads), remaining(g.remaining),
+              buffer(g.buffer) { }
+
+        Group(Group&&) = default;
+    };
+
+    //! insertion heap
+    DAryHeap<key_type, 4, compare_type> insert_heap_;
+
+    //! groups of sorted sequences
+    std::vector<Group> groups_;
+
+    //! deletion buffer
+    RingBuffer<key_type> delete_buffer_;
+
+    //! total number of items
+    size_t size_ = 0;
+
+    //! Compare function.
+    compare_type cmp_;
+
+public:
+    //! Allocates an empty heap.
+    explicit SequenceHeap(compare_type cmp = compare_type())
+        : insert_heap_(cmp), delete_buffer_(BufferSize), cmp_(cmp) {
+        insert_heap_.reserve(BufferSize);
+    }
+
+    //! Copy.
+    SequenceHeap(const SequenceHeap& o)
+        : insert_heap_(o.insert_heap_), groups_(o.groups_),
+          delete_buffer_(o.delete_buffer_), size_(o.size_), cmp_(o.cmp_) {
+        for (Group& g : groups_)
+            rebuild_tree(g);
+    }
+    SequenceHeap& operator = (const SequenceHeap& o) {
+        if (this == &o) return *this;
+        SequenceHeap copy(o);
+        return *this = std::move(copy);
+    }
+
+    //! Move.
+    SequenceHeap(SequenceHeap&&) = default;
+    SequenceHeap& operator = (SequenceHeap&&) = default;
+
+    //! Allocates space for \c new_size items (this is a no-op, since the
+    //! sequences are allocated when they are formed).
+    void reserve(size_t /* new_size */) { }
+
+    //! Empties the heap.
+    void clear() {
+        insert_heap_.clear();
+        groups_.clear();
+        delete_buffer_.clear();
+        size_ = 0;
+    }
+
+    //! Returns the number of items in the heap.
+    size_t size() const noexcept { return size_; }
+
+    //! Returns true if the heap has no items, false otherwise.
+    bool empty() const noexcept { return size_ == 0; }
+
+    //! Returns the number of groups currently in use.
+    size_t num_groups() const noexcept { return groups_.size(); }
+
+    //! Inserts a new item.
+    void push(const key_type& new_key) {
+        if (insert_heap_.size() >= BufferSize)
+            flush_insert_heap();
+        insert_heap_.push(new_key);
+        ++size_;
+    }
+
+    //! Inserts a new item.
+    void push(key_type&& new_key) {
+        if (insert_heap_.size() >= BufferSize)
+            flush_insert_heap();
+        insert_heap_.push(std::move(new_key));
+        ++size_;
+    }
+
+    //! Returns the top item.
+    const key_type& top() const noexcept {
+        assert(!empty());
+        if (top_in_insert_heap())
+            return insert_heap_.top();
+        return delete_buffer_.front();
+    }
+
+    //! Removes the top item.
+    void pop() {
+        assert(!empty());
+        if (top_in_insert_heap()) {
+            insert_heap_.pop();
+        }
+        else {
+            delete_buffer_.pop_front();
+            if (delete_buffer_.empty())
+                refill_delete_buffer();
+        }
+        --size_;
+    }
+
+    //! Removes and returns the top item.
+    key_type extract_top() {
+        key_type top_item = top();
+        pop();
+        return top_item;
+    }
+
+    //! Rebuilds the heap, e.g. after the order of the compare function
+    //! changed. Collects and sorts all items in O(n log n) time.
+    void update_all() {
+        std::vector<key_type> all;
+        all.reserve(size_);
+        while (!insert_heap_.empty())
+            all.emplace_back(insert_heap_.extract_top());
+        move_buffer(delete_buffer_, all);
+        for (Group& grp : groups_) {
+            move_buffer(grp.buffer, all);
+            for (size_t i = 0; i < grp.seqs.size(); ++i) {
+                std::move(grp.seqs[i].begin() + grp.heads[i],
+                          grp.seqs[i].end(), std::back_inserter(all));
+            }
+        }
+        assert(all.size() == size_);
+        clear();
+        build_from(std::move(all));
+    }
+
+    //! Builds a heap from a container.
+    template <class InputIterator>
+    void build_heap(InputIterator first, InputIterator last) {
+        clear();
+        build_from(std::vector<key_type>(first, last));
+    }
+
+    //! Builds a heap from the vector \c keys. Items of \c keys are copied.
+    void build_heap(const std::vector<key_type>& keys) {
+        build_heap(keys.begin(), keys.end());
+    }
+
+    //! For debugging: verifies that all sequences and buffers are sorted, that
+    //! the invariants between the deletion buffer, group buffers, and group
+    //! sequences hold, and that the number of items is correct.
+    bool sanity_check() {
+        size_t total = insert_heap_.size() + delete_buffer_.size();
+        if (!insert_heap_.sanity_check())
+            return false;
+        if (!is_sorted_buffer(delete_buffer_))
+            return false;
+
+        for (const Group& g : groups_) {
+            if (!is_sorted_buffer(g.buffer))
+                return false;
+            // deletion buffer items must not be larger than group items
+            if (!delete_buffer_.empty() && !g.buffer.empty() &&
+                cmp_(g.buffer.front(), delete_buffer_.back()))
+                return false;
+
+            size_t remaining = 0;
+            for (size_t i = 0; i < g.seqs.size(); ++i) {
+                const std::vector<key_type>& s = g.seqs[i];
+                if (g.heads[i] > s.size())
+                    return false;
+                remaining += s.size() - g.heads[i];
+                if (g.heads[i] == s.size())
+                    continue;
+                if (!std::is_sorted(s.begin() + g.heads[i], s.end(), cmp_))
+                    return false;
+                const key_type& head = s[g.heads[i]];
+                if (!g.buffer.empty() && cmp_(head, g.buffer.back()))
+                    return false;
+                if (!delete_buffer_.empty() &&
+                    cmp_(head, delete_buffer_.back()))
+                    return false;
+            }
+            if (remaining != g.remaining)
+                return false;
+            total += g.remaining + g.buffer.size();
+        }
+
+        // deletion buffer may only be empty if all groups are empty
+        if (delete_buffer_.empty() && total != insert_heap_.size())
+            return false;
+        return total == size_;
+    }
+
+private:
+    //! Returns true if the top item is in the insertion heap.
+    bool top_in_insert_heap() const {
+        if (delete_buffer_.empty()) return true;
+        if (insert_heap_.empty()) return false;
+        return cmp_(insert_heap_.top(), delete_buffer_.front());
+    }
+
+    //! Returns true if a ring buffer's items are sorted.
+    bool is_sorted_buffer(const RingBuffer<key_type>& rb) const {
+        for (size_t i = 1; i < rb.size(); ++i) {
+            if (cmp_(rb[i], rb[i - 1]))
+                return false;
+        }
+        return true;
+    }
+
+    //! Sorts the items of an empty heap and adds them as one sequence.
+    void build_from(std::vector<key_type>&& seq) {
+        std::sort(seq.begin(), seq.end(), cmp_);
+        size_ = seq.size();
+        if (seq.empty()) return;
+        add_sequence(0, std::move(seq));
+        refill_delete_buffer();
+    }
+
+    //! Moves and empties the items of a ring buffer to the back of out.
+    static void move_buffer(RingBuffer<key_type>& rb,
+                            std::vector<key_type>& out) {
+        while (!rb.empty()) {
+            out.emplace_back(std::move(rb.front()));
+            rb.pop_front();
+        }
+    }
+
+    //! Sorts the insertion heap and merges it together with the deletion
+    //! buffer into a new sequence of group 0.
+    void flush_insert_heap() {
+        std::vector<key_type> ins;
+        ins.reserve(insert_heap_.size());
+        while (!insert_heap_.empty()) {
+            ins.emplace_back(insert_heap_.extract_top());
+        }
+        std::vector<key_type> seq =
+            merge_buffer(std::move(ins), delete_buffer_);
+        add_sequence(0, std::move(seq));
+        refill_delete_buffer();
+    }
+
+    //! Merges and empties a ring buffer into a sorted sequence.
+    std::vector<key_type> merge_buffer(
+        std::vector<key_type>&& seq, RingBuffer<key_type>& rb) const {
+        if (rb.empty()) return std::move(seq);
+        std::vector<key_type> out;
+        out.reserve(seq.size() + rb.size());
+        auto it = seq.begin();
+        while (!rb.empty()) {
+            while (it != seq.end() && cmp_(*it, rb.front()))
+                out.emplace_back(std::move(*it++));
+            out.emplace_back(std::move(rb.front()));
+            rb.pop_front();
+        }
+        std::move(it, seq.end(), std::back_inserter(out));
+        return out;
+    }
+
+    //! Adds a sorted sequence to group g, moving the group to the next one if
+    //! it is full.
+    void add_sequence(size_t g, std::vector<key_type>&& seq) {
+        if (g == groups_.size())
+            groups_.emplace_back(BufferSize);
+
+        // keep the group buffer invariant by merging its items into seq
+        seq = merge_buffer(std::move(seq), groups_[g].buffer);
+
+        // drop exhausted sequences
+        {
+            Group& grp = groups_[g];
+            size_t j = 0;
+            for (size_t i = 0; i < grp.seqs.size(); ++i) {
+                if (grp.heads[i] == grp.seqs[i].size()) continue;
+                if (i != j) {
+                    grp.seqs[j] = std::move(grp.seqs[i]);
+                    grp.heads[j] = grp.heads[i];
+                }
+                ++j;
+            }
+            if (j != grp.seqs.size()) {
+                grp.seqs.resize(j);
+                grp.heads.resize(j);
+                rebuild_tree(grp);
+            }
+        }
+
+        if (groups_[g].seqs.size() >= Arity) {
+            // merge the full group into one sequence for the next group
+            std::vector<key_type> all;
+            all.reserve(groups_[g].remaining);
+            while (groups_[g].remaining != 0)
+                all.emplace_back(next_from_group(groups_[g]));
+            groups_[g].seqs.clear();
+            groups_[g].heads.clear();
+            add_sequence(g + 1, std::move(all));
+        }
+
+        Group& grp = groups_[g];
+        grp.remaining += seq.size();
+        grp.seqs.emplace_back(std::move(seq));
+        grp.heads.emplace_back(0);
+        rebuild_tree(grp);
+    }
+
+    //! Reconstructs the loser tree of a group from the sequence heads.
+    void rebuild_tree(Group& grp) {
+        grp.tree.reset(new LoserTreeType(Arity, cmp_));
+        for (Source i = 0; i < Arity; ++i) {
+            if (i < grp.seqs.size() && grp.heads[i] < grp.seqs[i].size())
+                grp.tree->insert_start(&grp.seqs[i][grp.heads[i]], i, false);
+            else
+                grp.tree->insert_start(nullptr, i, true);
+        }
+        grp.tree->init();
+    }
+
+    //! Removes the smallest item from the sequences of a group.
+    key_type next_from_group(Group& grp) {
+        assert(grp.remaining != 0);
+        Source s = grp.tree->min_source();
+        std::vector<key_type>& seq = grp.seqs[s];
+        key_type key = std::move(seq[grp.heads[s]]);
+        --grp.remaining;
+        if (++grp.heads[s] < seq.size()) {
+            grp.tree->delete_min_insert(&seq[grp.heads[s]], false);
+        }
+        else {
+            grp.tree->delete_min_insert(nullptr, true);
+            // release memory of the exhausted sequence
+            std::vector<key_type>().swap(seq);
+            grp.heads[s] = 0;
+        }
+        return key;
+    }
+
+    //! Refills a group buffer from the sequences of the group.
+    void refill_group_buffer(Group& grp) {
+        while (grp.remaining != 0 &&
+               grp.buffer.size() < grp.buffer.max_size()) {
+            grp.buffer.push_back(next_from_group(grp));
+        }
+    }
+
+    //! Refills the deletion buffer by merging the group buffers.
+    void refill_delete_buffer() {
+        while (delete_buffer_.size() < delete_buffer_.max_size()) {
+            // select the group with the smallest buffer front
+            Group* best = nullptr;
+            for (Group& grp : groups_) {
+                if (grp.buffer.empty())
+                    refill_group_buffer(grp);
+                if (grp.buffer.empty())
+                    continue;
+                if (!best || cmp_(grp.buffer.front(), best->buffer.front()))
+                    best = &grp;
+            }
+            if (!best) break;
+            delete_buffer_.push_back(std::move(best->buffer.front()));
+            best->buffer.pop_front();
+        }
+        // remove empty groups at the end
+        while (!groups_.empty() && groups_.back().remaining == 0 &&
+               groups_.back().buffer.empty())
+            groups_.pop_back();
+    }
+};
+
+//! make template alias due to similarity with std::priority_queue
+template <typename KeyType, unsigned Arity = 64,
+          typename Compare = std::less<KeyType>, size_t BufferSize = 256>
+using sequence_heap = SequenceHeap<KeyType, Arity, Compare, BufferSize>;
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_SEQUENCE_HEAP_HEADER
+
+/******************************************************************************/
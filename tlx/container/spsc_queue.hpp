@@ -0,0 +1,404 @@
+/*******************************************************************************
+ * tlx/container/spsc_queue.hpp
+ *
+ * Wait-free single-producer/single-consumer ring queue, and a blocking wrapper.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_SPSC_QUEUE_HEADER
+#define TLX_CONTAINER_SPSC_QUEUE_HEADER
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <tlx/math/round_to_power_of_two.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * A wait-free bounded queue for exactly one producer thread and one consumer
+ * thread. Like RingBuffer, it stores the items in an array with a power of two
+ * capacity, indexed by masking free-running counters.
+ *
+ * The producer owns the tail counter and the consumer owns the head counter,
+ * which are placed on separate cache lines. Each side additionally caches the
+ * last seen value of the other side's counter, and only reloads it when the
+ * queue appears full or empty. Hence, in the common case, an operation touches
+ * no cache line written by the other thread except the item slot itself.
+ * push_n() and pop_n() transfer a batch of items with a single counter update.
+ *
+ * The try_push(), try_emplace(), and push_n() methods may only be called by
+ * the producer, and try_pop(), front(), pop(), and pop_n() only by the
+ * consumer.
+ */
+template <typename Type, class Allocator = std::allocator<Type> >
+class SpscQueue
+{
+public:
+    using value_type = Type;
+    using allocator_type = Allocator;
+
+    using alloc_traits = std::allocator_traits<allocator_type>;
+
+    //! size of a cache line, by which the counters are separated
+    static constexpr size_t cache_line_size = 64;
+
+    //! create a queue holding at least max_size items, rounded up to the next
+    //! power of two.
+    explicit SpscQueue(size_t max_size,
+                       const Allocator& alloc = allocator_type())
+        : alloc_(alloc),
+          capacity_(round_up_to_power_of_two(max_size)),
+          mask_(capacity_ - 1),
+          data_(alloc_traits::allocate(alloc_, capacity_)) {
+        assert(max_size > 0);
+    }
+
+    //! non-copyable: delete copy-constructor
+    SpscQueue(const SpscQueue&) = delete;
+    //! non-copyable: delete assignment operator
+    SpscQueue& operator = (const SpscQueue&) = delete;
+
+    //! destroy remaining items and free the array
+    ~SpscQueue() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        for (size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i)
+            alloc_traits::destroy(alloc_, &data_[i & mask_]);
+        alloc_traits::deallocate(alloc_, data_, capacity_);
+    }
+
+    //! \name Observers
+    //! \{
+
+    //! return the maximum number of items in the queue
+    size_t capacity() const noexcept { return capacity_; }
+
+    //! return the number of items, which is only exact if called by the
+    //! producer or consumer while the other is not active.
+    size_t size() const noexcept {
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    //! return true if the queue appears empty
+    bool empty() const noexcept { return size() == 0; }
+
+    //! \}
+
+    //! \name Producer
+    //! \{
+
+    //! construct an item in place at the tail. Returns false if the queue is
+    //! full.
+    template <typename... Args>
+    bool try_emplace(Args&& ... args) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == capacity_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == capacity_)
+                return false;
+        }
+        alloc_traits::construct(alloc_, &data_[tail & mask_],
+                                std::forward<Args>(args) ...);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! copy an item to the tail. Returns false if the queue is full.
+    bool try_push(const Type& item) { return try_emplace(item); }
+
+    //! move an item to the tail. Returns false if the queue is full.
+    bool try_push(Type&& item) { return try_emplace(std::move(item)); }
+
+    //! push up to n items from an input iterator, as many as fit. Returns the
+    //! number of items pushed.
+    template <typename InputIterator>
+    size_t push_n(InputIterator first, size_t n) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t space = capacity_ - (tail - cached_head_);
+        if (space < n) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            space = capacity_ - (tail - cached_head_);
+            if (n > space) n = space;
+        }
+        for (size_t i = 0; i < n; ++i, ++first)
+            alloc_traits::construct(alloc_, &data_[(tail + i) & mask_], *first);
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    //! \}
+
+    //! \name Consumer
+    //! \{
+
+    //! return pointer to the item at the head, or nullptr if the queue is
+    //! empty.
+    Type * front() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_)
+                return nullptr;
+        }
+        return &data_[head & mask_];
+    }
+
+    //! remove the item at the head, which must exist (check with front()).
+    void pop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        assert(head != cached_tail_);
+        alloc_traits::destroy(alloc_, &data_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    //! move the item at the head to out and remove it. Returns false if the
+    //! queue is empty.
+    bool try_pop(Type& out) {
+        Type* p = front();
+        if (!p) return false;
+        out = std::move(*p);
+        pop();
+        return true;
+    }
+
+    //! move up to n items to an output iterator, as many as are available.
+    //! Returns the number of items popped.
+    template <typename OutputIterator>
+    size_t pop_n(OutputIterator out, size_t n) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t avail = cached_tail_ - head;
+        if (avail < n) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            avail = cached_tail_ - head;
+            if (n > avail) n = avail;
+        }
+        for (size_t i = 0; i < n; ++i, ++out) {
+            Type& item = data_[(head + i) & mask_];
+            *out = std::move(item);
+            alloc_traits::destroy(alloc_, &item);
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    //! \}
+
+private:
+    //! used allocator
+    allocator_type alloc_;
+    //! capacity of the array, a power of two
+    const size_t capacity_;
+    //! mask for indexing the array
+    const size_t mask_;
+    //! the array of items
+    Type* const data_;
+
+    //! padding to separate the read-only fields from the producer's
+    char pad0_[cache_line_size];
+
+    //! counter of pushed items, written by the producer
+    std::atomic<size_t> tail_ { 0 };
+    //! producer's copy of head_
+    size_t cached_head_ = 0;
+
+    //! padding to separate the producer's fields from the consumer's
+    char pad1_[cache_line_size];
+
+    //! counter of popped items, written by the consumer
+    std::atomic<size_t> head_ { 0 };
+    //! consumer's copy of tail_
+    size_t cached_tail_ = 0;
+
+    //! padding to separate the consumer's fields from following objects
+    char pad2_[cache_line_size];
+};
+
+/*!
+ * A blocking single-producer/single-consumer queue on top of SpscQueue. push()
+ * waits while the queue is full, and pop() waits while it is empty. Waiting
+ * threads first spin on the lock-free queue for a while, and then sleep on a
+ * condition variable. The other side only takes the mutex to wake them if a
+ * thread is actually sleeping, hence the uncontended path is lock-free.
+ *
+ * After close(), push() fails, and pop() returns the remaining items and then
+ * fails, which signals the end of the stream to the consumer.
+ */
+template <typename Type, class Allocator = std::allocator<Type> >
+class BlockingSpscQueue
+{
+public:
+    using value_type = Type;
+    using allocator_type = Allocator;
+
+    //! number of attempts on the lock-free queue before sleeping
+    static constexpr size_t spin_count = 256;
+
+    //! create a queue holding at least max_size items
+    explicit BlockingSpscQueue(size_t max_size,
+                               const Allocator& alloc = allocator_type())
+        : queue_(max_size, alloc) { }
+
+    //! return the maximum number of items in the queue
+    size_t capacity() const noexcept { return queue_.capacity(); }
+
+    //! return the approximate number of items in the queue
+    size_t size() const noexcept { return queue_.size(); }
+
+    //! close the queue and wake waiting threads
+    void close() {
+        closed_.store(true);
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    //! test if the queue was closed
+    bool closed() const noexcept { return closed_.load(); }
+
+    //! \name Producer
+    //! \{
+
+    //! copy an item to the tail, waits while the queue is full. Returns false
+    //! if the queue is closed.
+    bool push(const Type& item) { return emplace(item); }
+
+    //! move an item to the tail, waits while the queue is full. Returns false
+    //! if the queue is closed.
+    bool push(Type&& item) { return emplace(std::move(item)); }
+
+    //! construct an item at the tail, waits while the queue is full. Returns
+    //! false if the queue is closed.
+    template <typename... Args>
+    bool emplace(Args&& ... args) {
+        if (closed_.load(std::memory_order_relaxed) ||
+            !wait(producer_waiting_, not_full_, [&]() {
+                      return queue_.size() < queue_.capacity();
+                  }))
+            return false;
+        queue_.try_emplace(std::forward<Args>(args) ...);
+        wake(consumer_waiting_, not_empty_);
+        return true;
+    }
+
+    //! push n items from a forward iterator, waits while the queue is full.
+    //! Returns the number of items pushed, which is less than n only if the
+    //! queue was closed.
+    template <typename ForwardIterator>
+    size_t push_n(ForwardIterator first, size_t n) {
+        size_t done = 0;
+        while (done < n && !closed_.load(std::memory_order_relaxed)) {
+            if (!wait(producer_waiting_, not_full_, [&]() {
+                          return queue_.size() < queue_.capacity();
+                      }))
+                break;
+            size_t k = queue_.push_n(first, n - done);
+            std::advance(first, k);
+            done += k;
+            wake(consumer_waiting_, not_empty_);
+        }
+        return done;
+    }
+
+    //! \}
+
+    //! \name Consumer
+    //! \{
+
+    //! move the item at the head to out and remove it, waits while the queue
+    //! is empty. Returns false if the queue is empty and closed.
+    bool pop(Type& out) {
+        if (!wait(consumer_waiting_, not_empty_,
+                  [&]() { return queue_.front() != nullptr; }) &&
+            queue_.front() == nullptr)
+            return false;
+        queue_.try_pop(out);
+        wake(producer_waiting_, not_full_);
+        return true;
+    }
+
+    //! move up to n available items to an output iterator, waits until at
+    //! least one item is available. Returns the number of items popped, which
+    //! is zero only if the queue is empty and closed.
+    template <typename OutputIterator>
+    size_t pop_n(OutputIterator out, size_t n) {
+        if (!wait(consumer_waiting_, not_empty_,
+                  [&]() { return queue_.front() != nullptr; }) &&
+            queue_.front() == nullptr)
+            return 0;
+        size_t k = queue_.pop_n(out, n);
+        wake(producer_waiting_, not_full_);
+        return k;
+    }
+
+    //! \}
+
+private:
+    //! lock-free core
+    SpscQueue<Type, Allocator> queue_;
+    //! whether the queue was closed
+    std::atomic<bool> closed_ { false };
+    //! whether the producer sleeps, waiting for free space
+    std::atomic<bool> producer_waiting_ { false };
+    //! whether the consumer sleeps, waiting for items
+    std::atomic<bool> consumer_waiting_ { false };
+    //! mutex for sleeping
+    std::mutex mutex_;
+    //! condition variables for sleeping
+    std::condition_variable not_empty_, not_full_;
+
+    //! wait until ready() or the queue is closed. Returns ready().
+    template <typename Ready>
+    bool wait(std::atomic<bool>& waiting, std::condition_variable& cv,
+              Ready ready) {
+        for (size_t i = 0; i < spin_count; ++i) {
+            if (ready()) return true;
+            if (closed_.load(std::memory_order_relaxed)) return false;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting.store(true);
+        // pairs with the fence in wake(): either the other side sees the flag,
+        // or this side sees its update.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!ready()) {
+            if (closed_.load()) {
+                waiting.store(false);
+                return false;
+            }
+            cv.wait(lock);
+        }
+        waiting.store(false);
+        return true;
+    }
+
+    //! wake the other side if it sleeps
+    void wake(std::atomic<bool>& waiting, std::condition_variable& cv) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed)) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv.notify_one();
+        }
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_SPSC_QUEUE_HEADER
+
+/******************************************************************************/
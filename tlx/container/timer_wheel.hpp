@@ -0,0 +1,337 @@
+/*******************************************************************************
+ * tlx/container/timer_wheel.hpp
+ *
+ * Hierarchical timer wheel with O(1) scheduling and cancellation of timers.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_TIMER_WHEEL_HEADER
+#define TLX_CONTAINER_TIMER_WHEEL_HEADER
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <tlx/math/ffs.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * A hierarchical timer wheel (Varghese and Lauck), which schedules timers
+ * carrying a Payload for expiry at integer ticks. The time unit of a tick is
+ * up to the user.
+ *
+ * The wheel has four levels of 64 slots. Level l covers the ticks which agree
+ * with the current time in all bits above 6 * (l + 1), and a timer is stored
+ * in the slot of the lowest such level, selected by its expiry bits. When the
+ * current time advances into the range of a slot at level l > 0, its timers
+ * are cascaded to lower levels. Timers beyond 2^24 ticks are kept in an
+ * overflow list, which is redistributed each 2^24 ticks. Bitmaps of occupied
+ * slots let advance() skip empty slots, hence it runs in time proportional to
+ * the number of fired and cascaded timers, not to the elapsed ticks.
+ *
+ * Timers are nodes in a vector with intrusive doubly linked lists and a free
+ * list, hence schedule(), cancel(), and reschedule() are O(1) and do not
+ * allocate memory per timer once the vector has grown. A handle stays valid
+ * until its timer fires or is cancelled, afterwards it may be reused.
+ */
+template <typename Payload>
+class TimerWheel
+{
+public:
+    //! handle of a scheduled timer
+    using handle = uint32_t;
+
+    //! invalid handle
+    static constexpr handle invalid_handle = static_cast<handle>(-1);
+
+    //! number of levels
+    static constexpr unsigned num_levels = 4;
+
+    //! number of bits selecting a slot in each level
+    static constexpr unsigned slot_bits = 6;
+
+    //! number of slots in each level
+    static constexpr unsigned num_slots = 1u << slot_bits;
+
+protected:
+    //! A scheduled timer, or an element of the free list.
+    struct Node {
+        Payload payload;
+        //! tick at which the timer expires
+        uint64_t expiry;
+        //! linked list neighbours
+        handle prev, next;
+        //! index of list head, or invalid_handle if the node is free
+        uint32_t list;
+    };
+
+    //! index of the overflow list head
+    static constexpr uint32_t overflow_list = num_levels * num_slots;
+
+    //! number of list heads
+    static constexpr uint32_t num_lists = overflow_list + 1;
+
+public:
+    //! construct an empty timer wheel with current time now
+    explicit TimerWheel(uint64_t now = 0)
+        : now_(now) {
+        clear();
+    }
+
+    //! remove all timers, does not change the current time
+    void clear() {
+        nodes_.clear();
+        free_ = invalid_handle;
+        size_ = 0;
+        for (uint32_t i = 0; i < num_lists; ++i)
+            heads_[i] = invalid_handle;
+        for (unsigned l = 0; l < num_levels; ++l)
+            occupied_[l] = 0;
+    }
+
+    //! return the current time
+    uint64_t now() const noexcept { return now_; }
+
+    //! return number of scheduled timers
+    size_t size() const noexcept { return size_; }
+
+    //! return true if no timers are scheduled
+    bool empty() const noexcept { return size_ == 0; }
+
+    //! reserve space for n timers
+    void reserve(size_t n) { nodes_.reserve(n); }
+
+    /*!
+     * Schedule a timer carrying payload to expire at tick expiry. A timer
+     * whose expiry is not after the current time fires on the next advance().
+     */
+    handle schedule(uint64_t expiry, const Payload& payload) {
+        handle h;
+        if (free_ != invalid_handle) {
+            h = free_;
+            free_ = nodes_[h].next;
+            nodes_[h].payload = payload;
+        }
+        else {
+            assert(nodes_.size() < invalid_handle);
+            h = static_cast<handle>(nodes_.size());
+            nodes_.emplace_back(Node { payload, 0, 0, 0, 0 });
+        }
+        nodes_[h].expiry = expiry;
+        link(h, now_ + 1);
+        ++size_;
+        return h;
+    }
+
+    //! cancel a scheduled timer
+    void cancel(handle h) {
+        assert(is_scheduled(h));
+        unlink(h);
+        release(h);
+        --size_;
+    }
+
+    //! change the expiry of a scheduled timer
+    void reschedule(handle h, uint64_t expiry) {
+        assert(is_scheduled(h));
+        unlink(h);
+        nodes_[h].expiry = expiry;
+        link(h, now_ + 1);
+    }
+
+    //! test if a handle refers to a scheduled timer
+    bool is_scheduled(handle h) const {
+        return h < nodes_.size() && nodes_[h].list != invalid_handle;
+    }
+
+    //! return the expiry tick of a scheduled timer
+    uint64_t expiry(handle h) const {
+        assert(is_scheduled(h));
+        return nodes_[h].expiry;
+    }
+
+    //! return the payload of a scheduled timer
+    Payload& payload(handle h) {
+        assert(is_scheduled(h));
+        return nodes_[h].payload;
+    }
+
+    //! return the payload of a scheduled timer
+    const Payload& payload(handle h) const {
+        assert(is_scheduled(h));
+        return nodes_[h].payload;
+    }
+
+    /*!
+     * Advance the current time to now and fire all timers expiring until
+     * then, in order of expiry, by calling callback(Payload&&). Each timer is
+     * removed before its callback is called, hence the callback may schedule
+     * and cancel other timers. Returns the number of fired timers.
+     */
+    template <typename Callback>
+    size_t advance(uint64_t now, Callback&& callback) {
+        size_t fired = 0;
+        while (size_ != 0) {
+            uint64_t t = next_event();
+            if (t > now) break;
+            now_ = t;
+
+            // cascade slots whose range starts now, top level first
+            if ((now_ & level_mask(num_levels)) == 0)
+                cascade(overflow_list);
+            for (unsigned l = num_levels - 1; l > 0; --l) {
+                if ((now_ & level_mask(l)) == 0)
+                    cascade(list_index(l, digit(now_, l)));
+            }
+
+            // fire the timers of the level zero slot
+            uint32_t list = list_index(0, digit(now_, 0));
+            while (heads_[list] != invalid_handle) {
+                handle h = heads_[list];
+                unlink(h);
+                Payload p = std::move(nodes_[h].payload);
+                release(h);
+                --size_;
+                ++fired;
+                callback(std::move(p));
+            }
+        }
+        if (now > now_) now_ = now;
+        return fired;
+    }
+
+    /*!
+     * Return the tick of the next event, which is either the expiry of a timer
+     * or a cascade of timers to a lower level. Returns the maximum uint64_t if
+     * no timers are scheduled. No timer expires before this tick.
+     */
+    uint64_t next_event() const {
+        uint64_t best = std::numeric_limits<uint64_t>::max();
+        for (unsigned l = 0; l < num_levels; ++l) {
+            unsigned d = digit(now_, l);
+            uint64_t bits = d + 1 == num_slots
+                            ? 0 : occupied_[l] & (~uint64_t(0) << (d + 1));
+            if (bits == 0) continue;
+            unsigned s = slot_bits * l;
+            uint64_t t = ((now_ >> (s + slot_bits)) << (s + slot_bits))
+                         | (static_cast<uint64_t>(ffs(bits) - 1) << s);
+            if (t < best) best = t;
+            // events of higher levels occur after those of this level
+            break;
+        }
+        if (best == std::numeric_limits<uint64_t>::max() &&
+            heads_[overflow_list] != invalid_handle) {
+            unsigned s = slot_bits * num_levels;
+            best = ((now_ >> s) + 1) << s;
+        }
+        return best;
+    }
+
+private:
+    //! timer nodes
+    std::vector<Node> nodes_;
+    //! head of free list of nodes
+    handle free_;
+    //! number of scheduled timers
+    size_t size_;
+    //! current time
+    uint64_t now_;
+    //! list heads of slots and overflow list
+    handle heads_[num_lists];
+    //! bitmaps of non-empty slots in each level
+    uint64_t occupied_[num_levels];
+
+    //! return the slot digit of tick t in level l
+    static unsigned digit(uint64_t t, unsigned l) {
+        return static_cast<unsigned>(t >> (slot_bits * l)) & (num_slots - 1);
+    }
+
+    //! return mask of the tick bits below level l
+    static uint64_t level_mask(unsigned l) {
+        return (uint64_t(1) << (slot_bits * l)) - 1;
+    }
+
+    //! return index of list head of slot d in level l
+    static uint32_t list_index(unsigned l, unsigned d) {
+        return l * num_slots + d;
+    }
+
+    //! insert node into the list of its expiry, but not before tick earliest,
+    //! which is now_ + 1 except when cascading.
+    void link(handle h, uint64_t earliest) {
+        Node& n = nodes_[h];
+        uint64_t e = n.expiry > earliest ? n.expiry : earliest;
+        uint32_t list = overflow_list;
+        for (unsigned l = 0; l < num_levels; ++l) {
+            unsigned s = slot_bits * (l + 1);
+            if ((e >> s) == (now_ >> s)) {
+                unsigned d = digit(e, l);
+                list = list_index(l, d);
+                occupied_[l] |= uint64_t(1) << d;
+                break;
+            }
+        }
+        n.list = list;
+        n.prev = invalid_handle;
+        n.next = heads_[list];
+        if (n.next != invalid_handle)
+            nodes_[n.next].prev = h;
+        heads_[list] = h;
+    }
+
+    //! remove node from its list
+    void unlink(handle h) {
+        Node& n = nodes_[h];
+        if (n.prev != invalid_handle)
+            nodes_[n.prev].next = n.next;
+        else
+            heads_[n.list] = n.next;
+        if (n.next != invalid_handle)
+            nodes_[n.next].prev = n.prev;
+        if (heads_[n.list] == invalid_handle && n.list != overflow_list) {
+            occupied_[n.list / num_slots] &=
+                ~(uint64_t(1) << (n.list % num_slots));
+        }
+    }
+
+    //! put node on the free list
+    void release(handle h) {
+        nodes_[h].list = invalid_handle;
+        nodes_[h].next = free_;
+        free_ = h;
+    }
+
+    //! relink all timers of a list relative to the current time
+    void cascade(uint32_t list) {
+        handle h = heads_[list];
+        heads_[list] = invalid_handle;
+        if (list != overflow_list)
+            occupied_[list / num_slots] &=
+                ~(uint64_t(1) << (list % num_slots));
+        while (h != invalid_handle) {
+            handle next = nodes_[h].next;
+            link(h, now_);
+            h = next;
+        }
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_TIMER_WHEEL_HEADER
+
+/******************************************************************************/
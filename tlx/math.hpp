@@ -37,6 +37,7 @@ print "#include <$_>\n" foreach sort glob("tlx/math/"."*.hpp");
 #include <tlx/math/round_to_power_of_two.hpp>
 #include <tlx/math/round_up.hpp>
 #include <tlx/math/sgn.hpp>
+#include <tlx/math/windowed_aggregate.hpp>
 // [[[end]]]
 
 #endif // !TLX_MATH_HEADER
@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * tlx/math/windowed_aggregate.hpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_MATH_WINDOWED_AGGREGATE_HEADER
+#define TLX_MATH_WINDOWED_AGGREGATE_HEADER
+
+#include <tlx/container/ring_buffer.hpp>
+#include <tlx/math/aggregate.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace tlx {
+
+//! \addtogroup tlx_math
+//! \{
+
+/*!
+ * Calculate aggregate statistics over a sliding window of the most recent
+ * values: the minimum, the maximum, the average, the value number, and the
+ * standard deviation. The window is either limited to a number of values, or
+ * additionally to a time duration, in which case each value carries a
+ * timestamp.
+ *
+ * The values are kept in a RingBuffer. Adding and evicting a value takes
+ * amortized constant time: the mean and variance are updated subtractively,
+ * and the minimum and maximum are the front items of two monotonic queues.
+ */
+template <typename Type_, typename Time_ = double>
+class WindowedAggregate
+{
+public:
+    using Type = Type_;
+    using Time = Time_;
+
+    //! create a window over the last window_size values
+    explicit WindowedAggregate(size_t window_size)
+        : window_(window_size),
+          min_queue_(window_size), max_queue_(window_size) {
+        assert(window_size > 0);
+    }
+
+    //! create a window over the values of the last duration time units, but
+    //! at most max_size values.
+    WindowedAggregate(size_t max_size, const Time& duration)
+        : window_(max_size),
+          min_queue_(max_size), max_queue_(max_size),
+          time_based_(true), duration_(duration) {
+        assert(max_size > 0);
+    }
+
+    //! add a value, evicting the oldest value if the window is full
+    WindowedAggregate& add(const Type& value) {
+        return add(Time(), value);
+    }
+
+    //! add a value with a timestamp, evicting the values which are older than
+    //! the duration. Timestamps must be non-decreasing.
+    WindowedAggregate& add(const Time& time, const Type& value) {
+        advance(time);
+        if (window_.size() == window_.max_size())
+            evict();
+
+        window_.push_back(Entry { time, value });
+
+        while (!min_queue_.empty() && value < min_queue_.back().value)
+            min_queue_.pop_back();
+        min_queue_.push_back(Slot { seq_, value });
+
+        while (!max_queue_.empty() && max_queue_.back().value < value)
+            max_queue_.pop_back();
+        max_queue_.push_back(Slot { seq_, value });
+
+        ++seq_;
+
+        // Welford's update, see Aggregate::add()
+        double delta = value - mean_;
+        mean_ += delta / window_.size();
+        nvar_ += delta * (value - mean_);
+        return *this;
+    }
+
+    //! evict all values with timestamps at or before now - duration. Does
+    //! nothing if the window is not time-based.
+    void advance(const Time& now) {
+        if (!time_based_) return;
+        while (!window_.empty() && window_.front().time + duration_ <= now)
+            evict();
+    }
+
+    //! remove the oldest value from the window
+    void evict() {
+        assert(!window_.empty());
+        size_t seq = seq_ - window_.size();
+        Type value = window_.front().value;
+        window_.pop_front();
+
+        if (min_queue_.front().seq == seq)
+            min_queue_.pop_front();
+        if (max_queue_.front().seq == seq)
+            max_queue_.pop_front();
+
+        if (window_.empty()) {
+            mean_ = nvar_ = 0.0;
+            return;
+        }
+        // reverse Welford's update
+        double delta = value - mean_;
+        mean_ -= delta / window_.size();
+        nvar_ -= delta * (value - mean_);
+    }
+
+    //! remove all values
+    void clear() {
+        window_.clear();
+        min_queue_.clear();
+        max_queue_.clear();
+        mean_ = nvar_ = 0.0;
+    }
+
+    //! return number of values in the window
+    size_t count() const noexcept { return window_.size(); }
+
+    //! returns true if the window contains no values
+    bool empty() const noexcept { return window_.empty(); }
+
+    //! return maximum number of values in the window
+    size_t window_size() const noexcept { return window_.max_size(); }
+
+    //! return whether the window is limited by timestamps
+    bool time_based() const noexcept { return time_based_; }
+
+    //! return the duration of a time-based window
+    const Time& duration() const noexcept { return duration_; }
+
+    //! return sum over all values in the window
+    const Type sum() const { return static_cast<Type>(count() * mean_); }
+
+    //! return sum over all values in the window
+    const Type total() const { return sum(); }
+
+    //! return the average over all values in the window
+    double average() const noexcept { return mean_; }
+
+    //! return the average over all values in the window
+    double avg() const noexcept { return average(); }
+
+    //! return the average over all values in the window
+    double mean() const noexcept { return average(); }
+
+    //! return minimum over all values in the window
+    Type min() const noexcept {
+        return min_queue_.empty()
+               ? std::numeric_limits<Type>::max() : min_queue_.front().value;
+    }
+
+    //! return maximum over all values in the window
+    Type max() const noexcept {
+        return max_queue_.empty()
+               ? std::numeric_limits<Type>::lowest() : max_queue_.front().value;
+    }
+
+    //! return maximum - minimum over all values in the window
+    Type span() const noexcept { return max() - min(); }
+
+    //! return the variance of all values in the window.
+    //! ddof = delta degrees of freedom
+    //! Set to 0 if you have the entire distribution
+    //! Set to 1 if you have a sample (to correct for bias)
+    double variance(size_t ddof = 1) const {
+        if (count() <= 1) return 0.0;
+        // subtractive updates may leave a tiny negative residue
+        return std::max(nvar_, 0.0) / static_cast<double>(count() - ddof);
+    }
+
+    //! return the variance of all values in the window.
+    double var(size_t ddof = 1) const { return variance(ddof); }
+
+    //! return the standard deviation of all values in the window.
+    //! ddof = delta degrees of freedom
+    //! Set to 0 if you have the entire distribution
+    //! Set to 1 if you have a sample (to correct for bias)
+    double standard_deviation(size_t ddof = 1) const {
+        return std::sqrt(variance(ddof));
+    }
+
+    //! return the standard deviation of all values in the window.
+    double stdev(size_t ddof = 1) const { return standard_deviation(ddof); }
+
+    //! return an Aggregate of the values in the window
+    Aggregate<Type> aggregate() const {
+        return Aggregate<Type>(count(), mean_, std::max(nvar_, 0.0),
+                               min(), max());
+    }
+
+private:
+    //! value with its timestamp in the window
+    struct Entry {
+        Time time;
+        Type value;
+    };
+
+    //! value with its sequence number in the monotonic queues
+    struct Slot {
+        size_t seq;
+        Type value;
+    };
+
+    //! values in the window, oldest first
+    RingBuffer<Entry> window_;
+
+    //! increasing values of the window, the front item is the minimum
+    RingBuffer<Slot> min_queue_;
+
+    //! decreasing values of the window, the front item is the maximum
+    RingBuffer<Slot> max_queue_;
+
+    //! whether values are also evicted by timestamp
+    bool time_based_ = false;
+
+    //! duration of a time-based window
+    Time duration_ = Time();
+
+    //! sequence number of the next value added
+    size_t seq_ = 0;
+
+    //! mean of values
+    double mean_ = 0.0;
+
+    //! approximate count * variance; stddev = sqrt(nvar / (count-1))
+    double nvar_ = 0.0;
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_MATH_WINDOWED_AGGREGATE_HEADER
+
+/******************************************************************************/
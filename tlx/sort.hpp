@@ -17,7 +17,10 @@
 /*[[[perl
 print "#include <$_>\n" foreach sort grep(!/_impl/, glob("tlx/sort/"."*.hpp"));
 ]]]*/
+#include <tlx/sort/external_sorter.hpp>
 #include <tlx/sort/parallel_mergesort.hpp>
+#include <tlx/sort/parallel_samplesort.hpp>
+#include <tlx/sort/radix_sort.hpp>
 #include <tlx/sort/strings.hpp>
 #include <tlx/sort/strings_parallel.hpp>
 // [[[end]]]
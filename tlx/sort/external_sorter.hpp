@@ -0,0 +1,633 @@
+/*******************************************************************************
+ * tlx/sort/external_sorter.hpp
+ *
+ * **EXPERIMENTAL** External memory sorter for fixed-size records
+ * **EXPERIMENTAL**
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_SORT_EXTERNAL_SORTER_HEADER
+#define TLX_SORT_EXTERNAL_SORTER_HEADER
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <tlx/algorithm/multiway_merge_stream.hpp>
+#include <tlx/container/simple_vector.hpp>
+#include <tlx/delegate.hpp>
+#include <tlx/sort/parallel_mergesort.hpp>
+#include <tlx/unused.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_sort
+//! \{
+
+namespace external_sorter_detail {
+
+/*!
+ * Binary temporary file, which is deleted when closed. Without a directory,
+ * std::tmpfile() is used; otherwise a uniquely named file is created in the
+ * directory and removed in the destructor.
+ */
+class TempFile
+{
+public:
+    explicit TempFile(const std::string& dir) {
+        if (dir.empty()) {
+            file_ = std::tmpfile();
+        }
+        else {
+            static std::atomic<unsigned> counter { 0 };
+            path_ = dir + "/tlx_external_sorter_" +
+                    std::to_string(std::random_device { } ()) + "_" +
+                    std::to_string(counter++);
+            file_ = std::fopen(path_.c_str(), "w+b");
+        }
+        if (!file_)
+            throw std::runtime_error(
+                      "ExternalSorter: could not create temporary file");
+    }
+
+    //! non-copyable: delete copy-constructor
+    TempFile(const TempFile&) = delete;
+    //! non-copyable: delete assignment operator
+    TempFile& operator = (const TempFile&) = delete;
+
+    ~TempFile() {
+        std::fclose(file_);
+        if (!path_.empty())
+            std::remove(path_.c_str());
+    }
+
+    //! append bytes at the end of the file
+    void write(const void* data, size_t size) {
+        if (std::fwrite(data, 1, size, file_) != size)
+            throw std::runtime_error("ExternalSorter: write failed");
+    }
+
+    //! read up to size bytes from the current position, returns bytes read
+    size_t read(void* data, size_t size) {
+        size_t r = std::fread(data, 1, size, file_);
+        if (r != size && std::ferror(file_))
+            throw std::runtime_error("ExternalSorter: read failed");
+        return r;
+    }
+
+    //! flush written data and rewind to the beginning for reading
+    void rewind() {
+        if (std::fflush(file_) != 0)
+            throw std::runtime_error("ExternalSorter: flush failed");
+        std::rewind(file_);
+    }
+
+private:
+    //! stdio file handle
+    std::FILE* file_ = nullptr;
+    //! path of file in user-specified directory, empty for std::tmpfile()
+    std::string path_;
+};
+
+/*!
+ * A single background thread performing the file I/O jobs of the sorter in
+ * FIFO order, such that no thread is started per block. After a job threw an
+ * exception, the remaining jobs are skipped and wait() rethrows it.
+ */
+class IoWorker
+{
+public:
+    using Job = Delegate<void ()>;
+
+    IoWorker() : thread_([this]() { work(); }) { }
+
+    //! non-copyable: delete copy-constructor
+    IoWorker(const IoWorker&) = delete;
+    //! non-copyable: delete assignment operator
+    IoWorker& operator = (const IoWorker&) = delete;
+
+    //! finish all enqueued jobs and terminate the thread
+    ~IoWorker() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            terminate_ = true;
+        }
+        cv_jobs_.notify_one();
+        thread_.join();
+    }
+
+    //! enqueue a job, returns a ticket for wait()
+    size_t enqueue(Job&& job) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobs_.emplace_back(std::move(job));
+        cv_jobs_.notify_one();
+        return enqueued_++;
+    }
+
+    //! wait until the job of the ticket is done, rethrows a job's exception
+    void wait(size_t ticket) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_done_.wait(lock, [&]() { return done_ > ticket; });
+        if (error_) std::rethrow_exception(error_);
+    }
+
+    //! wait until the job of the ticket is done, ignores errors
+    void wait_nothrow(size_t ticket) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_done_.wait(lock, [&]() { return done_ > ticket; });
+    }
+
+private:
+    std::mutex mutex_;
+    //! signaled when a job is enqueued or on termination
+    std::condition_variable cv_jobs_;
+    //! signaled when a job is done
+    std::condition_variable cv_done_;
+    //! queue of jobs
+    std::deque<Job> jobs_;
+    //! number of jobs enqueued and done
+    size_t enqueued_ = 0, done_ = 0;
+    //! exception of the first failed job
+    std::exception_ptr error_;
+    //! flag to terminate after the queue is empty
+    bool terminate_ = false;
+    //! the I/O thread, started last
+    std::thread thread_;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_jobs_.wait(lock,
+                          [&]() { return terminate_ || !jobs_.empty(); });
+            if (jobs_.empty()) return;
+
+            Job job = std::move(jobs_.front());
+            jobs_.pop_front();
+            bool skip = (error_ != nullptr);
+            lock.unlock();
+
+            std::exception_ptr error;
+            if (!skip) {
+                try {
+                    job();
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+            }
+
+            lock.lock();
+            if (error && !error_) error_ = error;
+            ++done_;
+            cv_done_.notify_all();
+        }
+    }
+};
+
+/*!
+ * Writes blocks of items to a file asynchronously: while one buffer is
+ * written by the I/O thread, the other is filled.
+ */
+template <typename ValueType>
+class AsyncBlockWriter
+{
+public:
+    AsyncBlockWriter(IoWorker* io, TempFile* file, size_t block_size)
+        : io_(io), file_(file), block_size_(block_size),
+          buffer_(block_size), back_buffer_(block_size) { }
+
+    //! non-copyable: delete copy-constructor
+    AsyncBlockWriter(const AsyncBlockWriter&) = delete;
+    //! non-copyable: delete assignment operator
+    AsyncBlockWriter& operator = (const AsyncBlockWriter&) = delete;
+
+    ~AsyncBlockWriter() {
+        if (pending_) io_->wait_nothrow(ticket_);
+    }
+
+    //! append n items
+    void write(const ValueType* data, size_t n) {
+        while (n != 0) {
+            size_t m = std::min(n, block_size_ - fill_);
+            std::copy(data, data + m, buffer_.data() + fill_);
+            fill_ += m, data += m, n -= m;
+            if (fill_ == block_size_) issue();
+        }
+    }
+
+    //! write out the remaining items and wait for completion
+    void finish() {
+        if (fill_ != 0) issue();
+        if (pending_) {
+            pending_ = false;
+            io_->wait(ticket_);
+        }
+    }
+
+private:
+    IoWorker* io_;
+    TempFile* file_;
+    size_t block_size_;
+    //! buffer currently being filled, and buffer being written
+    SimpleVector<ValueType> buffer_, back_buffer_;
+    //! number of items in buffer_
+    size_t fill_ = 0;
+    //! whether a write of back_buffer_ is pending, and its ticket
+    bool pending_ = false;
+    size_t ticket_ = 0;
+
+    //! wait for the previous write, then start writing the filled buffer
+    void issue() {
+        if (pending_) {
+            pending_ = false;
+            io_->wait(ticket_);
+        }
+        buffer_.swap(back_buffer_);
+        TempFile* file = file_;
+        const ValueType* data = back_buffer_.data();
+        size_t bytes = fill_ * sizeof(ValueType);
+        ticket_ = io_->enqueue(
+            [file, data, bytes]() { file->write(data, bytes); });
+        pending_ = true;
+        fill_ = 0;
+    }
+};
+
+/*!
+ * Reads a sorted run block-wise from a file, prefetching the next block with
+ * the I/O thread while the merge consumes the current one.
+ */
+template <typename ValueType>
+class AsyncRunReader
+{
+public:
+    AsyncRunReader(IoWorker* io, TempFile* file, size_t size,
+                   size_t block_size)
+        : io_(io), file_(file), remaining_(size), block_size_(block_size),
+          prefetch_(block_size) {
+        file_->rewind();
+        issue();
+    }
+
+    //! non-copyable: delete copy-constructor
+    AsyncRunReader(const AsyncRunReader&) = delete;
+    //! non-copyable: delete assignment operator
+    AsyncRunReader& operator = (const AsyncRunReader&) = delete;
+
+    ~AsyncRunReader() {
+        if (pending_) io_->wait_nothrow(ticket_);
+    }
+
+    //! MultiwayMergeStream source: copy the prefetched block, and start
+    //! reading the next.
+    size_t operator () (ValueType* buffer, size_t n) {
+        if (!pending_) return 0;
+        pending_ = false;
+        io_->wait(ticket_);
+        size_t m = prefetch_size_;
+        assert(m <= n);
+        tlx::unused(n);
+        std::copy(prefetch_.data(), prefetch_.data() + m, buffer);
+        issue();
+        return m;
+    }
+
+private:
+    IoWorker* io_;
+    TempFile* file_;
+    //! number of items not yet requested from the file
+    size_t remaining_;
+    size_t block_size_;
+    //! buffer of background read
+    SimpleVector<ValueType> prefetch_;
+    //! number of items of the pending read
+    size_t prefetch_size_ = 0;
+    //! whether a read into prefetch_ is pending, and its ticket
+    bool pending_ = false;
+    size_t ticket_ = 0;
+
+    //! start reading the next block, if any
+    void issue() {
+        if (remaining_ == 0) return;
+        size_t m = std::min(remaining_, block_size_);
+        remaining_ -= m;
+        prefetch_size_ = m;
+        TempFile* file = file_;
+        ValueType* data = prefetch_.data();
+        size_t bytes = m * sizeof(ValueType);
+        ticket_ = io_->enqueue(
+            [file, data, bytes]() {
+                if (file->read(data, bytes) != bytes)
+                    throw std::runtime_error("ExternalSorter: run truncated");
+            });
+        pending_ = true;
+    }
+};
+
+} // namespace external_sorter_detail
+
+/*!
+ * **EXPERIMENTAL** External memory sorter for fixed-size records, which sorts
+ * more items than fit into the given memory budget.
+ *
+ * Items are pushed into a run buffer. Each full buffer is sorted with
+ * parallel_mergesort() and spilled to a temporary file with large sequential
+ * writes, which run in the background while the next buffer is filled. To
+ * overlap sorting and writing, the budget is split into two run buffers. All
+ * file I/O is done by one background thread of the sorter.
+ *
+ * sort() then releases the run buffers and merges all runs with a
+ * MultiwayMergeStream, whose loser tree consumes blocks that are prefetched
+ * asynchronously from each run file. The merge blocks share the whole budget.
+ * If there are more runs than blocks of min_block_bytes fit into the budget,
+ * the smallest runs are first merged into longer runs. The sorted output is
+ * passed block-wise to a callback or written to a file.
+ *
+ * \tparam ValueType trivially copyable record type
+ * \tparam Comparator comparator to use for binary comparisons.
+ */
+template <typename ValueType, typename Comparator = std::less<ValueType> >
+class ExternalSorter
+{
+    static_assert(std::is_trivially_copyable<ValueType>::value,
+                  "ExternalSorter requires trivially copyable records");
+
+public:
+    using value_type = ValueType;
+
+    //! sink callback receiving a block of n sorted items
+    using SinkFunction = Delegate<void(const ValueType* data, size_t n)>;
+
+    //! minimum size of I/O blocks in the merge phase
+    static constexpr size_t min_block_bytes = 64 * 1024;
+
+    /*!
+     * Create an external sorter.
+     *
+     * \param memory_bytes memory budget for buffers in bytes
+     * \param cmp comparator
+     * \param num_threads number of threads for parallel_mergesort()
+     * \param temp_dir directory for run files, if empty std::tmpfile() is used
+     */
+    explicit ExternalSorter(
+        size_t memory_bytes, const Comparator& cmp = Comparator(),
+        size_t num_threads = std::thread::hardware_concurrency(),
+        const std::string& temp_dir = std::string())
+        : memory_items_(std::max<size_t>(memory_bytes / sizeof(ValueType), 8)),
+          cmp_(cmp), num_threads_(std::max<size_t>(num_threads, 1)),
+          temp_dir_(temp_dir),
+          buffer_(memory_items_ / 2), back_buffer_(memory_items_ / 2) { }
+
+    //! non-copyable: delete copy-constructor
+    ExternalSorter(const ExternalSorter&) = delete;
+    //! non-copyable: delete assignment operator
+    ExternalSorter& operator = (const ExternalSorter&) = delete;
+
+    ~ExternalSorter() {
+        if (pending_) io_->wait_nothrow(ticket_);
+    }
+
+    //! add an item
+    void push(const ValueType& item) {
+        buffer_[fill_++] = item;
+        if (fill_ == buffer_.size()) spill();
+    }
+
+    //! add n items
+    void push(const ValueType* data, size_t n) {
+        while (n != 0) {
+            size_t m = std::min(n, buffer_.size() - fill_);
+            std::copy(data, data + m, buffer_.data() + fill_);
+            fill_ += m, data += m, n -= m;
+            if (fill_ == buffer_.size()) spill();
+        }
+    }
+
+    //! number of items pushed
+    size_t size() const {
+        size_t total = fill_;
+        for (const Run& r : runs_) total += r.size;
+        return total;
+    }
+
+    //! number of runs spilled to disk so far
+    size_t num_runs() const { return runs_.size(); }
+
+    /*!
+     * Merge all items and pass them in sorted order to the sink. The blocks
+     * hold up to a fifth of the memory budget if all items fit into memory,
+     * and otherwise up to the merge block size of the final pass, which is
+     * the budget divided by 2k + 3 for k runs. Afterwards the sorter is empty.
+     * Returns the number of items.
+     */
+    size_t sort(const SinkFunction& sink) {
+        if (runs_.empty()) {
+            // everything fits into memory
+            parallel_mergesort(buffer_.data(), buffer_.data() + fill_,
+                               cmp_, num_threads_);
+            size_t total = fill_;
+            for (size_t i = 0; i < fill_; i += block_items(1)) {
+                sink(buffer_.data() + i,
+                     std::min(block_items(1), fill_ - i));
+            }
+            fill_ = 0;
+            return total;
+        }
+
+        if (fill_ != 0) spill();
+        if (pending_) {
+            pending_ = false;
+            io_->wait(ticket_);
+        }
+
+        // release the run buffers, the merge blocks use the whole budget
+        buffer_.destroy();
+        back_buffer_.destroy();
+
+        // merge the smallest runs until a single pass suffices
+        while (runs_.size() > max_fan_in()) {
+            size_t k = std::min(max_fan_in(), runs_.size() - max_fan_in() + 1);
+            std::stable_sort(runs_.begin(), runs_.end(),
+                             [](const Run& a, const Run& b) {
+                                 return a.size < b.size;
+                             });
+            std::unique_ptr<TempFile> file(new TempFile(temp_dir_));
+            AsyncBlockWriter<ValueType> writer(
+                io_.get(), file.get(), block_items(k));
+            size_t total = merge_runs(
+                k, SinkFunction(
+                    [&writer](const ValueType* data, size_t n) {
+                        writer.write(data, n);
+                    }));
+            writer.finish();
+            runs_.erase(runs_.begin(), runs_.begin() + k);
+            runs_.emplace_back(std::move(file), total);
+        }
+
+        size_t total = merge_runs(runs_.size(), sink);
+        runs_.clear();
+
+        buffer_.resize(memory_items_ / 2);
+        back_buffer_.resize(memory_items_ / 2);
+        return total;
+    }
+
+    //! Merge all items and write them in sorted order as raw records to the
+    //! file at path. Returns the number of items.
+    size_t sort_to_file(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            throw std::runtime_error(
+                      "ExternalSorter: could not open " + path);
+        size_t total;
+        try {
+            total = sort(SinkFunction(
+                             [file](const ValueType* data, size_t n) {
+                                 if (std::fwrite(data, sizeof(ValueType), n,
+                                                 file) != n) {
+                                     throw std::runtime_error(
+                                         "ExternalSorter: write failed");
+                                 }
+                             }));
+        }
+        catch (...) {
+            std::fclose(file);
+            throw;
+        }
+        if (std::fclose(file) != 0)
+            throw std::runtime_error("ExternalSorter: write failed");
+        return total;
+    }
+
+private:
+    using TempFile = external_sorter_detail::TempFile;
+    using IoWorker = external_sorter_detail::IoWorker;
+    template <typename Type>
+    using AsyncBlockWriter = external_sorter_detail::AsyncBlockWriter<Type>;
+    template <typename Type>
+    using AsyncRunReader = external_sorter_detail::AsyncRunReader<Type>;
+
+    //! a sorted run in a temporary file
+    struct Run {
+        std::unique_ptr<TempFile> file;
+        size_t size;
+
+        Run(std::unique_ptr<TempFile>&& f, size_t s)
+            : file(std::move(f)), size(s) { }
+    };
+
+    //! memory budget in items
+    size_t memory_items_;
+
+    //! comparator
+    Comparator cmp_;
+
+    //! number of threads for sorting runs
+    size_t num_threads_;
+
+    //! directory of temporary files
+    std::string temp_dir_;
+
+    //! run buffer being filled, and run buffer being written in the
+    //! background
+    SimpleVector<ValueType> buffer_, back_buffer_;
+
+    //! number of items in buffer_
+    size_t fill_ = 0;
+
+    //! whether a write of back_buffer_ is pending, and its ticket
+    bool pending_ = false;
+    size_t ticket_ = 0;
+
+    //! runs spilled to disk
+    std::vector<Run> runs_;
+
+    //! I/O thread, started by the first spill. Declared last to finish its
+    //! jobs before the buffers and files are destroyed.
+    std::unique_ptr<IoWorker> io_;
+
+    //! items per block when merging k runs: each run needs a merge and a
+    //! prefetch buffer, and the output a merge block and two write buffers.
+    size_t block_items(size_t k) const {
+        return std::max<size_t>(memory_items_ / (2 * k + 3), 1);
+    }
+
+    //! maximum number of runs merged at once with blocks of min_block_bytes
+    size_t max_fan_in() const {
+        size_t min_items = std::max<size_t>(
+            min_block_bytes / sizeof(ValueType), 1);
+        size_t blocks = memory_items_ / min_items;
+        return blocks < 7 ? 2 : (blocks - 3) / 2;
+    }
+
+    //! sort the run buffer and write it to a new run file in the background
+    void spill() {
+        parallel_mergesort(buffer_.data(), buffer_.data() + fill_,
+                           cmp_, num_threads_);
+
+        // wait for the previous run to be written
+        if (!io_) io_.reset(new IoWorker());
+        if (pending_) {
+            pending_ = false;
+            io_->wait(ticket_);
+        }
+        buffer_.swap(back_buffer_);
+
+        runs_.emplace_back(
+            std::unique_ptr<TempFile>(new TempFile(temp_dir_)), fill_);
+        TempFile* file = runs_.back().file.get();
+        const ValueType* data = back_buffer_.data();
+        size_t bytes = fill_ * sizeof(ValueType);
+        ticket_ = io_->enqueue(
+            [file, data, bytes]() { file->write(data, bytes); });
+        pending_ = true;
+        fill_ = 0;
+    }
+
+    //! merge the first k runs into the sink
+    size_t merge_runs(size_t k, const SinkFunction& sink) {
+        size_t block_size = block_items(k);
+
+        std::vector<std::unique_ptr<AsyncRunReader<ValueType> > > readers;
+        MultiwayMergeStream<ValueType, Comparator> mms(block_size, cmp_);
+        for (size_t i = 0; i < k; ++i) {
+            readers.emplace_back(
+                new AsyncRunReader<ValueType>(
+                    io_.get(), runs_[i].file.get(), runs_[i].size,
+                    block_size));
+            AsyncRunReader<ValueType>* reader = readers.back().get();
+            mms.add_source(
+                [reader](ValueType* buffer, size_t n) {
+                    return (*reader)(buffer, n);
+                });
+        }
+        return mms.merge_blocks(sink);
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_SORT_EXTERNAL_SORTER_HEADER
+
+/******************************************************************************/
@@ -19,9 +19,12 @@
 #define TLX_SORT_PARALLEL_MERGESORT_HEADER
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <iterator>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #if defined(_OPENMP)
 #include <omp.h>
@@ -31,6 +34,7 @@
 #include <tlx/algorithm/parallel_multiway_merge.hpp>
 #include <tlx/simple_vector.hpp>
 #include <tlx/thread_barrier_mutex.hpp>
+#include <tlx/thread_pool.hpp>
 
 namespace tlx {
 
@@ -83,7 +87,8 @@ struct PMWMSSortingData {
 };
 
 /*!
- * Select samples from a sequence.
+ * Select samples from the locally sorted sequence of a thread. The samples are
+ * taken at equal distances, hence each thread's samples are sorted.
  * \param sd Pointer to sorting data struct. Result will be placed in \c sd->samples.
  * \param num_samples Number of samples to select.
  * \param iam my thread number
@@ -103,26 +108,66 @@ void determine_samples(PMWMSSortingData<RandomAccessIterator>* sd,
         static_cast<size_t>(num_samples + 1), es.begin());
 
     for (DiffType i = 0; i < num_samples; i++) {
-        sd->samples[iam * num_samples + i] = sd->source[sd->starts[iam] + es[i + 1]];
+        sd->samples[iam * num_samples + i] = sd->temporary[iam][es[i + 1]];
     }
 }
 
 /*!
- * PMWMS code executed by each thread.
+ * Select the sample of the given rank from the sorted sample sequences of all
+ * threads. This replaces sorting all samples, and is done by each thread for
+ * its own splitters in parallel.
+ * \param sd Pointer to sorting data struct.
+ * \param rank Rank of the sample to select.
+ * \param num_threads number of threads in group
+ * \param comp Comparator.
+ * \return Pointer to the selected sample.
+ */
+template <typename RandomAccessIterator, typename DiffType,
+          typename Comparator>
+const typename PMWMSSortingData<RandomAccessIterator>::ValueType*
+select_sample(PMWMSSortingData<RandomAccessIterator>* sd,
+              DiffType rank, size_t num_threads, Comparator& comp) {
+    using ValueType =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+
+    DiffType num_samples =
+        parallel_multiway_merge_oversampling * num_threads - 1;
+
+    simple_vector<std::pair<ValueType*, ValueType*> > seqs(num_threads);
+    for (size_t s = 0; s < num_threads; s++) {
+        ValueType* begin = sd->samples.data() + s * num_samples;
+        seqs[s] = std::make_pair(begin, begin + num_samples);
+    }
+
+    simple_vector<ValueType*> offsets(num_threads);
+    multisequence_partition(seqs.begin(), seqs.end(),
+                            rank, offsets.begin(), comp);
+
+    // the selected sample is the smallest one right of the partition
+    const ValueType* sample = nullptr;
+    for (size_t s = 0; s < num_threads; s++) {
+        if (offsets[s] == seqs[s].second) continue;
+        if (sample == nullptr || comp(*offsets[s], *sample))
+            sample = offsets[s];
+    }
+    return sample;
+}
+
+/*!
+ * PMWMS first phase executed by each thread: copy the thread's part to
+ * temporary storage, sort it locally, and select samples.
  * \param sd Pointer to sorting data struct.
  * \param iam my thread number
  * \param num_threads number of threads in group
- * \param barrier thread barrier from main function
  * \param comp Comparator.
  * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
  */
 template <bool Stable, typename RandomAccessIterator, typename Comparator>
-void parallel_sort_mwms_pu(PMWMSSortingData<RandomAccessIterator>* sd,
-                           size_t iam,
-                           size_t num_threads,
-                           ThreadBarrierMutex& barrier,
-                           Comparator& comp,
-                           MultiwayMergeSplittingAlgorithm mwmsa) {
+void parallel_sort_mwms_local(PMWMSSortingData<RandomAccessIterator>* sd,
+                              size_t iam,
+                              size_t num_threads,
+                              Comparator& comp,
+                              MultiwayMergeSplittingAlgorithm mwmsa) {
     using ValueType =
         typename std::iterator_traits<RandomAccessIterator>::value_type;
     using DiffType =
@@ -131,8 +176,6 @@ void parallel_sort_mwms_pu(PMWMSSortingData<RandomAccessIterator>* sd,
     // length of this thread's chunk, before merging
     DiffType length_local = sd->starts[iam + 1] - sd->starts[iam];
 
-    using SortingPlacesIterator = ValueType *;
-
     // sort in temporary storage, leave space for sentinel
     sd->temporary[iam] = static_cast<ValueType*>(
         ::operator new (sizeof(ValueType) * (length_local + 1)));
@@ -157,42 +200,69 @@ void parallel_sort_mwms_pu(PMWMSSortingData<RandomAccessIterator>* sd,
     {
         DiffType num_samples;
         determine_samples(sd, num_samples, iam, num_threads);
+    }
+}
 
-        barrier.wait(
-            [&]() {
-                std::sort(sd->samples.begin(), sd->samples.end(), comp);
-            });
+/*!
+ * PMWMS second phase executed by each thread: determine the pieces of all
+ * locally sorted sequences which this thread merges. With sampling, the
+ * thread selects its splitters from the samples, with exact splitting, only
+ * the ends of the pieces are determined.
+ * \param sd Pointer to sorting data struct.
+ * \param iam my thread number
+ * \param num_threads number of threads in group
+ * \param comp Comparator.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ */
+template <bool Stable, typename RandomAccessIterator, typename Comparator>
+void parallel_sort_mwms_split(PMWMSSortingData<RandomAccessIterator>* sd,
+                              size_t iam,
+                              size_t num_threads,
+                              Comparator& comp,
+                              MultiwayMergeSplittingAlgorithm mwmsa) {
+    using ValueType =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    using SortingPlacesIterator = ValueType *;
+
+    if (mwmsa == MWMSA_SAMPLING)
+    {
+        DiffType num_samples =
+            parallel_multiway_merge_oversampling * num_threads - 1;
+
+        // select the splitters of this thread from the sorted samples
+        const ValueType* lower = nullptr, * upper = nullptr;
+        if (iam > 0)
+            lower = select_sample(sd, num_samples * iam, num_threads, comp);
+        if (iam < num_threads - 1)
+            upper = select_sample(
+                sd, num_samples * (iam + 1), num_threads, comp);
 
         for (size_t s = 0; s < num_threads; s++)
         {
             // for each sequence
-            if (num_samples * iam > 0)
+            ValueType* begin = sd->temporary[s];
+            ValueType* end = begin + sd->starts[s + 1] - sd->starts[s];
+
+            if (lower != nullptr)
                 sd->pieces[iam][s].begin =
-                    std::lower_bound(sd->temporary[s],
-                                     sd->temporary[s] + sd->starts[s + 1] - sd->starts[s],
-                                     sd->samples[num_samples * iam],
-                                     comp)
-                    - sd->temporary[s];
+                    std::lower_bound(begin, end, *lower, comp) - begin;
             else
                 // absolute beginning
                 sd->pieces[iam][s].begin = 0;
 
-            if ((num_samples * (iam + 1)) < (num_samples * num_threads))
+            if (upper != nullptr)
                 sd->pieces[iam][s].end =
-                    std::lower_bound(sd->temporary[s],
-                                     sd->temporary[s] + sd->starts[s + 1] - sd->starts[s],
-                                     sd->samples[num_samples * (iam + 1)],
-                                     comp)
-                    - sd->temporary[s];
+                    std::lower_bound(begin, end, *upper, comp) - begin;
             else
                 // absolute end
-                sd->pieces[iam][s].end = sd->starts[s + 1] - sd->starts[s];
+                sd->pieces[iam][s].end = end - begin;
         }
     }
     else if (mwmsa == MWMSA_EXACT)
     {
-        barrier.wait();
-
         simple_vector<std::pair<SortingPlacesIterator,
                                 SortingPlacesIterator> > seqs(num_threads);
 
@@ -204,9 +274,14 @@ void parallel_sort_mwms_pu(PMWMSSortingData<RandomAccessIterator>* sd,
         simple_vector<SortingPlacesIterator> offsets(num_threads);
 
         // if not last thread
-        if (iam < num_threads - 1)
+        if (iam < num_threads - 1) {
             multisequence_partition(seqs.begin(), seqs.end(),
                                     sd->starts[iam + 1], offsets.begin(), comp);
+            if (Stable) {
+                multiway_merge_detail::stable_split_ties(
+                    seqs.begin(), seqs.end(), offsets.begin(), comp);
+            }
+        }
 
         for (size_t seq = 0; seq < num_threads; seq++)
         {
@@ -217,9 +292,34 @@ void parallel_sort_mwms_pu(PMWMSSortingData<RandomAccessIterator>* sd,
                 // absolute end of this sequence
                 sd->pieces[iam][seq].end = sd->starts[seq + 1] - sd->starts[seq];
         }
+    }
+}
 
-        barrier.wait();
+/*!
+ * PMWMS third phase executed by each thread: merge the pieces directly to the
+ * target. With exact splitting, the pieces' begins are the ends of the
+ * previous thread's pieces.
+ * \param sd Pointer to sorting data struct.
+ * \param iam my thread number
+ * \param num_threads number of threads in group
+ * \param comp Comparator.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ */
+template <bool Stable, typename RandomAccessIterator, typename Comparator>
+void parallel_sort_mwms_merge(PMWMSSortingData<RandomAccessIterator>* sd,
+                              size_t iam,
+                              size_t num_threads,
+                              Comparator& comp,
+                              MultiwayMergeSplittingAlgorithm mwmsa) {
+    using ValueType =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    using SortingPlacesIterator = ValueType *;
 
+    if (mwmsa == MWMSA_EXACT)
+    {
         for (size_t seq = 0; seq < num_threads; seq++)
         {
             // for each sequence
@@ -254,12 +354,75 @@ void parallel_sort_mwms_pu(PMWMSSortingData<RandomAccessIterator>* sd,
     multiway_merge_base<Stable, /* Sentinels */ false>(
         seqs.begin(), seqs.end(),
         sd->source + offset, length_am, comp);
+}
+
+/*!
+ * PMWMS code executed by each thread.
+ * \param sd Pointer to sorting data struct.
+ * \param iam my thread number
+ * \param num_threads number of threads in group
+ * \param barrier thread barrier from main function
+ * \param comp Comparator.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ */
+template <bool Stable, typename RandomAccessIterator, typename Comparator>
+void parallel_sort_mwms_pu(PMWMSSortingData<RandomAccessIterator>* sd,
+                           size_t iam,
+                           size_t num_threads,
+                           ThreadBarrierMutex& barrier,
+                           Comparator& comp,
+                           MultiwayMergeSplittingAlgorithm mwmsa) {
+
+    parallel_sort_mwms_local<Stable>(sd, iam, num_threads, comp, mwmsa);
+
+    barrier.wait();
+
+    parallel_sort_mwms_split<Stable>(sd, iam, num_threads, comp, mwmsa);
+
+    if (mwmsa == MWMSA_EXACT)
+        barrier.wait();
+
+    parallel_sort_mwms_merge<Stable>(sd, iam, num_threads, comp, mwmsa);
 
     barrier.wait();
 
     operator delete (sd->temporary[iam]);
 }
 
+/*!
+ * Prepare the sorting data for parallel multiway mergesort: split the input
+ * into num_threads parts of almost equal size.
+ */
+template <typename RandomAccessIterator>
+void parallel_sort_mwms_init(PMWMSSortingData<RandomAccessIterator>* sd,
+                             RandomAccessIterator begin,
+                             size_t n, size_t num_threads,
+                             MultiwayMergeSplittingAlgorithm mwmsa) {
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    sd->source = begin;
+
+    if (mwmsa == MWMSA_SAMPLING) {
+        sd->samples.resize(
+            num_threads * (parallel_multiway_merge_oversampling * num_threads - 1));
+    }
+
+    for (size_t s = 0; s < num_threads; s++)
+        sd->pieces[s].resize(num_threads);
+
+    DiffType* starts = sd->starts.data();
+
+    DiffType chunk_length = n / num_threads, split = n % num_threads, start = 0;
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        starts[i] = start;
+        start += (i < static_cast<size_t>(split))
+                 ? (chunk_length + 1) : chunk_length;
+    }
+    starts[num_threads] = start;
+}
+
 } // namespace parallel_mergesort_detail
 
 //! \name Parallel Sorting Algorithms
@@ -299,26 +462,8 @@ void parallel_mergesort_base(
         num_threads = static_cast<size_t>(n);
 
     PMWMSSortingData<RandomAccessIterator> sd(num_threads);
-    sd.source = begin;
-
-    if (mwmsa == MWMSA_SAMPLING) {
-        sd.samples.resize(
-            num_threads * (parallel_multiway_merge_oversampling * num_threads - 1));
-    }
-
-    for (size_t s = 0; s < num_threads; s++)
-        sd.pieces[s].resize(num_threads);
-
-    DiffType* starts = sd.starts.data();
-
-    DiffType chunk_length = n / num_threads, split = n % num_threads, start = 0;
-    for (size_t i = 0; i < num_threads; i++)
-    {
-        starts[i] = start;
-        start += (i < static_cast<size_t>(split))
-                 ? (chunk_length + 1) : chunk_length;
-    }
-    starts[num_threads] = start;
+    parallel_sort_mwms_init(&sd, begin, static_cast<size_t>(n), num_threads,
+                            mwmsa);
 
     // now sort in parallel
 
@@ -346,6 +491,74 @@ void parallel_mergesort_base(
 #endif // defined(_OPENMP)
 }
 
+/*!
+ * Parallel multiway mergesort main call running on a ThreadPool.
+ *
+ * The sequence is split into pool.size() parts. Each phase of the algorithm,
+ * local sorting, splitting, and merging, runs as one job per part on the pool,
+ * one of them in the calling thread. This avoids creating threads on every
+ * call. The pool may be shared, but the function must not be called from
+ * within one of its jobs.
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param comp Comparator.
+ * \param pool ThreadPool to run the sort on.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ * \tparam Stable Stable sorting.
+ */
+template <bool Stable,
+          typename RandomAccessIterator, typename Comparator>
+void parallel_mergesort_base(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator comp,
+    ThreadPool& pool,
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT) {
+
+    using namespace parallel_mergesort_detail;
+
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    DiffType n = end - begin;
+
+    if (n <= 1)
+        return;
+
+    // at least one element per thread
+    size_t num_threads = std::max<size_t>(pool.size(), 1);
+    if (num_threads > static_cast<size_t>(n))
+        num_threads = static_cast<size_t>(n);
+
+    PMWMSSortingData<RandomAccessIterator> sd(num_threads);
+    parallel_sort_mwms_init(&sd, begin, static_cast<size_t>(n), num_threads,
+                            mwmsa);
+
+    multiway_merge_detail::ThreadPoolRunner run { pool };
+
+    run(num_threads,
+        [&](size_t iam) {
+            parallel_sort_mwms_local<Stable>(
+                &sd, iam, num_threads, comp, mwmsa);
+        });
+
+    run(num_threads,
+        [&](size_t iam) {
+            parallel_sort_mwms_split<Stable>(
+                &sd, iam, num_threads, comp, mwmsa);
+        });
+
+    run(num_threads,
+        [&](size_t iam) {
+            parallel_sort_mwms_merge<Stable>(
+                &sd, iam, num_threads, comp, mwmsa);
+        });
+
+    for (size_t i = 0; i < num_threads; i++)
+        operator delete (sd.temporary[i]);
+}
+
 /*!
  * Parallel multiway mergesort.
  *
@@ -392,6 +605,457 @@ void stable_parallel_mergesort(
         begin, end, comp, num_threads, mwmsa);
 }
 
+/*!
+ * Parallel multiway mergesort running on a ThreadPool, see
+ * parallel_mergesort_base().
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param comp Comparator.
+ * \param pool ThreadPool to run the sort on.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ */
+template <typename RandomAccessIterator, typename Comparator>
+void parallel_mergesort(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator comp,
+    ThreadPool& pool,
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT) {
+
+    return parallel_mergesort_base</* Stable */ false>(
+        begin, end, comp, pool, mwmsa);
+}
+
+/*!
+ * Stable parallel multiway mergesort running on a ThreadPool, see
+ * parallel_mergesort_base().
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param comp Comparator.
+ * \param pool ThreadPool to run the sort on.
+ * \param mwmsa MultiwayMergeSplittingAlgorithm to use.
+ */
+template <typename RandomAccessIterator, typename Comparator>
+void stable_parallel_mergesort(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator comp,
+    ThreadPool& pool,
+    MultiwayMergeSplittingAlgorithm mwmsa = MWMSA_DEFAULT) {
+
+    return parallel_mergesort_base</* Stable */ true>(
+        begin, end, comp, pool, mwmsa);
+}
+
+/******************************************************************************/
+// Memory-Bounded Parallel Mergesort
+
+namespace parallel_mergesort_detail {
+
+/*!
+ * Stable merge of the sorted ranges [first, middle) and [middle, last) using a
+ * buffer of at most buffer_size items. If the shorter range fits into the
+ * buffer, it is moved there and merged back. Otherwise, both ranges are split
+ * such that the middle parts can be swapped by a rotation, and the two halves
+ * are merged independently.
+ */
+template <typename RandomAccessIterator, typename ValueType,
+          typename Comparator>
+void merge_bounded(RandomAccessIterator first,
+                   RandomAccessIterator middle,
+                   RandomAccessIterator last,
+                   ValueType* buffer, size_t buffer_size,
+                   Comparator& comp) {
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    while (true)
+    {
+        DiffType len1 = middle - first, len2 = last - middle;
+        if (len1 == 0 || len2 == 0)
+            return;
+
+        if (len1 <= len2 && static_cast<size_t>(len1) <= buffer_size)
+        {
+            // move first range to buffer, merge forward
+            ValueType* b = buffer, * b_end = std::move(first, middle, buffer);
+            RandomAccessIterator out = first;
+            while (b != b_end && middle != last) {
+                if (comp(*middle, *b))
+                    *out++ = std::move(*middle++);
+                else
+                    *out++ = std::move(*b++);
+            }
+            std::move(b, b_end, out);
+            return;
+        }
+
+        if (static_cast<size_t>(len2) <= buffer_size)
+        {
+            // move second range to buffer, merge backward
+            ValueType* b = std::move(middle, last, buffer);
+            RandomAccessIterator out = last;
+            while (b != buffer && middle != first) {
+                if (comp(*(b - 1), *(middle - 1)))
+                    *--out = std::move(*--middle);
+                else
+                    *--out = std::move(*--b);
+            }
+            std::move_backward(buffer, b, out);
+            return;
+        }
+
+        RandomAccessIterator cut1, cut2;
+        if (len1 > len2) {
+            cut1 = first + len1 / 2;
+            cut2 = std::lower_bound(middle, last, *cut1, comp);
+        }
+        else {
+            cut2 = middle + len2 / 2;
+            cut1 = std::upper_bound(first, middle, *cut2, comp);
+        }
+
+        RandomAccessIterator new_middle = cut1 + (cut2 - middle);
+        std::rotate(cut1, middle, cut2);
+
+        // recurse into the smaller half, loop on the larger one
+        if (new_middle - first < last - new_middle) {
+            merge_bounded(first, cut1, new_middle, buffer, buffer_size, comp);
+            first = new_middle, middle = cut2;
+        }
+        else {
+            merge_bounded(new_middle, cut2, last, buffer, buffer_size, comp);
+            last = new_middle, middle = cut1;
+        }
+    }
+}
+
+/*!
+ * Stable in-place sort using merge_bounded() with a buffer of buffer_size
+ * items: short runs are sorted with insertion sort, and then merged bottom-up.
+ */
+template <typename RandomAccessIterator, typename ValueType,
+          typename Comparator>
+void stable_sort_bounded(RandomAccessIterator first,
+                         RandomAccessIterator last,
+                         ValueType* buffer, size_t buffer_size,
+                         Comparator& comp) {
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    static const DiffType run_size = 32;
+    DiffType n = last - first;
+
+    for (DiffType r = 0; r < n; r += run_size)
+    {
+        RandomAccessIterator run_end = first + std::min(r + run_size, n);
+        for (RandomAccessIterator i = first + r + 1; i < run_end; ++i)
+        {
+            ValueType tmp = std::move(*i);
+            RandomAccessIterator j = i;
+            for ( ; j != first + r && comp(tmp, *(j - 1)); --j)
+                *j = std::move(*(j - 1));
+            *j = std::move(tmp);
+        }
+    }
+
+    for (DiffType width = run_size; width < n; width *= 2)
+    {
+        for (DiffType r = 0; r < n - width; r += 2 * width)
+        {
+            merge_bounded(first + r, first + r + width,
+                          first + std::min(r + 2 * width, n),
+                          buffer, buffer_size, comp);
+        }
+    }
+}
+
+/*!
+ * Reverse all given ranges, with the swaps split evenly among num_threads
+ * jobs. Small amounts of work are done by the calling thread.
+ */
+template <typename RandomAccessIterator, typename Runner>
+void parallel_reverse(
+    const std::vector<std::pair<RandomAccessIterator,
+                                RandomAccessIterator> >& ranges,
+    size_t num_threads, const Runner& run) {
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    // prefix sums of the number of swaps
+    simple_vector<DiffType> prefix(ranges.size() + 1);
+    prefix[0] = 0;
+    for (size_t r = 0; r < ranges.size(); ++r) {
+        prefix[r + 1] =
+            prefix[r] + (ranges[r].second - ranges[r].first) / 2;
+    }
+
+    DiffType total = prefix[ranges.size()];
+    if (total == 0)
+        return;
+
+    auto reverse_part =
+        [&](size_t iam, size_t num_parts) {
+            DiffType begin = total * iam / num_parts;
+            DiffType end = total * (iam + 1) / num_parts;
+
+            size_t r = std::upper_bound(prefix.begin(), prefix.end(), begin)
+                       - prefix.begin() - 1;
+
+            while (begin < end)
+            {
+                while (prefix[r + 1] <= begin) ++r;
+
+                DiffType off = begin - prefix[r];
+                DiffType count = std::min(end, prefix[r + 1]) - begin;
+
+                std::swap_ranges(
+                    ranges[r].first + off, ranges[r].first + off + count,
+                    std::reverse_iterator<RandomAccessIterator>(
+                        ranges[r].second - off));
+                begin += count;
+            }
+        };
+
+    if (num_threads <= 1 || total < 4096)
+        reverse_part(0, 1);
+    else
+        run(num_threads, [&](size_t iam) { reverse_part(iam, num_threads); });
+}
+
+//! Pending merge of [first, middle) and [middle, last), given as offsets.
+template <typename DiffType>
+struct PMWMSMergeTask {
+    DiffType first, middle, last;
+};
+
+/*!
+ * Split each merge task into two independent tasks of half the size: find the
+ * first half of the merged output in both ranges and rotate the parts between
+ * them such that the first half is in front. The rotations of all tasks are
+ * done together by three parallel reversals.
+ */
+template <typename RandomAccessIterator, typename DiffType,
+          typename Comparator, typename Runner>
+bool split_merge_tasks(RandomAccessIterator begin,
+                       std::vector<PMWMSMergeTask<DiffType> >& tasks,
+                       DiffType min_size, size_t num_threads,
+                       Comparator& comp, const Runner& run) {
+    using Range = std::pair<RandomAccessIterator, RandomAccessIterator>;
+
+    std::vector<PMWMSMergeTask<DiffType> > new_tasks;
+    std::vector<Range> parts, wholes;
+
+    for (const PMWMSMergeTask<DiffType>& t : tasks)
+    {
+        DiffType len1 = t.middle - t.first, len2 = t.last - t.middle;
+        if (len1 == 0 || len2 == 0 || len1 + len2 < min_size) {
+            new_tasks.push_back(t);
+            continue;
+        }
+
+        // find i + j = k, such that [0, i) and [0, j) are the first k items of
+        // the stable merge.
+        DiffType k = (len1 + len2) / 2;
+        DiffType lo = std::max<DiffType>(0, k - len2), hi = std::min(k, len1);
+        RandomAccessIterator a = begin + t.first, b = begin + t.middle;
+        while (lo < hi) {
+            DiffType i = (lo + hi) / 2;
+            if (!comp(b[k - i - 1], a[i]))
+                lo = i + 1;
+            else
+                hi = i;
+        }
+        DiffType i = lo, j = k - lo;
+
+        if (i != len1 && j != 0) {
+            parts.emplace_back(a + i, b);
+            parts.emplace_back(b, b + j);
+            wholes.emplace_back(a + i, b + j);
+        }
+
+        new_tasks.push_back(
+            PMWMSMergeTask<DiffType> { t.first, t.first + i, t.first + k });
+        new_tasks.push_back(
+            PMWMSMergeTask<DiffType> {
+                t.first + k, t.first + k + (len1 - i), t.last });
+    }
+
+    if (new_tasks.size() == tasks.size())
+        return false;
+
+    parallel_reverse(parts, num_threads, run);
+    parallel_reverse(wholes, num_threads, run);
+
+    tasks.swap(new_tasks);
+    return true;
+}
+
+/*!
+ * Memory-bounded parallel mergesort main call: the sequence is split into
+ * num_threads parts, which are sorted in place by the threads. Then, the
+ * sorted runs are merged pairwise in rounds. Each merge is split into
+ * independent tasks by parallel rotations, until there are enough tasks for
+ * all threads, and each task is merged using a buffer of buffer_size items.
+ */
+template <bool Stable,
+          typename RandomAccessIterator, typename Comparator, typename Runner>
+void parallel_mergesort_bounded_run(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator& comp,
+    size_t num_threads,
+    size_t buffer_size,
+    const Runner& run) {
+
+    using ValueType =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    using MergeTask = PMWMSMergeTask<DiffType>;
+
+    DiffType n = end - begin;
+
+    if (n <= 1)
+        return;
+
+    if (buffer_size == 0)
+        buffer_size = std::max<size_t>((1 << 20) / sizeof(ValueType), 1);
+
+    // at least one element per thread
+    if (num_threads > static_cast<size_t>(n))
+        num_threads = static_cast<size_t>(n);
+    if (num_threads == 0)
+        num_threads = 1;
+
+    simple_vector<simple_vector<ValueType> > buffers(num_threads);
+
+    std::vector<DiffType> bounds(num_threads + 1);
+    multiway_merge_detail::equally_split(n, num_threads, bounds.begin());
+
+    // sort the parts in place
+
+    auto sort_part =
+        [&](size_t iam) {
+            buffers[iam].resize(buffer_size);
+            if (Stable)
+                stable_sort_bounded(
+                    begin + bounds[iam], begin + bounds[iam + 1],
+                    buffers[iam].data(), buffer_size, comp);
+            else
+                std::sort(begin + bounds[iam], begin + bounds[iam + 1], comp);
+        };
+
+    if (num_threads == 1) {
+        sort_part(0);
+        return;
+    }
+
+    run(num_threads, sort_part);
+
+    // merge pairs of runs, until one is left
+
+    while (bounds.size() > 2)
+    {
+        std::vector<MergeTask> tasks;
+        std::vector<DiffType> next_bounds;
+
+        size_t r = 0;
+        for ( ; r + 2 < bounds.size(); r += 2) {
+            tasks.push_back(
+                MergeTask { bounds[r], bounds[r + 1], bounds[r + 2] });
+            next_bounds.push_back(bounds[r]);
+        }
+        if (r + 1 < bounds.size()) {
+            // odd number of runs, the last one is merged in the next round
+            next_bounds.push_back(bounds[r]);
+        }
+        next_bounds.push_back(n);
+
+        DiffType min_size = std::max<DiffType>(
+            static_cast<DiffType>(2 * buffer_size),
+            n / static_cast<DiffType>(4 * num_threads));
+
+        while (tasks.size() < 2 * num_threads &&
+               split_merge_tasks(begin, tasks, min_size, num_threads,
+                                 comp, run)) { }
+
+        std::atomic<size_t> next_task(0);
+
+        run(num_threads,
+            [&](size_t iam) {
+                size_t t;
+                while ((t = next_task++) < tasks.size()) {
+                    merge_bounded(begin + tasks[t].first,
+                                  begin + tasks[t].middle,
+                                  begin + tasks[t].last,
+                                  buffers[iam].data(), buffer_size, comp);
+                }
+            });
+
+        bounds.swap(next_bounds);
+    }
+}
+
+} // namespace parallel_mergesort_detail
+
+/*!
+ * Memory-bounded parallel mergesort. In contrast to parallel_mergesort(), which
+ * copies the whole input to temporary storage, the parts are sorted in place
+ * and merged pairwise using a buffer of buffer_size items per thread, hence
+ * the extra memory is independent of the input size. This is slower, but
+ * allows sorting inputs which fill most of the memory.
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param comp Comparator.
+ * \param num_threads Number of threads to use.
+ * \param buffer_size Merge buffer items per thread, or 0 for 1 MiB.
+ */
+template <typename RandomAccessIterator,
+          typename Comparator = std::less<
+              typename std::iterator_traits<RandomAccessIterator>::value_type> >
+void parallel_mergesort_bounded(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator comp = Comparator(),
+    size_t num_threads = std::thread::hardware_concurrency(),
+    size_t buffer_size = 0) {
+
+    parallel_mergesort_detail::parallel_mergesort_bounded_run<
+        /* Stable */ false>(
+        begin, end, comp, num_threads, buffer_size,
+        multiway_merge_detail::ThreadRunner());
+}
+
+/*!
+ * Stable memory-bounded parallel mergesort, see parallel_mergesort_bounded().
+ * The parts are sorted in place with a bounded buffer as well.
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param comp Comparator.
+ * \param num_threads Number of threads to use.
+ * \param buffer_size Merge buffer items per thread, or 0 for 1 MiB.
+ */
+template <typename RandomAccessIterator,
+          typename Comparator = std::less<
+              typename std::iterator_traits<RandomAccessIterator>::value_type> >
+void stable_parallel_mergesort_bounded(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator comp = Comparator(),
+    size_t num_threads = std::thread::hardware_concurrency(),
+    size_t buffer_size = 0) {
+
+    parallel_mergesort_detail::parallel_mergesort_bounded_run<
+        /* Stable */ true>(
+        begin, end, comp, num_threads, buffer_size,
+        multiway_merge_detail::ThreadRunner());
+}
+
 //! \}
 //! \}
 
@@ -0,0 +1,804 @@
+/*******************************************************************************
+ * tlx/sort/parallel_samplesort.hpp
+ *
+ * In-place (parallel) super scalar samplesort for arbitrary value types with a
+ * comparator, following the ideas of IPS4o.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_SORT_PARALLEL_SAMPLESORT_HEADER
+#define TLX_SORT_PARALLEL_SAMPLESORT_HEADER
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tlx/algorithm/parallel_multiway_merge.hpp>
+#include <tlx/math/integer_log2.hpp>
+#include <tlx/simple_vector.hpp>
+#include <tlx/thread_pool.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_sort
+//! \{
+
+namespace parallel_samplesort_detail {
+
+//! maximum number of splitter tree levels, i.e. 256 buckets, or 512 buckets
+//! with equality buckets.
+static const size_t max_log_buckets = 8;
+
+//! maximum number of buckets of one partitioning step
+static const size_t max_buckets = 2 << max_log_buckets;
+
+/*!
+ * Classification of items into buckets by a perfect binary search tree over
+ * the splitters stored in level-order. The tree is descended without branches,
+ * and several items are classified in an interleaved loop, as in the string
+ * sample sort's SSClassifyTreeCalcUnrollInterleave. If the sample contained
+ * duplicate splitters, each splitter gets an additional bucket for items equal
+ * to it, which need not be sorted further.
+ */
+template <typename ValueType, typename Comparator>
+class SampleSortClassifier
+{
+public:
+    //! number of items classified at once
+    static const size_t rollout = 8;
+
+    explicit SampleSortClassifier(const Comparator& comp)
+        : tree_(size_t(1) << max_log_buckets),
+          sorted_(size_t(1) << max_log_buckets),
+          comp_(comp) { }
+
+    //! build tree from a sorted sequence of unique splitters, the splitter
+    //! array is padded to 2^log_buckets - 1 items with the largest splitter.
+    void build(const ValueType* splitters, size_t num_splitters,
+               size_t log_buckets, bool use_equal) {
+        log_buckets_ = log_buckets;
+        num_leaves_ = size_t(1) << log_buckets;
+        use_equal_ = use_equal;
+
+        for (size_t i = 0; i < num_leaves_ - 1; ++i) {
+            sorted_[i] =
+                splitters[i < num_splitters ? i : num_splitters - 1];
+        }
+        build_tree(1, 0, num_leaves_ - 1);
+    }
+
+    //! number of buckets, including the equality buckets
+    size_t num_buckets() const {
+        return use_equal_ ? 2 * num_leaves_ : num_leaves_;
+    }
+
+    //! whether equality buckets are used
+    bool use_equal() const { return use_equal_; }
+
+    //! whether the bucket contains only items equal to a splitter
+    bool is_equal_bucket(size_t b) const {
+        return use_equal_ && (b % 2) == 1;
+    }
+
+    //! classify a single item
+    size_t classify(const ValueType& key) const {
+        size_t i = 1;
+        for (size_t l = 0; l < log_buckets_; ++l)
+            i = 2 * i + (comp_(tree_[i], key) ? 1 : 0);
+        return leaf_to_bucket(i, key);
+    }
+
+    //! classify all items in [begin, end) and call callback(bucket, iterator)
+    //! for each of them in order.
+    template <typename Iterator, typename Callback>
+    void classify(Iterator begin, Iterator end, Callback callback) const {
+        while (end - begin >= static_cast<std::ptrdiff_t>(rollout))
+        {
+            size_t i[rollout];
+            std::fill(i, i + rollout, 1);
+
+            for (size_t l = 0; l < log_buckets_; ++l) {
+                for (size_t u = 0; u < rollout; ++u)
+                    i[u] = 2 * i[u] + (comp_(tree_[i[u]], begin[u]) ? 1 : 0);
+            }
+
+            for (size_t u = 0; u < rollout; ++u)
+                callback(leaf_to_bucket(i[u], begin[u]), begin + u);
+
+            begin += rollout;
+        }
+
+        for ( ; begin != end; ++begin)
+            callback(classify(*begin), begin);
+    }
+
+private:
+    //! splitter tree in level-order, index 0 is unused
+    simple_vector<ValueType> tree_;
+    //! sorted splitters for equality checks
+    simple_vector<ValueType> sorted_;
+
+    //! number of tree levels
+    size_t log_buckets_;
+    //! number of leaves of the tree, without equality buckets
+    size_t num_leaves_;
+    //! whether equality buckets are used
+    bool use_equal_;
+
+    //! comparator
+    Comparator comp_;
+
+    //! fill the subtree at index i with the sorted splitters [lo, hi)
+    void build_tree(size_t i, size_t lo, size_t hi) {
+        if (i >= num_leaves_) return;
+        size_t mid = (lo + hi) / 2;
+        tree_[i] = sorted_[mid];
+        build_tree(2 * i, lo, mid);
+        build_tree(2 * i + 1, mid + 1, hi);
+    }
+
+    //! convert tree leaf index to bucket number
+    size_t leaf_to_bucket(size_t i, const ValueType& key) const {
+        size_t b = i - num_leaves_;
+        if (!use_equal_)
+            return b;
+        // key <= sorted_[b], check if it is equal
+        return 2 * b +
+               (b < num_leaves_ - 1 && !comp_(key, sorted_[b]) ? 1 : 0);
+    }
+};
+
+//! Read and write block pointers of a bucket during the block permutation.
+template <typename DiffType>
+struct SampleSortBucketPointers {
+    //! lock protecting the pointers and reads of blocks
+    std::mutex mutex;
+    //! next block to write to
+    DiffType write;
+    //! last unprocessed block, unprocessed blocks are [write, read]
+    DiffType read;
+};
+
+//! Data shared by all threads working on one partitioning step.
+template <typename ValueType, typename DiffType>
+struct SampleSortSharedData {
+    //! block pointers per bucket
+    simple_vector<SampleSortBucketPointers<DiffType> > pointers;
+    //! buffer for the block which is written past the end of the input
+    simple_vector<ValueType> overflow;
+    //! bucket of the overflow block, or max_buckets if unused
+    size_t overflow_bucket;
+
+    explicit SampleSortSharedData(size_t block_size)
+        : pointers(max_buckets), overflow(block_size) { }
+};
+
+//! Thread-local data of the sample sort.
+template <typename ValueType, typename DiffType, typename Comparator>
+struct SampleSortLocalData {
+    //! one block buffer per bucket
+    simple_vector<ValueType> buffers;
+    //! number of items in each bucket's buffer
+    simple_vector<size_t> fill;
+    //! number of items classified into each bucket
+    simple_vector<DiffType> counts;
+    //! two swap blocks for the block permutation
+    simple_vector<ValueType> swap;
+    //! end of the full blocks written during classification
+    DiffType write_end;
+
+    //! classifier and shared data for sequential partitioning steps
+    SampleSortClassifier<ValueType, Comparator> classifier;
+    SampleSortSharedData<ValueType, DiffType> shared;
+
+    //! random generator for sampling
+    std::minstd_rand rng;
+
+    SampleSortLocalData(size_t block_size, const Comparator& comp)
+        : fill(max_buckets), counts(max_buckets),
+          classifier(comp), shared(block_size) { }
+
+    //! allocate the buffers on first use, in the thread using them
+    void allocate(size_t block_size) {
+        if (buffers.size() != 0) return;
+        buffers.resize(max_buckets * block_size);
+        swap.resize(2 * block_size);
+    }
+};
+
+//! Runs job(0), ..., job(n - 1) sequentially in the calling thread.
+struct SequentialRunner {
+    template <typename Job>
+    void operator () (size_t n, const Job& job) const {
+        for (size_t i = 0; i < n; ++i)
+            job(i);
+    }
+};
+
+/*!
+ * In-place super scalar samplesort. Each partitioning step classifies the
+ * items of each thread's stripe into block buffers, which are written back to
+ * the stripe when full. The full blocks are then permuted into their buckets,
+ * and the remaining partial blocks fill the gaps at the bucket boundaries.
+ * Hence, only a few blocks per bucket and thread of extra memory are needed.
+ *
+ * All item moves of a step run in parallel: the classification per stripe,
+ * the compaction of full blocks, the block permutation, and the cleanup per
+ * range of buckets. Only the bucket boundaries and the lists of block slots
+ * to compact are computed by one thread.
+ */
+template <typename RandomAccessIterator, typename Comparator>
+class SampleSorter
+{
+public:
+    using ValueType =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DiffType =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    using Classifier = SampleSortClassifier<ValueType, Comparator>;
+    using SharedData = SampleSortSharedData<ValueType, DiffType>;
+    using LocalData = SampleSortLocalData<ValueType, DiffType, Comparator>;
+
+    //! block size, about 2 KiB of items
+    static const DiffType block_size =
+        sizeof(ValueType) < 2048 ? 2048 / sizeof(ValueType) : 1;
+
+    //! ranges up to this size are sorted with std::sort
+    static const DiffType base_case_size =
+        16 * block_size < 256 ? 256 : 16 * block_size;
+
+    SampleSorter(const Comparator& comp, size_t num_threads)
+        : comp_(comp), num_threads_(num_threads) {
+        locals_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            locals_.emplace_back(new LocalData(block_size, comp));
+            locals_.back()->rng.seed(static_cast<unsigned>(i + 1));
+        }
+    }
+
+    //! sort sequentially using the data of thread iam
+    void sort_sequential(RandomAccessIterator begin, RandomAccessIterator end,
+                         size_t iam = 0) {
+        LocalData& local = *locals_[iam];
+        local.allocate(block_size);
+        sort_sequential(begin, end, local, 0);
+    }
+
+    //! sort in parallel using the given runner, see
+    //! multiway_merge_detail::ThreadPoolRunner
+    template <typename Runner>
+    void sort_parallel(RandomAccessIterator begin, RandomAccessIterator end,
+                       const Runner& run) {
+        std::vector<std::pair<DiffType, DiffType> > tasks;
+        SharedData shared(block_size);
+        Classifier classifier(comp_);
+
+        partition_parallel(begin, 0, end - begin, classifier, shared,
+                           run, tasks);
+
+        // sort the remaining buckets sequentially, largest first
+        std::sort(tasks.begin(), tasks.end(),
+                  [](const std::pair<DiffType, DiffType>& a,
+                     const std::pair<DiffType, DiffType>& b) {
+                      return a.second - a.first > b.second - b.first;
+                  });
+
+        std::atomic<size_t> next_task(0);
+        run(num_threads_,
+            [&](size_t iam) {
+                size_t t;
+                while ((t = next_task++) < tasks.size()) {
+                    sort_sequential(begin + tasks[t].first,
+                                    begin + tasks[t].second, iam);
+                }
+            });
+    }
+
+private:
+    //! comparator
+    Comparator comp_;
+    //! number of threads
+    size_t num_threads_;
+    //! thread-local data
+    std::vector<std::unique_ptr<LocalData> > locals_;
+
+    //! recursion depth after which std::sort is used
+    static const size_t max_depth = 32;
+
+    //! choose splitters from a random sample, which is moved to the front of
+    //! the range, and build the classifier.
+    void build_classifier(RandomAccessIterator begin, DiffType n,
+                          std::minstd_rand& rng, Classifier& classifier) {
+        size_t log_buckets = std::min(
+            max_log_buckets,
+            static_cast<size_t>(
+                integer_log2_floor(
+                    static_cast<size_t>(n / (4 * block_size)) | 1)));
+        log_buckets = std::max<size_t>(log_buckets, 1);
+        size_t num_leaves = size_t(1) << log_buckets;
+
+        size_t oversampling = std::max<size_t>(
+            1, integer_log2_floor(static_cast<size_t>(n)) / 5);
+        DiffType num_samples = std::min<DiffType>(
+            n, static_cast<DiffType>(oversampling * num_leaves - 1));
+
+        for (DiffType i = 0; i < num_samples; ++i) {
+            DiffType j = i + static_cast<DiffType>(
+                rng() % static_cast<size_t>(n - i));
+            std::iter_swap(begin + i, begin + j);
+        }
+        std::sort(begin, begin + num_samples, comp_);
+
+        // pick equidistant splitters and remove duplicates
+        std::vector<ValueType> splitters;
+        bool use_equal = false;
+        for (size_t s = 1; s < num_leaves; ++s) {
+            const ValueType& v = begin[
+                static_cast<DiffType>(s) * num_samples
+                / static_cast<DiffType>(num_leaves)];
+            if (!splitters.empty() && !comp_(splitters.back(), v))
+                use_equal = true;
+            else
+                splitters.push_back(v);
+        }
+
+        classifier.build(splitters.data(), splitters.size(),
+                         log_buckets, use_equal);
+    }
+
+    //! classify the items of stripe [stripe_begin, stripe_end) into the
+    //! thread's buffers, and write back full blocks to the stripe.
+    void classify_stripe(RandomAccessIterator begin,
+                         DiffType stripe_begin, DiffType stripe_end,
+                         const Classifier& classifier, LocalData& local) {
+        size_t num_buckets = classifier.num_buckets();
+        std::fill(local.fill.begin(), local.fill.begin() + num_buckets, 0);
+        std::fill(local.counts.begin(), local.counts.begin() + num_buckets, 0);
+
+        ValueType* buffers = local.buffers.data();
+        RandomAccessIterator write = begin + stripe_begin;
+
+        classifier.classify(
+            begin + stripe_begin, begin + stripe_end,
+            [&](size_t b, RandomAccessIterator it) {
+                ValueType* buffer = buffers + b * block_size;
+                if (local.fill[b] == static_cast<size_t>(block_size)) {
+                    // full buffer: there are at least block_size items
+                    // between write and it.
+                    write = std::move(buffer, buffer + block_size, write);
+                    local.fill[b] = 0;
+                }
+                buffer[local.fill[b]++] = std::move(*it);
+                ++local.counts[b];
+            });
+
+        local.write_end = write - begin;
+    }
+
+    //! permute the full blocks into their buckets, uses the thread's two swap
+    //! blocks.
+    void permute_blocks(RandomAccessIterator begin, DiffType n,
+                        const Classifier& classifier, SharedData& shared,
+                        LocalData& local, size_t iam, size_t num_threads) {
+        size_t num_buckets = classifier.num_buckets();
+        ValueType* swap[2] = {
+            local.swap.data(), local.swap.data() + block_size
+        };
+        size_t cur = 0;
+
+        for (size_t i = 0; i < num_buckets; ++i)
+        {
+            size_t b = (iam * num_buckets / num_threads + i) % num_buckets;
+            SampleSortBucketPointers<DiffType>& bp = shared.pointers[b];
+
+            while (true)
+            {
+                {
+                    // take an unprocessed block, it is read under the lock
+                    // such that no other thread writes into it.
+                    std::unique_lock<std::mutex> lock(bp.mutex);
+                    if (bp.read < bp.write) break;
+                    RandomAccessIterator block = begin + bp.read * block_size;
+                    std::move(block, block + block_size, swap[cur]);
+                    --bp.read;
+                }
+
+                while (true)
+                {
+                    size_t dest = classifier.classify(swap[cur][0]);
+                    SampleSortBucketPointers<DiffType>& dp =
+                        shared.pointers[dest];
+
+                    DiffType slot;
+                    bool full;
+                    {
+                        std::unique_lock<std::mutex> lock(dp.mutex);
+                        slot = dp.write++;
+                        full = (slot <= dp.read);
+                    }
+
+                    RandomAccessIterator block = begin + slot * block_size;
+                    if (full) {
+                        // swap with the unprocessed block in the slot
+                        std::move(block, block + block_size, swap[1 - cur]);
+                        std::move(swap[cur], swap[cur] + block_size, block);
+                        cur = 1 - cur;
+                        continue;
+                    }
+
+                    if ((slot + 1) * block_size > n) {
+                        // the slot extends past the end of the input
+                        std::move(swap[cur], swap[cur] + block_size,
+                                  shared.overflow.data());
+                        shared.overflow_bucket = dest;
+                    }
+                    else {
+                        std::move(swap[cur], swap[cur] + block_size, block);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    /*!
+     * Partition [begin, begin + n) into the buckets of the classifier using
+     * num_threads jobs of run. Returns the bucket boundaries in bucket_start,
+     * which must have num_buckets + 1 entries.
+     */
+    template <typename Runner>
+    void partition(RandomAccessIterator begin, DiffType n,
+                   const Classifier& classifier, SharedData& shared,
+                   LocalData** locals, size_t num_threads, const Runner& run,
+                   DiffType* bucket_start) {
+        size_t num_buckets = classifier.num_buckets();
+
+        // block-aligned stripes of the threads
+        simple_vector<DiffType> stripes(num_threads + 1);
+        for (size_t i = 0; i < num_threads; ++i) {
+            stripes[i] = n * static_cast<DiffType>(i)
+                         / static_cast<DiffType>(num_threads)
+                         / block_size * block_size;
+        }
+        stripes[num_threads] = n;
+
+        run(num_threads,
+            [&](size_t iam) {
+                locals[iam]->allocate(block_size);
+                classify_stripe(begin, stripes[iam], stripes[iam + 1],
+                                classifier, *locals[iam]);
+            });
+
+        // calculate bucket boundaries
+        bucket_start[0] = 0;
+        for (size_t b = 0; b < num_buckets; ++b) {
+            DiffType count = 0;
+            for (size_t i = 0; i < num_threads; ++i)
+                count += locals[i]->counts[b];
+            bucket_start[b + 1] = bucket_start[b] + count;
+        }
+
+        // move full blocks to the front: fill the empty blocks in
+        // [0, num_full) with full blocks from behind num_full.
+        DiffType num_full = 0;
+        for (size_t i = 0; i < num_threads; ++i)
+            num_full += (locals[i]->write_end - stripes[i]) / block_size;
+
+        {
+            std::vector<DiffType> empty_slots, full_slots;
+            for (size_t i = 0; i < num_threads; ++i) {
+                DiffType write_end = locals[i]->write_end / block_size;
+                for (DiffType s = write_end;
+                     s < std::min(stripes[i + 1] / block_size, num_full); ++s)
+                    empty_slots.push_back(s);
+                for (DiffType s = std::max(stripes[i] / block_size, num_full);
+                     s < write_end; ++s)
+                    full_slots.push_back(s);
+            }
+
+            // the empty and full slots are disjoint, move blocks in parallel
+            run(num_threads,
+                [&](size_t iam) {
+                    size_t lo = empty_slots.size() * iam / num_threads;
+                    size_t hi = empty_slots.size() * (iam + 1) / num_threads;
+                    for (size_t i = lo; i < hi; ++i) {
+                        RandomAccessIterator from =
+                            begin + full_slots[i] * block_size;
+                        std::move(from, from + block_size,
+                                  begin + empty_slots[i] * block_size);
+                    }
+                });
+        }
+
+        // initialize bucket pointers: each bucket's block-aligned area
+        // contains unprocessed full blocks before num_full.
+        for (size_t b = 0; b < num_buckets; ++b) {
+            DiffType area_begin =
+                (bucket_start[b] + block_size - 1) / block_size;
+            DiffType area_end =
+                (bucket_start[b + 1] + block_size - 1) / block_size;
+            shared.pointers[b].write = area_begin;
+            shared.pointers[b].read = std::min(area_end, num_full) - 1;
+        }
+        shared.overflow_bucket = max_buckets;
+
+        run(num_threads,
+            [&](size_t iam) {
+                permute_blocks(begin, n, classifier, shared, *locals[iam],
+                               iam, num_threads);
+            });
+
+        // cleanup of contiguous bucket ranges by the threads. The last full
+        // block of a bucket may stick into the following buckets, which are
+        // possibly cleaned up by the next thread. Hence, range boundaries are
+        // put into distinct blocks, and the items from each boundary to the
+        // end of its block are saved in the swap buffer of the thread
+        // before, which reads them from there.
+        simple_vector<size_t> ranges(num_threads + 1);
+        ranges[0] = 0;
+        for (size_t i = 1; i < num_threads; ++i) {
+            DiffType target = n * static_cast<DiffType>(i)
+                              / static_cast<DiffType>(num_threads);
+            ranges[i] = static_cast<size_t>(
+                std::lower_bound(bucket_start, bucket_start + num_buckets,
+                                 target) - bucket_start);
+            DiffType prev = bucket_start[ranges[i - 1]];
+            if (bucket_start[ranges[i]] <
+                (prev + block_size - 1) / block_size * block_size)
+                ranges[i] = ranges[i - 1];
+        }
+        ranges[num_threads] = num_buckets;
+
+        for (size_t i = 0; i + 1 < num_threads; ++i) {
+            if (ranges[i] == ranges[i + 1]) continue;
+            DiffType margin = bucket_start[ranges[i + 1]];
+            DiffType margin_end = std::min(
+                (margin + block_size - 1) / block_size * block_size, n);
+            std::move(begin + margin, begin + margin_end,
+                      locals[i]->swap.data());
+        }
+
+        run(num_threads,
+            [&](size_t iam) {
+                cleanup_buckets(begin, shared, locals, num_threads,
+                                bucket_start, ranges[iam], ranges[iam + 1],
+                                locals[iam]->swap.data());
+            });
+    }
+
+    /*!
+     * Cleanup of buckets [b_begin, b_end): move the partial blocks in the
+     * buffers, the part of the last block sticking into the next bucket, and
+     * the overflow block to the gaps at the beginning and end of each bucket.
+     * Items at or after bucket_start[b_end] are read from margin.
+     */
+    void cleanup_buckets(RandomAccessIterator begin, SharedData& shared,
+                         LocalData** locals, size_t num_threads,
+                         const DiffType* bucket_start,
+                         size_t b_begin, size_t b_end, ValueType* margin) {
+        const DiffType margin_begin = bucket_start[b_end];
+
+        for (size_t b = b_begin; b < b_end; ++b)
+        {
+            DiffType bucket_end = bucket_start[b + 1];
+            DiffType written_begin =
+                (bucket_start[b] + block_size - 1) / block_size * block_size;
+            DiffType written_end = shared.pointers[b].write * block_size;
+            if (b == shared.overflow_bucket)
+                written_end -= block_size;
+
+            // gaps [bucket_start[b], hole1) and [hole2, bucket_end)
+            RandomAccessIterator out = begin + bucket_start[b];
+            RandomAccessIterator hole1 =
+                begin + std::min(written_begin, bucket_end);
+            RandomAccessIterator hole2 =
+                begin + std::min(written_end, bucket_end);
+
+            auto put = [&](ValueType& v) {
+                           if (out == hole1) out = hole2;
+                           *out++ = std::move(v);
+                       };
+
+            for (DiffType i = std::max(bucket_end, written_begin);
+                 i < written_end; ++i) {
+                if (i < margin_begin)
+                    put(begin[i]);
+                else
+                    put(margin[i - margin_begin]);
+            }
+
+            if (b == shared.overflow_bucket) {
+                for (DiffType i = 0; i < block_size; ++i)
+                    put(shared.overflow[i]);
+            }
+
+            for (size_t t = 0; t < num_threads; ++t) {
+                ValueType* buffer = locals[t]->buffers.data() + b * block_size;
+                for (size_t i = 0; i < locals[t]->fill[b]; ++i)
+                    put(buffer[i]);
+            }
+        }
+    }
+
+    //! recursive sequential samplesort
+    void sort_sequential(RandomAccessIterator begin, RandomAccessIterator end,
+                         LocalData& local, size_t depth) {
+        DiffType n = end - begin;
+
+        if (n <= base_case_size || depth >= max_depth) {
+            std::sort(begin, end, comp_);
+            return;
+        }
+
+        build_classifier(begin, n, local.rng, local.classifier);
+
+        size_t num_buckets = local.classifier.num_buckets();
+        simple_vector<DiffType> bucket_start(num_buckets + 1);
+        LocalData* locals[1] = { &local };
+        partition(begin, n, local.classifier, local.shared, locals, 1,
+                  SequentialRunner(), bucket_start.data());
+
+        // the classifier is rebuilt in the recursion
+        bool use_equal = local.classifier.use_equal();
+
+        for (size_t b = 0; b < num_buckets; ++b)
+        {
+            if (use_equal && b % 2 == 1) continue;
+            DiffType size = bucket_start[b + 1] - bucket_start[b];
+            if (size <= 1) continue;
+            if (size == n) {
+                // no progress, e.g. due to many equal items
+                std::sort(begin, end, comp_);
+                return;
+            }
+            sort_sequential(begin + bucket_start[b],
+                            begin + bucket_start[b + 1], local, depth + 1);
+        }
+    }
+
+    //! recursive parallel partitioning of [first, last) relative to begin.
+    //! Buckets which are small enough for one thread are added to tasks.
+    template <typename Runner>
+    void partition_parallel(
+        RandomAccessIterator begin, DiffType first, DiffType last,
+        Classifier& classifier, SharedData& shared, const Runner& run,
+        std::vector<std::pair<DiffType, DiffType> >& tasks) {
+        DiffType n = last - first;
+
+        if (n <= static_cast<DiffType>(num_threads_) * base_case_size) {
+            tasks.emplace_back(first, last);
+            return;
+        }
+
+        build_classifier(begin + first, n, locals_[0]->rng, classifier);
+
+        size_t num_buckets = classifier.num_buckets();
+        simple_vector<DiffType> bucket_start(num_buckets + 1);
+        simple_vector<LocalData*> locals(num_threads_);
+        for (size_t i = 0; i < num_threads_; ++i)
+            locals[i] = locals_[i].get();
+
+        partition(begin + first, n, classifier, shared, locals.data(),
+                  num_threads_, run, bucket_start.data());
+
+        bool use_equal = classifier.use_equal();
+
+        for (size_t b = 0; b < num_buckets; ++b)
+        {
+            if (use_equal && b % 2 == 1) continue;
+            DiffType size = bucket_start[b + 1] - bucket_start[b];
+            if (size <= 1) continue;
+
+            DiffType sub_first = first + bucket_start[b];
+            DiffType sub_last = first + bucket_start[b + 1];
+
+            if (size == n || size <= n / static_cast<DiffType>(num_threads_)) {
+                tasks.emplace_back(sub_first, sub_last);
+            }
+            else {
+                partition_parallel(begin, sub_first, sub_last,
+                                   classifier, shared, run, tasks);
+            }
+        }
+    }
+};
+
+} // namespace parallel_samplesort_detail
+
+/*!
+ * In-place super scalar samplesort. Sorts [begin, end) with the comparator,
+ * using only a few blocks of extra memory per bucket. This is not a stable
+ * sort. The value type must be default-constructible.
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param comp Comparator.
+ */
+template <typename RandomAccessIterator,
+          typename Comparator = std::less<
+              typename std::iterator_traits<RandomAccessIterator>::value_type> >
+void samplesort(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator comp = Comparator()) {
+
+    parallel_samplesort_detail::SampleSorter<RandomAccessIterator, Comparator>
+    sorter(comp, 1);
+    sorter.sort_sequential(begin, end);
+}
+
+/*!
+ * In-place parallel super scalar samplesort, running on a ThreadPool. Large
+ * ranges are partitioned by all threads together, then the buckets are sorted
+ * by the threads independently, see samplesort(). The pool may be shared, but
+ * the function must not be called from within one of its jobs.
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param comp Comparator.
+ * \param pool ThreadPool to run the sort on.
+ */
+template <typename RandomAccessIterator, typename Comparator>
+void parallel_samplesort(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator comp,
+    ThreadPool& pool) {
+
+    size_t num_threads = std::max<size_t>(pool.size(), 1);
+
+    parallel_samplesort_detail::SampleSorter<RandomAccessIterator, Comparator>
+    sorter(comp, num_threads);
+
+    if (num_threads == 1)
+        sorter.sort_sequential(begin, end);
+    else
+        sorter.sort_parallel(
+            begin, end, multiway_merge_detail::ThreadPoolRunner { pool });
+}
+
+/*!
+ * In-place parallel super scalar samplesort, see the ThreadPool variant. This
+ * variant creates a ThreadPool of num_threads threads.
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param comp Comparator.
+ * \param num_threads Number of threads to use.
+ */
+template <typename RandomAccessIterator,
+          typename Comparator = std::less<
+              typename std::iterator_traits<RandomAccessIterator>::value_type> >
+void parallel_samplesort(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    Comparator comp = Comparator(),
+    size_t num_threads = std::thread::hardware_concurrency()) {
+
+    if (num_threads <= 1)
+        return samplesort(begin, end, comp);
+
+    ThreadPool pool(num_threads);
+    parallel_samplesort(begin, end, comp, pool);
+}
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_SORT_PARALLEL_SAMPLESORT_HEADER
+
+/******************************************************************************/
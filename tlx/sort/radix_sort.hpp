@@ -0,0 +1,553 @@
+/*******************************************************************************
+ * tlx/sort/radix_sort.hpp
+ *
+ * (Parallel) MSD radix sort for integer and floating-point keys.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_SORT_RADIX_SORT_HEADER
+#define TLX_SORT_RADIX_SORT_HEADER
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <tlx/algorithm/parallel_multiway_merge.hpp>
+#include <tlx/meta/enable_if.hpp>
+#include <tlx/simple_vector.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_sort
+//! \{
+
+namespace radix_sort_detail {
+
+/*!
+ * Order-preserving conversion of keys to unsigned integers: unsigned keys are
+ * used as is, the sign bit of signed keys is flipped, and negative
+ * floating-point numbers have all bits flipped, positive ones only the sign.
+ */
+template <typename Key, bool Float = std::is_floating_point<Key>::value>
+struct RadixKeyTraits {
+    static_assert(std::is_integral<Key>::value,
+                  "radix sort keys must be integral or floating-point");
+
+    using type = typename std::make_unsigned<Key>::type;
+
+    static type encode(const Key& key) {
+        const int top = std::numeric_limits<type>::digits - 1;
+        const type flip = std::is_signed<Key>::value
+                          ? static_cast<type>(type(1) << top) : type(0);
+        return static_cast<type>(static_cast<type>(key) ^ flip);
+    }
+};
+
+template <typename Key>
+struct RadixKeyTraits<Key, true> {
+    static_assert(sizeof(Key) == 4 || sizeof(Key) == 8,
+                  "radix sort supports only float and double");
+
+    using type = typename std::conditional<
+        sizeof(Key) == 4, uint32_t, uint64_t>::type;
+
+    static type encode(const Key& key) {
+        type bits;
+        std::memcpy(&bits, &key, sizeof(bits));
+        const type sign = type(1) << (std::numeric_limits<type>::digits - 1);
+        return (bits & sign) ? static_cast<type>(~bits) : (bits | sign);
+    }
+};
+
+//! key extractor returning the item itself
+struct RadixIdentity {
+    template <typename Type>
+    const Type& operator () (const Type& item) const { return item; }
+};
+
+//! key extractor returning the first component of a pair
+struct RadixPairFirst {
+    template <typename Pair>
+    const typename Pair::first_type& operator () (const Pair& p) const {
+        return p.first;
+    }
+};
+
+//! Storage of items in a random access sequence, or in the buffer
+template <typename Iterator, typename KeyExtractor, bool IsBuffer = false>
+struct RadixItemStorage {
+    using Item = typename std::iterator_traits<Iterator>::value_type;
+    using Key = typename std::decay<
+        decltype(std::declval<KeyExtractor>()(std::declval<Item>()))>::type;
+
+    Iterator items;
+    KeyExtractor key_extractor;
+
+    typename RadixKeyTraits<Key>::type key(size_t i) const {
+        return RadixKeyTraits<Key>::encode(key_extractor(items[i]));
+    }
+    Item take(size_t i) { return std::move(items[i]); }
+    void put(size_t i, Item&& item) { items[i] = std::move(item); }
+};
+
+//! Storage of keys and values in two sequences, items are pairs
+template <typename KeyIterator, typename ValueIterator>
+struct RadixKeyValueStorage {
+    using Key = typename std::iterator_traits<KeyIterator>::value_type;
+    using Value = typename std::iterator_traits<ValueIterator>::value_type;
+    using Item = std::pair<Key, Value>;
+
+    KeyIterator keys;
+    ValueIterator values;
+
+    typename RadixKeyTraits<Key>::type key(size_t i) const {
+        return RadixKeyTraits<Key>::encode(keys[i]);
+    }
+    Item take(size_t i) {
+        return Item(std::move(keys[i]), std::move(values[i]));
+    }
+    void put(size_t i, Item&& item) {
+        keys[i] = std::move(item.first);
+        values[i] = std::move(item.second);
+    }
+};
+
+/*!
+ * MSD radix sort with 8-bit digits. Each pass distributes the items from one
+ * storage to the other, the input storage and a buffer of items, skipping
+ * digits which are equal for all items. Scattering uses small software
+ * write-combining buffers per bucket. Buckets of at most small_size items are
+ * sorted with std::sort.
+ *
+ * In parallel, large ranges are distributed by all threads using per-thread
+ * histograms of their stripes, and the remaining buckets are sorted
+ * sequentially by the threads, which take them from a shared list.
+ */
+template <typename Storage, typename BufferKeyExtractor>
+class RadixSorter
+{
+public:
+    using Item = typename Storage::Item;
+    using Buffer = RadixItemStorage<Item*, BufferKeyExtractor, true>;
+    using KeyType = decltype(std::declval<Storage>().key(0));
+
+    //! number of bits per digit
+    static const size_t digit_bits = 8;
+    //! number of buckets per pass
+    static const size_t num_buckets = size_t(1) << digit_bits;
+    //! number of digits of the keys
+    static const size_t num_digits = sizeof(KeyType);
+
+    //! bucket size up to which std::sort is used
+    static const size_t small_size = 256;
+
+    //! items in a write-combining buffer, about a cache line
+    static const size_t wc_size = sizeof(Item) < 64 ? 64 / sizeof(Item) : 1;
+
+    RadixSorter(const Storage& storage,
+                const BufferKeyExtractor& buffer_key_extractor,
+                size_t n, size_t num_threads)
+        : input_(storage), buffer_items_(n),
+          buffer_(Buffer { buffer_items_.data(), buffer_key_extractor }),
+          locals_(num_threads) { }
+
+    //! sort sequentially
+    void sort(size_t n) {
+        sort_sequential(input_, buffer_, 0, n, num_digits, locals_[0]);
+    }
+
+    //! sort in parallel with the runner, see multiway_merge_detail
+    template <typename Runner>
+    void sort_parallel(size_t n, const Runner& run) {
+        std::vector<Task> tasks;
+        partition_parallel(input_, buffer_, 0, n, num_digits, run, tasks);
+
+        // largest tasks first
+        std::sort(tasks.begin(), tasks.end(),
+                  [](const Task& a, const Task& b) {
+                      return a.end - a.begin > b.end - b.begin;
+                  });
+
+        std::atomic<size_t> next_task(0);
+        run(locals_.size(),
+            [&](size_t iam) {
+                size_t t;
+                while ((t = next_task++) < tasks.size()) {
+                    const Task& task = tasks[t];
+                    if (task.in_buffer)
+                        sort_sequential(buffer_, input_, task.begin, task.end,
+                                        task.digits, locals_[iam]);
+                    else
+                        sort_sequential(input_, buffer_, task.begin, task.end,
+                                        task.digits, locals_[iam]);
+                }
+            });
+    }
+
+private:
+    //! per-thread histogram, write positions, and write-combining buffers
+    struct LocalData {
+        size_t histogram[num_buckets];
+        size_t position[num_buckets];
+        size_t fill[num_buckets];
+        simple_vector<Item> wc;
+    };
+
+    //! range remaining to be sorted sequentially
+    struct Task {
+        size_t begin, end, digits;
+        bool in_buffer;
+    };
+
+    //! input sequence
+    Storage input_;
+    //! buffer of n items
+    simple_vector<Item> buffer_items_;
+    Buffer buffer_;
+    //! thread-local data
+    simple_vector<LocalData> locals_;
+
+    //! extract digit number d, counted from the least significant
+    static size_t digit(KeyType key, size_t d) {
+        return static_cast<size_t>(key >> (d * digit_bits))
+               & (num_buckets - 1);
+    }
+
+    //! count the digits of the items in [begin, end)
+    template <typename Source>
+    static void count(const Source& src, size_t begin, size_t end,
+                      size_t d, LocalData& local) {
+        std::fill(local.histogram, local.histogram + num_buckets, 0);
+        for (size_t i = begin; i < end; ++i)
+            ++local.histogram[digit(src.key(i), d)];
+    }
+
+    //! distribute [begin, end) of src to dst at local.position, which is
+    //! advanced.
+    template <typename Source, typename Target>
+    static void scatter(Source& src, Target& dst, size_t begin, size_t end,
+                        size_t d, LocalData& local) {
+        if (local.wc.size() == 0)
+            local.wc.resize(num_buckets * wc_size);
+
+        std::fill(local.fill, local.fill + num_buckets, 0);
+        Item* wc = local.wc.data();
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            size_t b = digit(src.key(i), d);
+            Item* buf = wc + b * wc_size;
+            buf[local.fill[b]++] = src.take(i);
+
+            if (local.fill[b] == wc_size) {
+                size_t pos = local.position[b];
+                for (size_t j = 0; j < wc_size; ++j)
+                    dst.put(pos + j, std::move(buf[j]));
+                local.position[b] += wc_size;
+                local.fill[b] = 0;
+            }
+        }
+
+        for (size_t b = 0; b < num_buckets; ++b) {
+            Item* buf = wc + b * wc_size;
+            for (size_t j = 0; j < local.fill[b]; ++j)
+                dst.put(local.position[b]++, std::move(buf[j]));
+        }
+    }
+
+    //! sort small range with std::sort in the buffer, and put it into the
+    //! input.
+    void sort_small(Storage& src, Buffer& buf, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            buf.put(i, src.take(i));
+        sort_small(buf, src, begin, end);
+    }
+
+    void sort_small(Buffer& buf, Storage& dst, size_t begin, size_t end) {
+        const BufferKeyExtractor& key_extractor = buf.key_extractor;
+        std::sort(buf.items + begin, buf.items + end,
+                  [&](const Item& a, const Item& b) {
+                      return encode(key_extractor(a)) <
+                      encode(key_extractor(b));
+                  });
+        for (size_t i = begin; i < end; ++i)
+            dst.put(i, buf.take(i));
+    }
+
+    //! move a range from the buffer to the input, or do nothing
+    void finish(Storage&, Buffer&, size_t, size_t) { }
+
+    void finish(Buffer& buf, Storage& dst, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            dst.put(i, buf.take(i));
+    }
+
+    template <typename Key>
+    static KeyType encode(const Key& key) {
+        return RadixKeyTraits<Key>::encode(key);
+    }
+
+    //! recursive sequential MSD radix sort of [begin, end) in src, the
+    //! result is placed in the input storage.
+    template <typename Source, typename Target>
+    void sort_sequential(Source& src, Target& dst, size_t begin, size_t end,
+                         size_t digits, LocalData& local) {
+        while (true)
+        {
+            if (digits == 0)
+                return finish(src, dst, begin, end);
+            if (end - begin <= small_size)
+                return sort_small(src, dst, begin, end);
+
+            size_t d = --digits;
+            count(src, begin, end, d, local);
+
+            // skip digits which are equal for all items
+            if (local.histogram[digit(src.key(begin), d)] == end - begin)
+                continue;
+
+            size_t bkt_begin[num_buckets + 1];
+            bkt_begin[0] = begin;
+            for (size_t b = 0; b < num_buckets; ++b) {
+                local.position[b] = bkt_begin[b];
+                bkt_begin[b + 1] = bkt_begin[b] + local.histogram[b];
+            }
+
+            scatter(src, dst, begin, end, d, local);
+
+            for (size_t b = 0; b < num_buckets; ++b) {
+                if (bkt_begin[b] == bkt_begin[b + 1]) continue;
+                sort_sequential(dst, src, bkt_begin[b], bkt_begin[b + 1],
+                                digits, local);
+            }
+            return;
+        }
+    }
+
+    //! recursive parallel distribution of [begin, end) in src. Buckets which
+    //! are small enough for one thread are added to tasks.
+    template <typename Source, typename Target, typename Runner>
+    void partition_parallel(Source& src, Target& dst, size_t begin,
+                            size_t end, size_t digits, const Runner& run,
+                            std::vector<Task>& tasks) {
+        size_t num_threads = locals_.size();
+        size_t n = end - begin;
+
+        while (digits != 0 && n > num_threads * 4096)
+        {
+            size_t d = --digits;
+
+            simple_vector<size_t> stripes(num_threads + 1);
+            for (size_t t = 0; t <= num_threads; ++t)
+                stripes[t] = begin + n * t / num_threads;
+
+            run(num_threads,
+                [&](size_t iam) {
+                    count(src, stripes[iam], stripes[iam + 1], d,
+                          locals_[iam]);
+                });
+
+            // calculate bucket boundaries and write positions of the threads
+            size_t bkt_begin[num_buckets + 1];
+            bkt_begin[0] = begin;
+            for (size_t b = 0; b < num_buckets; ++b) {
+                size_t pos = bkt_begin[b];
+                for (size_t t = 0; t < num_threads; ++t) {
+                    locals_[t].position[b] = pos;
+                    pos += locals_[t].histogram[b];
+                }
+                bkt_begin[b + 1] = pos;
+            }
+
+            // skip digits which are equal for all items
+            bool skip = false;
+            for (size_t b = 0; b < num_buckets; ++b)
+                skip |= (bkt_begin[b + 1] - bkt_begin[b] == n);
+            if (skip)
+                continue;
+
+            run(num_threads,
+                [&](size_t iam) {
+                    scatter(src, dst, stripes[iam], stripes[iam + 1], d,
+                            locals_[iam]);
+                });
+
+            for (size_t b = 0; b < num_buckets; ++b)
+            {
+                size_t size = bkt_begin[b + 1] - bkt_begin[b];
+                if (size == 0) continue;
+
+                if (size > n / num_threads) {
+                    partition_parallel(dst, src, bkt_begin[b], bkt_begin[b + 1],
+                                       digits, run, tasks);
+                }
+                else {
+                    tasks.push_back(
+                        Task { bkt_begin[b], bkt_begin[b + 1], digits,
+                               std::is_same<Target, Buffer>::value });
+                }
+            }
+            return;
+        }
+
+        tasks.push_back(
+            Task { begin, end, digits, std::is_same<Source, Buffer>::value });
+    }
+};
+
+//! run the radix sorter either sequentially or with num_threads threads
+template <typename Storage, typename BufferKeyExtractor>
+void radix_sort_run(const Storage& storage,
+                    const BufferKeyExtractor& buffer_key_extractor,
+                    size_t n, size_t num_threads) {
+    if (n <= 1)
+        return;
+
+    if (num_threads == 0)
+        num_threads = 1;
+
+    RadixSorter<Storage, BufferKeyExtractor> sorter(
+        storage, buffer_key_extractor, n, num_threads);
+
+    if (num_threads == 1)
+        sorter.sort(n);
+    else
+        sorter.sort_parallel(n, multiway_merge_detail::ThreadRunner());
+}
+
+} // namespace radix_sort_detail
+
+/*!
+ * MSD radix sort of a sequence of unsigned, signed, or floating-point keys, or
+ * items with such keys returned by a key extractor. Uses a buffer of the same
+ * size as the input. This is not a stable sort, and items need to be
+ * default-constructible.
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param key_extractor Functor returning the key of an item.
+ */
+template <typename RandomAccessIterator,
+          typename KeyExtractor = radix_sort_detail::RadixIdentity>
+void radix_sort(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    KeyExtractor key_extractor = KeyExtractor()) {
+
+    using Storage = radix_sort_detail::RadixItemStorage<
+        RandomAccessIterator, KeyExtractor>;
+
+    radix_sort_detail::radix_sort_run(
+        Storage { begin, key_extractor }, key_extractor,
+        static_cast<size_t>(end - begin), 1);
+}
+
+/*!
+ * Parallel MSD radix sort, see radix_sort(). Implemented either using OpenMP
+ * or with std::threads, depending on if compiled with -fopenmp or not.
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param key_extractor Functor returning the key of an item.
+ * \param num_threads Number of threads to use.
+ */
+template <typename RandomAccessIterator,
+          typename KeyExtractor = radix_sort_detail::RadixIdentity>
+typename enable_if<!std::is_integral<KeyExtractor>::value, void>::type
+parallel_radix_sort(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    KeyExtractor key_extractor = KeyExtractor(),
+    size_t num_threads = std::thread::hardware_concurrency()) {
+
+    using Storage = radix_sort_detail::RadixItemStorage<
+        RandomAccessIterator, KeyExtractor>;
+
+    radix_sort_detail::radix_sort_run(
+        Storage { begin, key_extractor }, key_extractor,
+        static_cast<size_t>(end - begin), num_threads);
+}
+
+/*!
+ * Parallel MSD radix sort of a sequence of keys, see radix_sort().
+ *
+ * \param begin Begin iterator of sequence.
+ * \param end End iterator of sequence.
+ * \param num_threads Number of threads to use.
+ */
+template <typename RandomAccessIterator>
+void parallel_radix_sort(
+    RandomAccessIterator begin,
+    RandomAccessIterator end,
+    size_t num_threads) {
+    parallel_radix_sort(begin, end, radix_sort_detail::RadixIdentity(),
+                        num_threads);
+}
+
+/*!
+ * MSD radix sort of a sequence of keys, where the values sequence is permuted
+ * in the same way, see radix_sort().
+ *
+ * \param keys_begin Begin iterator of keys sequence.
+ * \param keys_end End iterator of keys sequence.
+ * \param values_begin Begin iterator of values sequence.
+ */
+template <typename KeyIterator, typename ValueIterator>
+void radix_sort_key_value(
+    KeyIterator keys_begin,
+    KeyIterator keys_end,
+    ValueIterator values_begin) {
+
+    using Storage = radix_sort_detail::RadixKeyValueStorage<
+        KeyIterator, ValueIterator>;
+
+    radix_sort_detail::radix_sort_run(
+        Storage { keys_begin, values_begin },
+        radix_sort_detail::RadixPairFirst(),
+        static_cast<size_t>(keys_end - keys_begin), 1);
+}
+
+/*!
+ * Parallel MSD radix sort of a sequence of keys, where the values sequence is
+ * permuted in the same way, see parallel_radix_sort().
+ *
+ * \param keys_begin Begin iterator of keys sequence.
+ * \param keys_end End iterator of keys sequence.
+ * \param values_begin Begin iterator of values sequence.
+ * \param num_threads Number of threads to use.
+ */
+template <typename KeyIterator, typename ValueIterator>
+void parallel_radix_sort_key_value(
+    KeyIterator keys_begin,
+    KeyIterator keys_end,
+    ValueIterator values_begin,
+    size_t num_threads = std::thread::hardware_concurrency()) {
+
+    using Storage = radix_sort_detail::RadixKeyValueStorage<
+        KeyIterator, ValueIterator>;
+
+    radix_sort_detail::radix_sort_run(
+        Storage { keys_begin, values_begin },
+        radix_sort_detail::RadixPairFirst(),
+        static_cast<size_t>(keys_end - keys_begin), num_threads);
+}
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_SORT_RADIX_SORT_HEADER
+
+/******************************************************************************/
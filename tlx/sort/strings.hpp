@@ -14,6 +14,7 @@
 #define TLX_SORT_STRINGS_HEADER
 
 #include <tlx/sort/strings/insertion_sort.hpp>
+#include <tlx/sort/strings/lcp_loser_tree.hpp>
 #include <tlx/sort/strings/multikey_quicksort.hpp>
 #include <tlx/sort/strings/radix_sort.hpp>
 
@@ -311,6 +312,111 @@ void sort_strings_lcp(std::vector<std::string>& strings, uint32_t* lcp,
     return sort_strings_lcp(strings.data(), strings.size(), lcp, memory);
 }
 
+/******************************************************************************/
+/******************************************************************************/
+/******************************************************************************/
+
+/*!
+ * Merge sorted runs of strings represented by C-style uint8_t* with their LCP
+ * arrays, e.g. sorted by sort_strings_lcp(), into out and out_lcp.
+ *
+ * The runs are stored consecutively in strings and lcp: run i occupies the
+ * positions [run_bounds[i], run_bounds[i + 1]) for i < num_runs. The first LCP
+ * of each run is ignored. out and out_lcp must hold all strings of the runs,
+ * and out_lcp[0] is set to zero. Equal strings are output in the order of
+ * their runs. Returns the number of strings merged.
+ */
+static inline
+size_t merge_strings_lcp(unsigned char** strings, uint32_t* lcp,
+                         const size_t* run_bounds, size_t num_runs,
+                         unsigned char** out, uint32_t* out_lcp) {
+    return sort_strings_detail::lcp_multiway_merge_runs<
+        sort_strings_detail::UCharStringSet>(
+        strings, lcp, run_bounds, num_runs, out, out_lcp);
+}
+
+/*!
+ * Merge sorted runs of strings represented by C-style char* with their LCP
+ * arrays, e.g. sorted by sort_strings_lcp(), into out and out_lcp.
+ *
+ * The runs are stored consecutively in strings and lcp: run i occupies the
+ * positions [run_bounds[i], run_bounds[i + 1]) for i < num_runs. The first LCP
+ * of each run is ignored. out and out_lcp must hold all strings of the runs,
+ * and out_lcp[0] is set to zero. Equal strings are output in the order of
+ * their runs. The strings are compared as _unsigned_ 8-bit characters. Returns
+ * the number of strings merged.
+ */
+static inline
+size_t merge_strings_lcp(char** strings, uint32_t* lcp,
+                         const size_t* run_bounds, size_t num_runs,
+                         char** out, uint32_t* out_lcp) {
+    return merge_strings_lcp(
+        reinterpret_cast<unsigned char**>(strings), lcp, run_bounds, num_runs,
+        reinterpret_cast<unsigned char**>(out), out_lcp);
+}
+
+/*!
+ * Merge sorted runs of strings represented by C-style uint8_t* with their LCP
+ * arrays, e.g. sorted by sort_strings_lcp(), into out and out_lcp.
+ *
+ * The runs are stored consecutively in strings and lcp: run i occupies the
+ * positions [run_bounds[i], run_bounds[i + 1]) for i < num_runs. The first LCP
+ * of each run is ignored. out and out_lcp must hold all strings of the runs,
+ * and out_lcp[0] is set to zero. Equal strings are output in the order of
+ * their runs. Returns the number of strings merged.
+ */
+static inline
+size_t merge_strings_lcp(const unsigned char** strings, uint32_t* lcp,
+                         const size_t* run_bounds, size_t num_runs,
+                         const unsigned char** out, uint32_t* out_lcp) {
+    return sort_strings_detail::lcp_multiway_merge_runs<
+        sort_strings_detail::CUCharStringSet>(
+        strings, lcp, run_bounds, num_runs, out, out_lcp);
+}
+
+/*!
+ * Merge sorted runs of strings represented by C-style char* with their LCP
+ * arrays, e.g. sorted by sort_strings_lcp(), into out and out_lcp.
+ *
+ * The runs are stored consecutively in strings and lcp: run i occupies the
+ * positions [run_bounds[i], run_bounds[i + 1]) for i < num_runs. The first LCP
+ * of each run is ignored. out and out_lcp must hold all strings of the runs,
+ * and out_lcp[0] is set to zero. Equal strings are output in the order of
+ * their runs. The strings are compared as _unsigned_ 8-bit characters. Returns
+ * the number of strings merged.
+ */
+static inline
+size_t merge_strings_lcp(const char** strings, uint32_t* lcp,
+                         const size_t* run_bounds, size_t num_runs,
+                         const char** out, uint32_t* out_lcp) {
+    return merge_strings_lcp(
+        reinterpret_cast<const unsigned char**>(strings), lcp,
+        run_bounds, num_runs,
+        reinterpret_cast<const unsigned char**>(out), out_lcp);
+}
+
+/******************************************************************************/
+
+/*!
+ * Merge sorted runs of std::strings with their LCP arrays, e.g. sorted by
+ * sort_strings_lcp(), into out and out_lcp. The strings are moved.
+ *
+ * The runs are stored consecutively in strings and lcp: run i occupies the
+ * positions [run_bounds[i], run_bounds[i + 1]) for i < num_runs. The first LCP
+ * of each run is ignored. out and out_lcp must hold all strings of the runs,
+ * and out_lcp[0] is set to zero. Equal strings are output in the order of
+ * their runs. The strings are compared as _unsigned_ 8-bit characters. Returns
+ * the number of strings merged.
+ */
+static inline
+size_t merge_strings_lcp(std::string* strings, uint32_t* lcp,
+                         const size_t* run_bounds, size_t num_runs,
+                         std::string* out, uint32_t* out_lcp) {
+    return sort_strings_detail::lcp_multiway_merge_runs<
+        sort_strings_detail::StdStringSet>(
+        strings, lcp, run_bounds, num_runs, out, out_lcp);
+}
+
 /******************************************************************************/
 
 //! \}
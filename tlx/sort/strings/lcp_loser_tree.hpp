@@ -0,0 +1,246 @@
+/*******************************************************************************
+ * tlx/sort/strings/lcp_loser_tree.hpp
+ *
+ * LCP-aware loser tree for merging sorted string runs with their LCP arrays.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2020 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_SORT_STRINGS_LCP_LOSER_TREE_HEADER
+#define TLX_SORT_STRINGS_LCP_LOSER_TREE_HEADER
+
+#include <tlx/math/round_to_power_of_two.hpp>
+#include <tlx/sort/strings/string_ptr.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace tlx {
+
+//! \addtogroup tlx_sort
+//! \{
+
+namespace sort_strings_detail {
+
+/******************************************************************************/
+
+/*!
+ * Loser tree which merges k sorted string runs, each given with its LCP array,
+ * into one sorted sequence with a correct LCP array.
+ *
+ * Each node stores the loser of its game together with the length of the
+ * longest common prefix of the loser and the winner which beat it. Since all
+ * candidates on the path of a replay share a known common prefix with the last
+ * output string, a game is decided by comparing the two stored LCPs, and only
+ * if they are equal the characters are compared, starting after the common
+ * prefix. This way, each character is inspected O(1) times per tree level
+ * instead of recomparing all strings from the first character, and the LCP of
+ * consecutive output strings falls out of the games for free.
+ *
+ * The runs' LCP arrays contain at position i the LCP of strings i-1 and i; the
+ * first entry is ignored. The strings are moved from the runs into the output.
+ * Equal strings are output in the order of the runs.
+ */
+template <typename StringSet_, typename LcpType_>
+class LcpStringLoserTree
+{
+public:
+    typedef StringSet_ StringSet;
+    typedef LcpType_ LcpType;
+    typedef typename StringSet::String String;
+    typedef typename StringSet::CharIterator CharIterator;
+    typedef StringLcpPtr<StringSet, LcpType> StringLcpPtrType;
+
+    //! construct a loser tree over the runs given by an iterator range of
+    //! StringLcpPtr objects.
+    template <typename Iterator>
+    LcpStringLoserTree(Iterator runs_begin, Iterator runs_end)
+        : runs_(runs_begin, runs_end) {
+        k_ = round_up_to_power_of_two(std::max<size_t>(runs_.size(), 1));
+        pos_.resize(k_, 0);
+        nodes_.resize(k_);
+        for (size_t i = 0; i < runs_.size(); ++i)
+            remaining_ += runs_[i].size();
+        nodes_[0] = init_node(1);
+    }
+
+    //! number of runs
+    size_t num_runs() const { return runs_.size(); }
+
+    //! number of strings not yet output
+    size_t size() const { return remaining_; }
+
+    //! returns true if all strings were output
+    bool empty() const { return remaining_ == 0; }
+
+    //! move the next out.size() merged strings into out, or fewer at the end
+    //! of the merge, and store their LCPs. out.lcp()[0] receives the LCP to
+    //! the string output last by the previous call, or zero. Returns the
+    //! number of strings written.
+    size_t write(const StringLcpPtrType& out) {
+        const StringSet& oss = out.active();
+        size_t n = 0;
+        for ( ; n < out.size() && remaining_ != 0; ++n) {
+            Node w = nodes_[0];
+            const StringLcpPtrType& run = runs_[w.source];
+            size_t& pos = pos_[w.source];
+
+            oss.at(n) = std::move(run.active().at(pos));
+            out.set_lcp(n, w.lcp);
+            --remaining_;
+
+            // the next string of the run has a known LCP with the output one
+            w.lcp = ++pos < run.size() ? run.get_lcp(pos) : 0;
+            replay(w);
+        }
+        return n;
+    }
+
+private:
+    //! a player: the source run of its string and the LCP with the winner
+    struct Node {
+        size_t source;
+        LcpType lcp;
+    };
+
+    //! the runs
+    std::vector<StringLcpPtrType> runs_;
+
+    //! number of leaves, a power of two
+    size_t k_;
+
+    //! current position in each run, padded to k_ entries
+    std::vector<size_t> pos_;
+
+    //! losers of the games, nodes_[0] is the overall winner
+    std::vector<Node> nodes_;
+
+    //! number of strings not yet output
+    size_t remaining_ = 0;
+
+    //! whether the run of the player is exhausted, or a padding leaf
+    bool is_done(size_t source) const {
+        return source >= runs_.size() || pos_[source] == runs_[source].size();
+    }
+
+    //! compare the head strings of runs a and b, which share the first h
+    //! characters. Returns true if a's string is smaller, or equal and a < b.
+    //! Sets h to the LCP of the two strings.
+    bool less_from(size_t a, size_t b, LcpType& h) const {
+        const StringSet& ssa = runs_[a].active();
+        const StringSet& ssb = runs_[b].active();
+        const String& sa = ssa.at(pos_[a]);
+        const String& sb = ssb.at(pos_[b]);
+
+        CharIterator ca = ssa.get_chars(sa, h);
+        CharIterator cb = ssb.get_chars(sb, h);
+        while (!ssa.is_end(sa, ca) && !ssb.is_end(sb, cb) && *ca == *cb)
+            ++ca, ++cb, ++h;
+
+        if (ssb.is_end(sb, cb))
+            return ssa.is_end(sa, ca) && a < b;
+        return ssa.is_end(sa, ca) || *ca < *cb;
+    }
+
+    //! play the winner w against the loser stored in node. Afterwards w is the
+    //! winner and the node holds the loser with its LCP relative to w.
+    void play(Node& w, Node& node) const {
+        if (is_done(node.source))
+            return;
+        if (is_done(w.source)) {
+            std::swap(w, node);
+            return;
+        }
+        // both share a prefix with the last output string; the one sharing
+        // the longer prefix is smaller, since both are not smaller than it.
+        if (node.lcp > w.lcp) {
+            std::swap(w, node);
+        }
+        else if (node.lcp == w.lcp) {
+            LcpType h = w.lcp;
+            if (less_from(node.source, w.source, h))
+                std::swap(w, node);
+            node.lcp = h;
+        }
+    }
+
+    //! play the initial games in the subtree of node, returns the winner
+    Node init_node(size_t node) {
+        if (node >= k_)
+            return Node { node - k_, 0 };
+        Node w = init_node(2 * node);
+        Node other = init_node(2 * node + 1);
+        play(w, other);
+        nodes_[node] = other;
+        return w;
+    }
+
+    //! replay the games from the leaf of w up to the root
+    void replay(Node w) {
+        for (size_t node = (k_ + w.source) / 2; node >= 1; node /= 2)
+            play(w, nodes_[node]);
+        nodes_[0] = w;
+    }
+};
+
+/******************************************************************************/
+
+/*!
+ * Merge the sorted string runs with LCP arrays given by an iterator range of
+ * StringLcpPtr objects into out, which must hold the total number of strings.
+ * The strings are moved from the runs, and out's LCP array is filled with the
+ * LCPs of consecutive output strings, with out.lcp()[0] set to zero. Returns
+ * the number of strings merged.
+ */
+template <typename Iterator, typename StringSet, typename LcpType>
+static inline
+size_t lcp_multiway_merge(Iterator runs_begin, Iterator runs_end,
+                          const StringLcpPtr<StringSet, LcpType>& out) {
+    LcpStringLoserTree<StringSet, LcpType> lt(runs_begin, runs_end);
+    assert(lt.size() <= out.size());
+    return lt.write(out);
+}
+
+/*!
+ * Merge num_runs sorted string runs, which are stored consecutively from begin
+ * with their LCP arrays, into out and out_lcp. Run i occupies positions
+ * [run_bounds[i], run_bounds[i + 1]). Returns the number of strings merged.
+ */
+template <typename StringSet, typename LcpType>
+static inline
+size_t lcp_multiway_merge_runs(
+    typename StringSet::Iterator begin, LcpType* lcp,
+    const size_t* run_bounds, size_t num_runs,
+    typename StringSet::Iterator out, LcpType* out_lcp) {
+    typedef StringLcpPtr<StringSet, LcpType> StringLcpPtrType;
+
+    std::vector<StringLcpPtrType> runs;
+    runs.reserve(num_runs);
+    for (size_t i = 0; i < num_runs; ++i) {
+        runs.emplace_back(
+            StringSet(begin + run_bounds[i], begin + run_bounds[i + 1]),
+            lcp + run_bounds[i]);
+    }
+    size_t size = run_bounds[num_runs] - run_bounds[0];
+    return lcp_multiway_merge(
+        runs.begin(), runs.end(),
+        StringLcpPtrType(StringSet(out, out + size), out_lcp));
+}
+
+/******************************************************************************/
+
+} // namespace sort_strings_detail
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_SORT_STRINGS_LCP_LOSER_TREE_HEADER
+
+/******************************************************************************/